@@ -35,6 +35,7 @@ OPTION(A_USE_OMP            "Use OpenMP  ?"
 OPTION(A_USE_OCL            "Use OpenCL for GPU computations ?"                    OFF)
 OPTION(A_USE_VTK            "Use VTK ?"                                            OFF)
 OPTION(A_USE_HDF5           "Use HDF5 ?"                                           ON )
+OPTION(A_USE_MPI            "Use MPI to split the LBM lattices among processes ?"  OFF)
 
 ADD_DEFINITIONS(-fmessage-length=0) # Each error message will appear on a single line; no line-wrapping will be done.
 #ADD_DEFINITIONS(-std=gnu++11)                   # New C++ standard
@@ -121,6 +122,9 @@ INCLUDE (FindOpenMP )                                       # 11
 if(A_USE_OCL)
 INCLUDE (FindOpenCL )                                       # 12
 endif(A_USE_OCL)
+if(A_USE_MPI)
+INCLUDE (FindMPI )                                          # 13
+endif(A_USE_MPI)
 
 # 1
 if(VTK_FOUND AND A_USE_VTK)
@@ -242,3 +246,16 @@ else(OpenCL_FOUND AND A_USE_OCL)
     endif(A_USE_OCL)
 endif(OpenCL_FOUND AND A_USE_OCL)
 
+# 13
+if(MPI_CXX_FOUND AND A_USE_MPI)
+    ADD_DEFINITIONS (-DUSE_MPI)
+    INCLUDE_DIRECTORIES (${MPI_CXX_INCLUDE_PATH})
+    SET (LIBS ${LIBS} ${MPI_CXX_LIBRARIES})
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${MPI_CXX_COMPILE_FLAGS}")
+    set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} ${MPI_CXX_LINK_FLAGS}")
+else(MPI_CXX_FOUND AND A_USE_MPI)
+    if(A_USE_MPI)
+        SET (MISSING "${MISSING} MPI")
+    endif(A_USE_MPI)
+endif(MPI_CXX_FOUND AND A_USE_MPI)
+
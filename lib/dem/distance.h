@@ -343,5 +343,99 @@ inline bool Overlap (Cylinder & C0, Vec3_t & V1, double R0, double R1)
     return (Overlap(V1,C0,R1,R0));
 }
 
+/// The following Distance and Overlap functions take the second feature displaced by S, its periodic image.
+/// The vertex (or an edge) is the feature displaced so faces, tori and cylinders are never copied.
+/// Xi and Xf are given in the frame of the first feature
+
+template<typename FeatureB_T>
+inline void Distance (Vec3_t const & V, FeatureB_T const & B, Vec3_t const & S, Vec3_t & Xi, Vec3_t & Xf)
+{
+    Vec3_t Vs = V-S;
+    Distance (Vs,B,Xi,Xf);
+    Xi += S;
+    Xf += S;
+}
+
+template<typename FeatureA_T>
+inline void Distance (FeatureA_T const & A, Vec3_t const & V, Vec3_t const & S, Vec3_t & Xi, Vec3_t & Xf)
+{
+    Vec3_t Vs = V+S;
+    Distance (A,Vs,Xi,Xf);
+}
+
+inline void Distance (Vec3_t const & V0, Vec3_t const & V1, Vec3_t const & S, Vec3_t & Xi, Vec3_t & Xf)
+{
+    Xi = V0;
+    Xf = V1+S;
+}
+
+inline void Distance (Edge const & E0, Edge const & E1, Vec3_t const & S, Vec3_t & Xi, Vec3_t & Xf)
+{
+    Vec3_t X0 = *E1.X0+S;
+    Vec3_t X1 = *E1.X1+S;
+    Edge   Es(E1);
+    Es.X0 = &X0;
+    Es.X1 = &X1;
+    Distance (E0,Es,Xi,Xf);
+}
+
+template<typename FeatureB_T>
+inline bool Overlap (Vec3_t & V0, FeatureB_T & F1, Vec3_t const & S, double R0, double R1)
+{
+    Vec3_t Vs = V0-S;
+    return (Overlap(Vs,F1,R0,R1));
+}
+
+template<typename FeatureA_T>
+inline bool Overlap (FeatureA_T & F0, Vec3_t & V1, Vec3_t const & S, double R0, double R1)
+{
+    Vec3_t Vs = V1+S;
+    return (Overlap(F0,Vs,R0,R1));
+}
+
+inline bool Overlap (Vec3_t & V0, Vec3_t & V1, Vec3_t const & S, double R0, double R1)
+{
+    return true;
+}
+
+inline bool Overlap (Edge & E0, Edge & E1, Vec3_t const & S, double R0, double R1)
+{
+    double dist = norm(0.5*(*E0.X0 + *E0.X1) - 0.5*(*E1.X0 + *E1.X1) - S);
+    return (dist < R0 + R1 + E0.Dmax + E1.Dmax);
+}
+
+/// The BoundingSphere functions give the centre C and radius R of the sphere enclosing a geometric feature,
+/// the same spheres used by the Overlap functions
+
+inline void BoundingSphere (Vec3_t & V, Vec3_t & C, double & R)
+{
+    C = V;
+    R = 0.0;
+}
+
+inline void BoundingSphere (Edge & E, Vec3_t & C, double & R)
+{
+    C = 0.5*(*E.X0 + *E.X1);
+    R = E.Dmax;
+}
+
+inline void BoundingSphere (Face & F, Vec3_t & C, double & R)
+{
+    F.Centroid(C);
+    R = F.Dmax;
+}
+
+inline void BoundingSphere (Torus & T, Vec3_t & C, double & R)
+{
+    C = *T.X0;
+    R = T.R;
+}
+
+inline void BoundingSphere (Cylinder & Cy, Vec3_t & C, double & R)
+{
+    C = 0.5*(*Cy.T0->X0 + *Cy.T1->X0);
+    R = Cy.Dmax;
+}
+
 }
 #endif // MECHSYS_DEM_DISTANCE_H
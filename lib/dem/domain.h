@@ -30,6 +30,7 @@
 #include <set>
 #include <list>
 #include <utility>
+#include <cstring> // for memcpy
 
 // Hdf5
 #ifdef USE_HDF5
@@ -60,6 +61,7 @@
 
 // MechSys
 #include <mechsys/dem/interacton.h>
+#include <mechsys/dem/spherepairs.h>
 #include <mechsys/util/array.h>
 #include <mechsys/util/util.h>
 #include <mechsys/util/numstreams.h>
@@ -67,6 +69,7 @@
 #include <mechsys/util/maps.h>
 #include <mechsys/util/stopwatch.h>
 #include <mechsys/util/tree.h>
+#include <mechsys/util/pairset.h>
 
 namespace DEM
 {
@@ -141,10 +144,24 @@ public:
     void Center            (Vec3_t C = Vec3_t(0.0,0.0,0.0));                                                    ///< Centers the domain around C
     void ClearInteractons  ();                                                                                  ///< Reset the interactons
     void ResetInteractons  ();                                                                                  ///< Reset the interactons
+    void CompactInteractons();                                                                                  ///< Drop the contact interactons whose particles are far apart and carry no friction history
     void ResetDisplacements();                                                                                  ///< Reset the displacements
     double MaxDisplacement ();                                                                                  ///< Calculate maximun displacement
     void ResetContacts     ();                                                                                  ///< Reset the displacements
-    void ResetBoundaries   ();                                                                                  ///< Reset the Boundary particles
+    void ResetBoundaries   ();                                                                                  ///< Bring the free particles that left the periodic box back in and update the image shifts of the interactons
+    bool Periodic          (size_t d, double & Lmin, double & Lmax) const;                                      ///< Is there a periodic boundary along the axis d? Lmin and Lmax are its limits
+    void ImageShift        (Particle * P1, Particle * P2, Vec3_t & S) const;                                    ///< Displacement taking P2 to its periodic image closest to P1, zero unless both are free
+#ifdef USE_OMP
+    void ResetLinkedCells  ();                                                                                  ///< Size the linked cells to the free particles, spanning the whole box along the periodic axes
+    double LCellSize       () const;                                                                            ///< Width of the linked cells, wide enough for the neighbour cells to hold every pair within reach
+    void CellOf            (Vec3_t const & X, iVec3_t & Pt);                                                    ///< Linked cell holding the position X
+    size_t NeighbourCells  (size_t Idx, size_t * Nb);                                                           ///< Linked cells around Idx, Idx included, wrapped through the periodic boundaries. Nb must hold 27 cells
+    void ReorderParticles  ();                                                                                  ///< Sort the particles along a Morton curve of their centres so neighbours get close indices
+    bool RefreshMovers     (double Skin);                                                                       ///< Re-bin and refresh the contacts of the particles that moved more than Skin only. False if a full rebuild is needed
+    void AddContactInteractons ();                                                                              ///< Create the contact interactons for the new pairs gathered in MTD[i].LC
+#endif
+    void UpdateForceLists  ();                                                                                  ///< Group the interacton forces by particle so they can be gathered without locks
+    void GatherForces      ();                                                                                  ///< Add the interacton forces and torques to the particles
     void EnergyOutput      (size_t IdxOut, std::ostream & OutFile);                                             ///< Output of the energy variables
     void GetGSD            (Array<double> & X, Array<double> & Y, Array<double> & D, size_t NDiv=10) const;     ///< Get the Grain Size Distribution
     void Clusters          ();                                                                                  ///< Check the bounded particles in the domain and how many connected clusters are still present
@@ -160,13 +177,16 @@ public:
     void   AngularMomentum (Vec3_t & L);                    ///< Return total angular momentum of the system
     double CalcEnergy      (double & Ekin, double & Epot);  ///< Return total energy of the system
 
+    Array<std::pair<size_t, size_t> >                 ListPosPairs;                ///< List of all possible particles pairs
+    Array<size_t>                                     FLOffset;                    ///< Start of the force list of each particle in FList (by Particle::Index)
+    Array<std::pair<Vec3_t*,Vec3_t*> >                FList;                       ///< Force and torque of each interacton end, grouped by particle
 #ifdef USE_OMP
     omp_lock_t                                        lck;                         ///< to protect variables in multithreading
-    Array<std::pair<size_t, size_t> >                 ListPosPairs;                ///< List of all possible particles pairs
     iVec3_t                                           LCellDim;                    ///< Dimensions of the linked cell array
     Array<Array <size_t> >                            LinkedCell;                  ///< Linked Cell array for optimization.
     Vec3_t                                            LCxmin;                      ///< Bounding box low   limit for the linked cell array
     Vec3_t                                            LCxmax;                      ///< Bounding box upper limit for the linked cell array
+    Array<size_t>                                     ParCell;                     ///< Linked cell holding each free particle
 #endif
 
     // Data
@@ -176,18 +196,10 @@ public:
     Array<size_t>                                     FreePar;                     ///< Particles that are free
     Array<size_t>                                     NoFreePar;                   ///< Particles that are not free
     Array<Particle*>                                  Particles;                   ///< All particles in domain
-    Array<Particle*>                                  ParXmax;                     ///< Particles that are on the Xmax boundary for periodic boudary conditions along the x direction
-    Array<Particle*>                                  ParYmax;                     ///< Particles that are on the Ymax boundary for periodic boudary conditions along the y direction
-    Array<Particle*>                                  ParXYmax;                    ///< Particles that are on the XYmax boundary for periodic boudary conditions along the y direction
     Array<Interacton*>                                Interactons;                 ///< All interactons
     Array<CInteracton*>                               CInteractons;                ///< Contact interactons
+    InteractonPool                                    CIPool;                      ///< Storage of the contact interactons in CInteractons
     Array<BInteracton*>                               BInteractons;                ///< Cohesion interactons
-    Array<Interacton*>                                PxInteractons;               ///< Interactons for periodic conditions along the x direction
-    Array<CInteracton*>                               CPxInteractons;              ///< Contact interacton for periodic conditions along x
-    Array<Interacton*>                                PyInteractons;               ///< Interactons for periodic conditions along the y direction
-    Array<CInteracton*>                               CPyInteractons;              ///< Contact interacton for periodic conditions along y
-    Array<Interacton*>                                PxyInteractons;              ///< Interactons for periodic conditions along the xy direction
-    Array<CInteracton*>                               CPxyInteractons;             ///< Contact interacton for periodic conditions along xy
     Vec3_t                                            CamPos;                      ///< Camera position for POV
     double                                            Time;                        ///< Current time
     double                                            Dt;                          ///< Time step
@@ -198,26 +210,33 @@ public:
     double                                            Ms;                          ///< Total mass of the particles
     double                                            Alpha;                       ///< Verlet distance
     double                                            Beta;                        ///< Binmultiplier
+    bool                                              Incremental;                 ///< Refresh only the particles that moved more than 2/3 of Alpha instead of rebuilding every contact list
+    bool                                              AutoAlpha;                   ///< Tune Alpha at each full rebuild from the measured cost of keeping the contact lists
+    size_t                                            ReorderEvery;                ///< Reorder the particles every ReorderEvery full rebuilds of the contact lists (0 to never reorder). Indices change, use Tag, Particle::Id or a pointer to the particle
+    size_t                                            Nrebuild;                    ///< Number of full rebuilds of the contact lists
+    size_t                                            Nrefresh;                    ///< Number of incremental refreshes of the contact lists
+    size_t                                            Nrefreshed;                  ///< Number of particles refreshed incrementally
+    double                                            Trebuild;                    ///< Wall time spent in full rebuilds
+    double                                            Trefresh;                    ///< Wall time spent in incremental refreshes
     double                                            Xmax;                        ///< Maximun distance along the X axis (Periodic Boundary)
     double                                            Xmin;                        ///< Minimun distance along the X axis (Periodic Boundary)
     double                                            Ymax;                        ///< Maximun distance along the Y axis (Periodic Boundary)
     double                                            Ymin;                        ///< Minimun distance along the Y axis (Periodic Boundary)
+    double                                            Zmax;                        ///< Maximun distance along the Z axis (Periodic Boundary)
+    double                                            Zmin;                        ///< Minimun distance along the Z axis (Periodic Boundary)
     double                                            MaxDmax;                     ///< Maximun value for the radious of the spheres surronding each particle
     void *                                            UserData;                    ///< Some user data
     String                                            FileKey;                     ///< File Key for output files
     size_t                                            Nproc;                       ///< Number of cores for multithreading
     size_t                                            idx_out;                     ///< Index of output
-    std::set<std::pair<Particle *, Particle *> >      Listofpairs;                 ///< List of pair of particles associated per interacton for memory optimization
-    std::set<std::pair<Particle *, Particle *> >      PxListofpairs;               ///< List of pair of particles associated per interacton for memory optimization under periodic boundary conditions
-    std::set<std::pair<Particle *, Particle *> >      PyListofpairs;               ///< List of pair of particles associated per interacton for memory optimization under periodic boundary conditions
-    std::set<std::pair<Particle *, Particle *> >      PxyListofpairs;              ///< List of pair of particles associated per interacton for memory optimization under periodic boundary conditions
+    Util::PairSet                                     Listofpairs;                 ///< Index pairs of the particles that already have an interacton
     Array<Array <int> >                               Listofclusters;              ///< List of particles belonging to bounded clusters (applies only for cohesion simulations)
     MtData *                                          MTD;                         ///< Multithread data
 
     // Some utilities when the interactions are mainly between spheres
     bool                                              MostlySpheres;               ///< If the simulation is mainly between spheres this should be true
-    FrictionMap_t                                     FricSpheres;                 ///< The friction value for spheres only
-    FrictionMap_t                                     RollSpheres;                 ///< Map storing the rolling resistance between spheres
+    SpherePairs                                       SPairs;                      ///< Sphere pairs within reach and their friction and rolling history
+    void     UpdateSpherePairs();                                                  ///< Rebuild SPairs from the list of possible pairs
     void     CalcForceSphere();                                                    ///< Calculate force between only spheres spheres
     
 };
@@ -234,9 +253,6 @@ struct MtData   /// A structure for the multi-thread data
     Array<std::pair<size_t,size_t> >   LC; ///< A temporal list of new contacts
     Array<size_t>                     LCI; ///< A temporal array of posible Cinteractions
     Array<size_t>                     LCB; ///< A temporal array of posible Binteractions
-    Array<std::pair<size_t,size_t> >  LPC; ///< A temporal list of new contacts for periodic boundary conditions
-    Array<size_t>                    LPCI; ///< A temporal array of posible Cinteractions for periodic boundary conditions
-    Array<size_t>                     LBP; ///< A temporal array of possible boundary particles
     Array<std::pair<iVec3_t,size_t> > LLC; ///< A temporal array of possible linked cells locations
     Array<std::pair<size_t,size_t> >  LPP; ///< A temporal array of possible partcle types
 };
@@ -247,7 +263,12 @@ inline Domain::Domain (void * UD)
     :  Initialized(false), Dilate(false), Time(0.0), Alpha(0.05), Beta(1.0), UserData(UD)
 {
     MostlySpheres = false;
-    Xmax = Xmin = Ymax = Ymin = 0.0;
+    Incremental   = false;
+    AutoAlpha     = false;
+    ReorderEvery  = 0;
+    Nrebuild = Nrefresh = Nrefreshed = 0;
+    Trebuild = Trefresh = 0.0;
+    Xmax = Xmin = Ymax = Ymin = Zmax = Zmin = 0.0;
     CamPos = 1.0, 2.0, 3.0;
 #ifdef USE_OMP
     omp_init_lock(&lck);
@@ -257,7 +278,7 @@ inline Domain::Domain (void * UD)
 inline Domain::~Domain ()
 {
     for (size_t i=0; i<Particles.Size();   ++i) if (Particles  [i]!=NULL) delete Particles  [i];
-    for (size_t i=0; i<Interactons.Size(); ++i) if (Interactons[i]!=NULL) delete Interactons[i];
+    ClearInteractons();
 }
 
 //All the methods for particle generation
@@ -408,8 +429,12 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
     double MaxBn   =  0.0;
     double MinDmax = -1.0;
     double MinMass = -1.0;
+    int NextId = 0;
+    for (size_t i=0; i<Particles.Size(); i++) NextId = std::max(NextId,Particles[i]->Id+1);
     for (size_t i=0; i<Particles.Size(); i++) 
     { 
+        Particles[i]->Index = i; // the pair sets are keyed by these indices
+        if (Particles[i]->Id<0) Particles[i]->Id = NextId++;
         if (Particles[i]->IsFree())
         {
             Vs += Particles[i]->Props.V;
@@ -443,6 +468,8 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
     printf("%s  Periodic Boundary conditions in X between =  %g and %g%s\n" ,TERM_CLR5, Xmin, Xmax                           , TERM_RST);
     if (fabs(Ymax-Ymin)>1.0e-12)
     printf("%s  Periodic Boundary conditions in Y between =  %g and %g%s\n" ,TERM_CLR5, Ymin, Ymax                           , TERM_RST);
+    if (fabs(Zmax-Zmin)>1.0e-12)
+    printf("%s  Periodic Boundary conditions in Z between =  %g and %g%s\n" ,TERM_CLR5, Zmin, Zmax                           , TERM_RST);
 
     if (Alpha > Beta*MaxDmax)
     {
@@ -473,16 +500,20 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
     //{
         //ListPosPairs.Push(std::make_pair(i,j));
     //}
-    LinkedCell.Resize(0);
-    BoundingBox(LCxmin,LCxmax);
-    LCellDim = (LCxmax - LCxmin)/(2.0*Beta*MaxDmax) + iVec3_t(1,1,1);
-    //LCellDim = (LCxmax - LCxmin)/(2.0*Beta*MaxDmax);
-    LinkedCell.Resize(LCellDim(0)*LCellDim(1)*LCellDim(2));
+#ifdef USE_OMP
+    //ReorderParticles
+    if (ReorderEvery>0) ReorderParticles();
+
+    //ResetBoundaries
+    ResetBoundaries();
+
+    //ResetLinkedCells
+    ResetLinkedCells();
     //std::cout << LCellDim << " " << MaxDmax << std::endl;
     //iVec3_t iv;
     //idx2Pt(16,iv,LCellDim);
     //std::cout << iv << std::endl;
-#ifdef USE_OMP
+
     //std::cout << "2 " << CInteractons.Size() << std::endl;
     //ResetDisplacements
     ResetDisplacements();
@@ -496,15 +527,29 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
     //ResetContacts
     ResetContacts();
 #else
+    // the refreshes, the tuning of Alpha and the reordering work on the linked cells
+    if (Incremental||AutoAlpha||ReorderEvery>0) throw new Fatal("Domain::Solve: Incremental, AutoAlpha and ReorderEvery need the linked cells of the OpenMP build (USE_OMP)");
+
+    // bring the free particles back into the periodic box
+    ResetBoundaries();
 
     // set the displacement of the particles to zero (for the Halo)
     ResetDisplacements();
 
     // build the map of possible contacts (for the Halo)
     ResetContacts();
-    if (fabs(Xmax-Xmin)>Alpha) ResetBoundaries();
-    if (fabs(Ymax-Ymin)>Alpha) ResetBoundaries();
 
+#endif
+
+    Nrebuild = Nrefresh = Nrefreshed = 0;
+    Trebuild = Trefresh = 0.0;
+#ifdef USE_OMP
+    // cost of the forces and of keeping the contact lists since the last tuning of Alpha
+    double Tforce = 0.0;
+    double Tlist  = 0.0;
+    size_t Nsteps = 0;
+    double Tlast  = 0.0; // cost of the last full rebuild
+    double Tsince = 0.0; // cost of the refreshes done after it
 #endif
 
     // run
@@ -551,6 +596,7 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
 
         //Calculate forces
         //std::cout << Interactons.Size() << " 2" << std::endl;
+        double tforce = omp_get_wtime();
         #pragma omp parallel for schedule(static) num_threads(Nproc)
         for (size_t i=0; i<Interactons.Size(); i++)
         {
@@ -563,121 +609,14 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
                 sleep(1);
                 throw new Fatal("Maximun overlap detected between particles");
             }
-            omp_set_lock  (&Interactons[i]->P1->lck);
-            Interactons[i]->P1->F += Interactons[i]->F1;
-            Interactons[i]->P1->T += Interactons[i]->T1;
-            omp_unset_lock(&Interactons[i]->P1->lck);
-            omp_set_lock  (&Interactons[i]->P2->lck);
-            Interactons[i]->P2->F += Interactons[i]->F2;
-            Interactons[i]->P2->T += Interactons[i]->T2;
-            omp_unset_lock(&Interactons[i]->P2->lck);
         }
 
         if(MostlySpheres) CalcForceSphere();
-        // Periodic Boundary
-        //std::cout << "3" << std::endl;
-        if (Xmax-Xmin>Alpha)
-        {
-            Vec3_t v(Xmin-Xmax,0.0,0.0);
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<ParXmax.Size(); i++) ParXmax[i]->Translate(v);
-
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<PxInteractons.Size(); i++)
-            {
-		        if (PxInteractons[i]->CalcForce(Dt))
-                {
-                    String f_error(FileKey+"_error");
-                    Save     (f_error.CStr());
-                    WriteXDMF(f_error.CStr());
-                    std::cout << "Maximun overlap detected between particles at the periodic X boundary at time " << Time << std::endl;
-                    std::cout << ParYmax.Has(PxInteractons[i]->P1) << std::endl;
-                    std::cout << ParYmax.Has(PxInteractons[i]->P2) << std::endl;
-                    std::cout << ParXmax.Has(PxInteractons[i]->P1) << std::endl;
-                    std::cout << ParXmax.Has(PxInteractons[i]->P2) << std::endl;
-                    sleep(1);
-                    throw new Fatal("Maximun overlap detected between particles");
-                }
-                omp_set_lock  (&PxInteractons[i]->P1->lck);
-                PxInteractons[i]->P1->F += PxInteractons[i]->F1;
-                PxInteractons[i]->P1->T += PxInteractons[i]->T1;
-                omp_unset_lock(&PxInteractons[i]->P1->lck);
-                omp_set_lock  (&PxInteractons[i]->P2->lck);
-                PxInteractons[i]->P2->F += PxInteractons[i]->F2;
-                PxInteractons[i]->P2->T += PxInteractons[i]->T2;
-                omp_unset_lock(&PxInteractons[i]->P2->lck);
-            }
-
-            v = Vec3_t(Xmax-Xmin,0.0,0.0);
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<ParXmax.Size(); i++) ParXmax[i]->Translate(v);
-        }
-        
-        if (Ymax-Ymin>Alpha)
-        {
-            Vec3_t v(0.0,Ymin-Ymax,0.0);
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<ParYmax.Size(); i++) ParYmax[i]->Translate(v);
-
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<PyInteractons.Size(); i++)
-            {
-		        if (PyInteractons[i]->CalcForce(Dt))
-                {
-                    String f_error(FileKey+"_error");
-                    Save     (f_error.CStr());
-                    WriteXDMF(f_error.CStr());
-                    std::cout << "Maximun overlap detected between particles at the periodic Y boundary at time " << Time << std::endl;
-                    sleep(1);
-                    throw new Fatal("Maximun overlap detected between particles");
-                }
-                omp_set_lock  (&PyInteractons[i]->P1->lck);
-                PyInteractons[i]->P1->F += PyInteractons[i]->F1;
-                PyInteractons[i]->P1->T += PyInteractons[i]->T1;
-                omp_unset_lock(&PyInteractons[i]->P1->lck);
-                omp_set_lock  (&PyInteractons[i]->P2->lck);
-                PyInteractons[i]->P2->F += PyInteractons[i]->F2;
-                PyInteractons[i]->P2->T += PyInteractons[i]->T2;
-                omp_unset_lock(&PyInteractons[i]->P2->lck);
-            }
-
-            v = Vec3_t(0.0,Ymax-Ymin,0.0);
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<ParYmax.Size(); i++) ParYmax[i]->Translate(v);
-        }
-        
-        if ((Ymax-Ymin>Alpha)&&(Xmax-Xmin>Alpha))
-        {
-            Vec3_t v(Xmin-Xmax,Ymin-Ymax,0.0);
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<ParXYmax.Size(); i++) ParXYmax[i]->Translate(v);
-
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<PxyInteractons.Size(); i++)
-            {
-		        if (PxyInteractons[i]->CalcForce(Dt))
-                {
-                    String f_error(FileKey+"_error");
-                    Save     (f_error.CStr());
-                    WriteXDMF(f_error.CStr());
-                    std::cout << "Maximun overlap detected between particles at the periodic XY boundary at time " << Time << std::endl;
-                    sleep(1);
-                    throw new Fatal("Maximun overlap detected between particles");
-                }
-                omp_set_lock  (&PxyInteractons[i]->P1->lck);
-                PxyInteractons[i]->P1->F += PxyInteractons[i]->F1;
-                PxyInteractons[i]->P1->T += PxyInteractons[i]->T1;
-                omp_unset_lock(&PxyInteractons[i]->P1->lck);
-                omp_set_lock  (&PxyInteractons[i]->P2->lck);
-                PxyInteractons[i]->P2->F += PxyInteractons[i]->F2;
-                PxyInteractons[i]->P2->T += PxyInteractons[i]->T2;
-                omp_unset_lock(&PxyInteractons[i]->P2->lck);
-            }
+        // Add the forces of the interactons to the particles
+        GatherForces();
+        Tforce += omp_get_wtime()-tforce;
+        Nsteps++;
 
-            v = Vec3_t(Xmax-Xmin,Ymax-Ymin,0.0);
-            #pragma omp parallel for schedule(static) num_threads(Nproc)
-            for (size_t i=0; i<ParXYmax.Size(); i++) ParXYmax[i]->Translate(v);
-        }
         // tell the user function to update its data
         //std::cout << "4" << std::endl;
         if (ptSetup!=NULL) (*ptSetup) ((*this), UserData);
@@ -709,23 +648,57 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
 
         //Update Linked Cells
         //std::cout << "6" << std::endl;
-        if (maxdis>Alpha)
-        {
-            //std::cout << "A" <<  std::endl;
-            LinkedCell.Resize(0);
-            BoundingBox(LCxmin,LCxmax);
-            LCellDim = (LCxmax - LCxmin)/(2.0*Beta*MaxDmax) + iVec3_t(1,1,1);
-            //LCellDim = (LCxmax - LCxmin)/(2.0*Beta*MaxDmax);
-            LinkedCell.Resize(LCellDim(0)*LCellDim(1)*LCellDim(2));
-
-            //ResetDisplacements
-            ResetDisplacements();
+        // In incremental mode a particle and its partners may each have been refreshed at different times,
+        // so the lists stay valid only while every particle moves less than 2/3 of Alpha from its last refresh
+        double skin = Incremental ? 2.0*Alpha/3.0 : Alpha;
+        if (maxdis>skin)
+        {
+            double tlist = omp_get_wtime();
+            // Once the refreshes have cost as much as a rebuild, a rebuild is cheaper again and drops the stale interactons
+            if (Incremental&&Tsince<Tlast&&RefreshMovers(skin))
+            {
+                Nrefresh++;
+                Trefresh += omp_get_wtime()-tlist;
+                Tsince   += omp_get_wtime()-tlist;
+            }
+            else
+            {
+                // Widen the skin if keeping the lists costs too much compared to the forces, shrink it if it is cheap
+                if (AutoAlpha&&Nsteps>0)
+                {
+                    double Rlist  = Tlist /Nsteps;
+                    double Rforce = Tforce/Nsteps;
+                    if      (Rlist>0.5*Rforce) Alpha = std::min(1.2*Alpha,Beta*MaxDmax);
+                    else if (Rlist<0.1*Rforce) Alpha = std::max(Alpha/1.2,0.05*MinDmax);
+                    Tlist  = 0.0;
+                    Tforce = 0.0;
+                    Nsteps = 0;
+                }
 
-            //UpdateLinkedCells
-            UpdateLinkedCells();
+                //ReorderParticles
+                if (ReorderEvery>0&&Nrebuild%ReorderEvery==0) ReorderParticles();
 
-            //ResetContacts
-            ResetContacts();
+                //std::cout << "A" <<  std::endl;
+                //ResetBoundaries
+                ResetBoundaries();
+
+                //ResetLinkedCells
+                ResetLinkedCells();
+
+                //ResetDisplacements
+                ResetDisplacements();
+
+                //UpdateLinkedCells
+                UpdateLinkedCells();
+
+                //ResetContacts
+                ResetContacts();
+                Nrebuild++;
+                Tlast     = omp_get_wtime()-tlist;
+                Tsince    = 0.0;
+                Trebuild += Tlast;
+            }
+            Tlist += omp_get_wtime()-tlist;
         }
 
 #else 
@@ -743,28 +716,20 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
             Wext += dot(Particles[i]->Ff,Particles[i]->v)*Dt;
         }
 
-        // calc contact forces: collision and bonding (cohesion)
+        // calc contact forces: collision and bonding (cohesion), the interactons shift the periodic images themselves
         for (size_t i=0; i<Interactons.Size(); i++)
         {
-            Interactons[i]->CalcForce (Dt);
-        }
-
-        if (fabs(Xmax-Xmin)>Alpha)
-        {
-            Vec3_t vmax(Xmin-Xmax,0.0,0.0);
-            Vec3_t vmin(Xmax-Xmin,0.0,0.0);
-            //for (size_t i=0;i<ParXmin.Size();i++) ParXmin[i]->Translate(vmin);
-            for (size_t i=0;i<ParXmax.Size();i++) ParXmax[i]->Translate(vmax);
-
-            for (size_t i=0; i<PInteractons.Size(); i++)
-            {   
-                Interacton * PI = PInteractons[i];
-                PI->CalcForce(Dt);
+            if (Interactons[i]->CalcForce(Dt))
+            {
+                String f_error(FileKey+"_error");
+                Save     (f_error.CStr());
+                WriteXDMF(f_error.CStr());
+                std::cout << "Maximun overlap detected between particles at time " << Time << std::endl;
+                throw new Fatal("Maximun overlap detected between particles");
             }
-
-            //for (size_t i=0;i<ParXmin.Size();i++) ParXmin[i]->Translate(vmax);
-            for (size_t i=0;i<ParXmax.Size();i++) ParXmax[i]->Translate(vmin);
         }
+        if(MostlySpheres) CalcForceSphere();
+        GatherForces();
 
         // calculate the collision energy
         for (size_t i=0; i<CInteractons.Size(); i++)
@@ -788,9 +753,10 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
         // update the Halos
         if (maxdis>Alpha)
         {
+            ResetBoundaries();
             ResetDisplacements();
             ResetContacts();
-            if (fabs(Xmax-Xmin)>Alpha) ResetBoundaries();
+            Nrebuild++;
         }
 #endif
         
@@ -819,6 +785,15 @@ inline void Domain::Solve (double tf, double dt, double dtOut, ptFun_t ptSetup,
     printf("%s  Kinematic energy   = %g%s\n",TERM_CLR4, Ekin, TERM_RST);
     printf("%s  Potential energy   = %g%s\n",TERM_CLR4, Epot, TERM_RST);
     printf("%s  Total energy       = %g%s\n",TERM_CLR2, Etot, TERM_RST);
+#ifdef USE_OMP
+    printf("%s  List rebuilds      = %zd (%g s)%s\n",TERM_CLR4, Nrebuild, Trebuild, TERM_RST);
+    if (Incremental)
+    printf("%s  List refreshes     = %zd for %zd particles (%g s)%s\n",TERM_CLR4, Nrefresh, Nrefreshed, Trefresh, TERM_RST);
+    if (AutoAlpha)
+    printf("%s  Verlet distance    = %g%s\n",TERM_CLR4, Alpha, TERM_RST);
+#else
+    printf("%s  List rebuilds      = %zd%s\n",TERM_CLR4, Nrebuild, TERM_RST);
+#endif
 }
 
 inline void Domain::WritePOV (char const * FileKey)
@@ -1259,6 +1234,7 @@ inline void Domain::WriteXDMF (char const * FileKey)
     float * Velvec = new float[3*Particles.Size()];
     float * Omevec = new float[3*Particles.Size()];
     int   * Tag    = new int  [  Particles.Size()];
+    int   * Id     = new int  [  Particles.Size()];
     for (size_t i=0;i<Particles.Size();i++)
     {
         Vec3_t Ome;
@@ -1274,6 +1250,7 @@ inline void Domain::WriteXDMF (char const * FileKey)
         Omevec[3*i+1] = float(Ome(1)); 
         Omevec[3*i+2] = float(Ome(2)); 
         Tag   [i]     = int  (Particles[i]->Tag);  
+        Id    [i]     = int  (Particles[i]->Id);
     }
 
     hsize_t dims[1];
@@ -1290,6 +1267,8 @@ inline void Domain::WriteXDMF (char const * FileKey)
     H5LTmake_dataset_float(file_id,dsname.CStr(),1,dims,Radius);
     dsname.Printf("PTag");
     H5LTmake_dataset_int  (file_id,dsname.CStr(),1,dims,Tag   );
+    dsname.Printf("PId");
+    H5LTmake_dataset_int  (file_id,dsname.CStr(),1,dims,Id    );
 
 
     delete [] Radius;
@@ -1297,6 +1276,7 @@ inline void Domain::WriteXDMF (char const * FileKey)
     delete [] Velvec;
     delete [] Omevec;
     delete [] Tag;
+    delete [] Id;
 
 
     //Closing the file
@@ -1362,6 +1342,11 @@ inline void Domain::WriteXDMF (char const * FileKey)
     oss << "        " << fn.CStr() <<":/PTag \n";
     oss << "       </DataItem>\n";
     oss << "     </Attribute>\n";
+    oss << "     <Attribute Name=\"Id\" AttributeType=\"Scalar\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << Particles.Size() << "\" NumberType=\"Int\" Format=\"HDF\">\n";
+    oss << "        " << fn.CStr() <<":/PId \n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
     oss << "     <Attribute Name=\"Velocity\" AttributeType=\"Vector\" Center=\"Node\">\n";
     oss << "       <DataItem Dimensions=\"" << Particles.Size() << " 3\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
     oss << "        " << fn.CStr() <<":/PVelocity\n";
@@ -1624,6 +1609,8 @@ inline void Domain::Save (char const * FileKey)
         int datint[1];
         datint[0] = Particles[i]->Index;
         H5LTmake_dataset_int(group_id,"Index",1,dims,datint);
+        datint[0] = Particles[i]->Id;
+        H5LTmake_dataset_int(group_id,"Id",1,dims,datint);
 
 
         int tag[1];
@@ -1892,6 +1879,11 @@ inline void Domain::Load (char const * FileKey)
         H5LTread_dataset_int(group_id,"Index",datint);
         //Particles[Particles.Size()-1]->Index = datint[0];
         Particles[Particles.Size()-1]->Index = Particles.Size()-1;
+        if (H5LTfind_dataset(group_id,"Id"))
+        {
+            H5LTread_dataset_int(group_id,"Id",datint);
+            Particles[Particles.Size()-1]->Id = datint[0];
+        }
         int tag[1];
         H5LTread_dataset_int(group_id,"Tag",tag);
         Particles[Particles.Size()-1]->Tag = tag[0];
@@ -2015,20 +2007,55 @@ inline void Domain::UpdateLinkedCells()
     {
         MTD[i].LPP.Resize(0);
     }
-    #pragma omp parallel for schedule(static) num_threads(Nproc)
-    for (size_t i=0;i<FreePar.Size()  ;i++)
+    // Fixed particles are not in the linked cells. Each one visits only the cells
+    // overlapping its bounding box, enlarged by the largest reach of a free particle
+    #pragma omp parallel for schedule(dynamic) num_threads(Nproc)
     for (size_t j=0;j<NoFreePar.Size();j++)
     {
-        size_t i1 = std::min(FreePar[i],NoFreePar[j]);
-        size_t i2 = std::max(FreePar[i],NoFreePar[j]);
-        MTD[omp_get_thread_num()].LPP.Push(std::make_pair(i1,i2));
+        Particle * Pa    = Particles[NoFreePar[j]];
+        double     reach = MaxDmax + 2.0*Alpha;
+        double     lc    = LCellSize();
+        Vec3_t     xmin(Pa->MinX()-reach,Pa->MinY()-reach,Pa->MinZ()-reach);
+        Vec3_t     xmax(Pa->MaxX()+reach,Pa->MaxY()+reach,Pa->MaxZ()+reach);
+        // Tori, and the cylinders between them, reach beyond the vertices
+        for (size_t t=0;t<Pa->Tori.Size();t++)
+        {
+            double rt = Pa->Tori[t]->R + Pa->Props.R + reach;
+            for (size_t d=0;d<3;d++)
+            {
+                xmin(d) = std::min(xmin(d),(*Pa->Tori[t]->X0)(d)-rt);
+                xmax(d) = std::max(xmax(d),(*Pa->Tori[t]->X0)(d)+rt);
+            }
+        }
+        iVec3_t    imin,imax;
+        bool       inside = true;
+        for (size_t d=0;d<3;d++)
+        {
+            double a = floor((xmin(d)-LCxmin(d))/lc);
+            double b = floor((xmax(d)-LCxmin(d))/lc);
+            if (b<0.0||a>LCellDim(d)-1.0) inside = false;
+            imin(d) = a<0.0 ? 0 : (size_t)a;
+            imax(d) = std::min((size_t)std::max(b,0.0),LCellDim(d)-1);
+        }
+        if (!inside) continue;
+        for (size_t knb=imin(2);knb<=imax(2);knb++)
+        for (size_t jnb=imin(1);jnb<=imax(1);jnb++)
+        for (size_t inb=imin(0);inb<=imax(0);inb++)
+        {
+            iVec3_t Ptnb(inb,jnb,knb);
+            size_t idxnb = Pt2idx(Ptnb,LCellDim);
+            for (size_t m=0;m<LinkedCell[idxnb].Size();m++)
+            {
+                size_t i1 = std::min(LinkedCell[idxnb][m],NoFreePar[j]);
+                size_t i2 = std::max(LinkedCell[idxnb][m],NoFreePar[j]);
+                MTD[omp_get_thread_num()].LPP.Push(std::make_pair(i1,i2));
+            }
+        }
     }
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     for (size_t idx=0;idx<LinkedCell.Size();idx++)
     {
         if (LinkedCell[idx].Size()==0) continue;
-        iVec3_t index;
-        idx2Pt(idx,index,LCellDim);
         //std::cout << index << " " << LinkedCell[idx].Size() << " ";
         for (size_t n=0  ;n<LinkedCell[idx].Size()-1;n++)
         {
@@ -2042,15 +2069,11 @@ inline void Domain::UpdateLinkedCells()
             }
         }
         //std::cout << std::endl;
-        size_t i = index(0);
-        size_t j = index(1);
-        size_t k = index(2);
-        for (size_t knb=std::max(0,int(k)-1);knb<=std::min(LCellDim(2)-1,k+1);knb++)
-        for (size_t jnb=std::max(0,int(j)-1);jnb<=std::min(LCellDim(1)-1,j+1);jnb++)
-        for (size_t inb=std::max(0,int(i)-1);inb<=std::min(LCellDim(0)-1,i+1);inb++)
+        size_t Nb[27];
+        size_t Nnb = NeighbourCells(idx,Nb);
+        for (size_t nb=0;nb<Nnb;nb++)
         {
-            iVec3_t Ptnb(inb,jnb,knb);
-            size_t idxnb = Pt2idx(Ptnb,LCellDim);
+            size_t idxnb = Nb[nb];
             if (idxnb>idx)
             {
                 for (size_t n=0;n<LinkedCell[idx].Size()  ;n++)
@@ -2083,6 +2106,86 @@ inline void Domain::UpdateLinkedCells()
     }
 }
 
+inline void Domain::ResetLinkedCells()
+{
+    double lc = LCellSize();
+    LinkedCell.Resize(0);
+    BoundingBox(LCxmin,LCxmax);
+    LCellDim = (LCxmax - LCxmin)/lc + iVec3_t(1,1,1);
+
+    // Along a periodic axis the cells tile the box, the last one taking the remainder. The closest
+    // image of a particle is the only one it can touch as long as the box is twice its reach
+    for (size_t d=0;d<3;d++)
+    {
+        double Lmin,Lmax;
+        if (!Periodic(d,Lmin,Lmax)) continue;
+        if (Lmax-Lmin<4.0*(MaxDmax+Alpha)) throw new Fatal("Domain::ResetLinkedCells: The periodic box along the axis %zd must be at least %g long",d,4.0*(MaxDmax+Alpha));
+        LCxmin(d)   = Lmin;
+        LCxmax(d)   = Lmax;
+        LCellDim(d) = std::max(1.0,floor((Lmax-Lmin)/lc));
+    }
+    LinkedCell.Resize(LCellDim(0)*LCellDim(1)*LCellDim(2));
+}
+
+inline double Domain::LCellSize() const
+{
+    // Pairs are searched in the adjacent cells only, so a tuned Alpha, which may grow up to
+    // Beta*MaxDmax, needs cells spanning the reach 2*MaxDmax+2*Alpha of a pair. A hand set
+    // Alpha keeps the usual cells of 2*Beta*MaxDmax
+    if (AutoAlpha) return std::max(2.0*Beta*MaxDmax,2.0*MaxDmax+2.0*Alpha);
+    return 2.0*Beta*MaxDmax;
+}
+
+inline void Domain::CellOf(Vec3_t const & X, iVec3_t & Pt)
+{
+    double lc = LCellSize();
+    for (size_t d=0;d<3;d++)
+    {
+        double a = floor((X(d)-LCxmin(d))/lc);
+        Pt(d) = a<0.0 ? 0 : std::min((size_t)a,LCellDim(d)-1);
+    }
+}
+
+inline size_t Domain::NeighbourCells(size_t Idx, size_t * Nb)
+{
+    iVec3_t index;
+    idx2Pt(Idx,index,LCellDim);
+    bool per[3];
+    for (size_t d=0;d<3;d++)
+    {
+        double Lmin,Lmax;
+        per[d] = Periodic(d,Lmin,Lmax);
+    }
+
+    // With less than three cells along a periodic axis the wrapped neighbours repeat, keep each one once
+    size_t n = 0;
+    for (int knb=-1;knb<=1;knb++)
+    for (int jnb=-1;jnb<=1;jnb++)
+    for (int inb=-1;inb<=1;inb++)
+    {
+        int     off[3] = {inb,jnb,knb};
+        iVec3_t Ptnb;
+        bool    valid  = true;
+        for (size_t d=0;d<3;d++)
+        {
+            int N = LCellDim(d);
+            int c = int(index(d))+off[d];
+            if (c<0||c>=N)
+            {
+                if (!per[d]) valid = false;
+                c = (c+N)%N;
+            }
+            Ptnb(d) = c;
+        }
+        if (!valid) continue;
+        size_t idxnb = Pt2idx(Ptnb,LCellDim);
+        bool   seen  = false;
+        for (size_t m=0;m<n;m++) if (Nb[m]==idxnb) seen = true;
+        if (!seen) Nb[n++] = idxnb;
+    }
+    return n;
+}
+
 #endif
 
 inline void Domain::BoundingBox(Vec3_t & minX, Vec3_t & maxX)
@@ -2115,7 +2218,7 @@ inline void Domain::ClearInteractons()
     // delete old interactors
     for (size_t i=0; i<CInteractons.Size(); ++i)
     {
-        if (CInteractons[i]!=NULL) delete CInteractons[i];
+        if (CInteractons[i]!=NULL) CIPool.Delete(CInteractons[i]);
     }
     CInteractons.Resize(0);
     for (size_t i=0; i<BInteractons.Size(); ++i)
@@ -2124,22 +2227,7 @@ inline void Domain::ClearInteractons()
     }
     BInteractons.Resize(0);
     Interactons.Resize(0);
-    Listofpairs.clear();
-
-    for (size_t i=0; i<CPxInteractons.Size(); ++i)
-    {
-        if (CPxInteractons[i]!=NULL) delete CPxInteractons[i];
-    }
-    CPxInteractons.Resize(0);
-    PxInteractons.Resize(0);
-    PxListofpairs.clear();
-    for (size_t i=0; i<CPyInteractons.Size(); ++i)
-    {
-        if (CPyInteractons[i]!=NULL) delete CPyInteractons[i];
-    }
-    CPyInteractons.Resize(0);
-    PyInteractons.Resize(0);
-    PyListofpairs.clear();
+    Listofpairs.Clear();
 }
 
 inline void Domain::ResetInteractons()
@@ -2147,7 +2235,7 @@ inline void Domain::ResetInteractons()
     // delete old interactors
     for (size_t i=0; i<CInteractons.Size(); ++i)
     {
-        if (CInteractons[i]!=NULL) delete CInteractons[i];
+        if (CInteractons[i]!=NULL) CIPool.Delete(CInteractons[i]);
     }
 
     // new interactors
@@ -2163,18 +2251,18 @@ inline void Domain::ResetInteractons()
             // if both particles have any component specified or they are far away, don't create any intereactor
             bool close = (Distance(Particles[i]->x,Particles[j]->x)<=Particles[i]->Dmax+Particles[j]->Dmax+2*Alpha);
             if ((pi_has_vf && pj_has_vf) || !close ) continue;
-            Listofpairs.insert(std::make_pair(Particles[i],Particles[j]));
+            Listofpairs.Insert(i,j);
 
             // if both particles are spheres (just one vertex)
             if (Particles[i]->Verts.Size()==1 && Particles[j]->Verts.Size()==1)
             {
-                CInteractons.Push (new CInteractonSphere(Particles[i],Particles[j]));
+                CInteractons.Push (CIPool.New<CInteractonSphere>(Particles[i],Particles[j]));
             }
 
             // normal particles
             else
             {
-                CInteractons.Push (new CInteracton(Particles[i],Particles[j]));
+                CInteractons.Push (CIPool.New<CInteracton>(Particles[i],Particles[j]));
             }
         }
     }
@@ -2195,16 +2283,19 @@ inline void Domain::ResetDisplacements()
         Particles[i]->ResetDisplacements();
         if(Particles[i]->IsFree())
         {
-            iVec3_t idx = (Particles[i]->x - LCxmin)/(2.0*Beta*MaxDmax);
+            iVec3_t idx;
+            CellOf(Particles[i]->x,idx);
             MTD[omp_get_thread_num()].LLC.Push(std::make_pair(idx,i));
         }
     }
+    ParCell.Resize(Particles.Size());
     for (size_t i=0;i<Nproc;i++)
     {
         for (size_t j=0;j<MTD[i].LLC.Size();j++)
         {
             size_t idx = Pt2idx(MTD[i].LLC[j].first,LCellDim);
             LinkedCell[idx].Push(MTD[i].LLC[j].second);
+            ParCell[MTD[i].LLC[j].second] = idx;
         }
     }
 #else
@@ -2226,8 +2317,47 @@ inline double Domain::MaxDisplacement()
     return md;
 }
 
+inline void Domain::CompactInteractons()
+{
+    // Only compact once the dead interactons are a sizeable part of the list
+    Array<char> dead(CInteractons.Size());
+    size_t Ndead = 0;
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc) reduction(+:Ndead)
+    #endif
+    for (size_t n=0;n<CInteractons.Size();n++)
+    {
+        CInteracton * I = CInteractons[n];
+        bool close = (Distance(I->P1->x,I->P2->x+I->Shift)<=I->P1->Dmax+I->P2->Dmax+2*Alpha);
+        dead[n] = (!close&&!I->HasHistory());
+        if (dead[n]) Ndead++;
+    }
+    if (4*Ndead<CInteractons.Size()||Ndead==0) return;
+
+    size_t idx = 0;
+    for (size_t n=0;n<CInteractons.Size();n++)
+    {
+        if (dead[n]) CIPool.Delete(CInteractons[n]);
+        else         CInteractons[idx++] = CInteractons[n];
+    }
+    CInteractons.Resize(idx);
+
+    Listofpairs.Clear();
+    Listofpairs.Reserve(CInteractons.Size());
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t n=0;n<CInteractons.Size();n++)
+    {
+        size_t i = CInteractons[n]->P1->Index;
+        size_t j = CInteractons[n]->P2->Index;
+        Listofpairs.InsertConcurrent(std::min(i,j),std::max(i,j));
+    }
+}
+
 inline void Domain::ResetContacts()
 {   
+    CompactInteractons();
 #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     for (size_t i=0;i<Nproc;i++)
@@ -2243,35 +2373,14 @@ inline void Domain::ResetContacts()
         size_t j = ListPosPairs[n].second;
         bool pi_has_vf = !Particles[i]->IsFree();
         bool pj_has_vf = !Particles[j]->IsFree();
-        bool close = (Distance(Particles[i]->x,Particles[j]->x)<=Particles[i]->Dmax+Particles[j]->Dmax+2*Alpha);
+        Vec3_t S;
+        ImageShift(Particles[i],Particles[j],S);
+        bool close = (Distance(Particles[i]->x,Particles[j]->x+S)<=Particles[i]->Dmax+Particles[j]->Dmax+2*Alpha);
         if ((pi_has_vf && pj_has_vf) || !close) continue;
-        std::set<std::pair<Particle *, Particle *> >::iterator it = Listofpairs.find(std::make_pair(Particles[i],Particles[j]));
-        if (it != Listofpairs.end())
-        {
-            continue;
-        }
+        if (Listofpairs.Has(i,j)) continue;
         MTD[omp_get_thread_num()].LC.Push(std::make_pair(i,j));
     }
-    for (size_t i=0;i<Nproc;i++)
-    {
-        //std::cout << MTD[i].LC.Size() << std::endl;
-        for (size_t j=0;j<MTD[i].LC.Size();j++)
-        {
-        //std::cout << MTD[i].LC.Size() << std::endl;
-            size_t n = MTD[i].LC[j].first;
-            size_t m = MTD[i].LC[j].second;
-            Listofpairs.insert(std::make_pair(Particles[n],Particles[m]));
-            if (Particles[n]->Verts.Size()==1 && Particles[m]->Verts.Size()==1)
-            {
-                if (!MostlySpheres) CInteractons.Push (new CInteractonSphere(Particles[n],Particles[m]));
-                //if (!MostlySpheres) SInteractons.Push (new SphereCollision(Particles[n],Particles[m]));
-            }
-            else
-            {
-                CInteractons.Push (new CInteracton(Particles[n],Particles[m]));
-            }
-        }
-    }
+    AddContactInteractons();
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     for (size_t n=0;n<CInteractons.Size();n++)
     {
@@ -2294,617 +2403,429 @@ inline void Domain::ResetContacts()
             Interactons.Push(BInteractons[MTD[i].LCB[j]]);
         }
     }
-    if (Xmax-Xmin>Alpha)
+    UpdateForceLists();
+    if (MostlySpheres) UpdateSpherePairs();
+#else
+    // Without the linked cells every pair with a free particle is a candidate
+    ListPosPairs.Resize(0);
+    for (size_t i=0; i+1<Particles.Size(); i++)
     {
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<Nproc;i++)
+        bool pi_has_vf = !Particles[i]->IsFree();
+        for (size_t j=i+1; j<Particles.Size(); j++)
         {
-            MTD[i].LBP.Resize(0);
-            MTD[i].LPC.Resize(0);
-            MTD[i].LPCI.Resize(0);
-        }
+            bool pj_has_vf = !Particles[j]->IsFree();
+            Vec3_t S;
+            ImageShift(Particles[i],Particles[j],S);
+            bool close = (Distance(Particles[i]->x,Particles[j]->x+S)<=Particles[i]->Dmax+Particles[j]->Dmax+2*Alpha);
+            if ((pi_has_vf && pj_has_vf) || !close) continue;
+            ListPosPairs.Push(std::make_pair(i,j));
 
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<Particles.Size();i++)
-        {
-            Particle * Pa = Particles[i];
-            if ((Pa->MinX()>Xmax)&&Pa->IsFree())
-            {
-                Vec3_t v(Xmin-Xmax,0.0,0.0);
-                Pa->Translate(v);
-            }
-            if ((Pa->MaxX()<Xmin)&&Pa->IsFree())
-            {
-                Vec3_t v(Xmax-Xmin,0.0,0.0);
-                Pa->Translate(v);
-            }
-            if ((Pa->MaxX()>Xmax-2.0*Alpha-2.0*MaxDmax)&&Pa->IsFree())
-            {
-                MTD[omp_get_thread_num()].LBP.Push(i);
-            }
-        }
-        ParXmax.Resize(0);
-        for (size_t i=0;i<Nproc;i++)
-        {
-            for (size_t j=0;j<MTD[i].LBP.Size();j++)
-            {
-                ParXmax.Push(Particles[MTD[i].LBP[j]]);
-            }
-        }
+            // checking if the interacton exist for that pair of particles
+            if (!Listofpairs.Insert(i,j)) continue;
 
-        Vec3_t v(Xmin-Xmax,0.0,0.0);
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<ParXmax.Size();i++)
-        {
-            Particle * P1 = ParXmax[i];
-            P1->Translate(v);
-            iVec3_t index = (P1->x - LCxmin)/(2.0*Beta*MaxDmax);
-            size_t ic = index(0);
-            size_t jc = index(1);
-            size_t kc = index(2);
-            if (index(0)>LCellDim(0)) ic = 0;
-            for (size_t knb=std::max(0,int(kc)-1);knb<=std::min(LCellDim(2)-1,kc+1);knb++)
-            for (size_t jnb=std::max(0,int(jc)-1);jnb<=std::min(LCellDim(1)-1,jc+1);jnb++)
-            for (size_t inb=std::max(0,int(ic)-1);inb<=std::min(LCellDim(0)-1,ic+1);inb++)
+            // if both particles are spheres (just one vertex), unless CalcForceSphere takes them
+            CInteracton * I = NULL;
+            if (Particles[i]->Verts.Size()==1 && Particles[j]->Verts.Size()==1)
             {
-                iVec3_t Ptnb(inb,jnb,knb);
-                size_t idxnb = Pt2idx(Ptnb,LCellDim);
-                for (size_t m=0;m<LinkedCell[idxnb].Size()  ;m++)
-                {
-                    size_t i2 = LinkedCell[idxnb][m];
-                    Particle * P2 = Particles[i2];
-                    if (P1==P2||ParXmax.Has(P2))
-                    {
-                        //std::cout << P1->x << " " << P2->x << std::endl;
-                        continue;
-                    }
-
-                    bool close = (Distance(P1->x,P2->x)<=P1->Dmax+P2->Dmax+2*Alpha);
-                    if (!close) continue;
-                    std::set<std::pair<Particle *, Particle *> >::iterator it = PxListofpairs.find(std::make_pair(P1,P2));
-                    if (it != PxListofpairs.end())
-                    {
-                        continue;
-                    }
-                    MTD[omp_get_thread_num()].LPC.Push(std::make_pair(i,i2));
-                }
+                if (!MostlySpheres) I = CIPool.New<CInteractonSphere>(Particles[i],Particles[j]);
             }
-        }
 
-        for (size_t i=0;i<Nproc;i++)
-        {
-            for (size_t j=0;j<MTD[i].LPC.Size();j++)
+            // normal particles
+            else
             {
-                size_t n = MTD[i].LPC[j].first;
-                size_t m = MTD[i].LPC[j].second;
-                PxListofpairs.insert(std::make_pair(ParXmax[n],Particles[m]));
-                if (ParXmax[n]->Verts.Size()==1 && Particles[m]->Verts.Size()==1)
-                {
-                    CPxInteractons.Push (new CInteractonSphere(ParXmax[n],Particles[m]));
-                }
-                else
-                {
-                    CPxInteractons.Push (new CInteracton(ParXmax[n],Particles[m]));
-                }
+                I = CIPool.New<CInteracton>(Particles[i],Particles[j]);
             }
+            if (I==NULL) continue;
+            I->Shift = S;
+            CInteractons.Push (I);
         }
+    }
+    Interactons.Resize(0);
+    for (size_t i=0; i<CInteractons.Size(); i++)
+    {
+        if(CInteractons[i]->UpdateContacts(Alpha)) Interactons.Push(CInteractons[i]);
+    }
+    for (size_t i=0; i<BInteractons.Size(); i++)
+    {
+        if(BInteractons[i]->UpdateContacts(Alpha)) Interactons.Push(BInteractons[i]);
+    }
+    UpdateForceLists();
+    if (MostlySpheres) UpdateSpherePairs();
+#endif
+}
 
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t n=0;n<CPxInteractons.Size();n++)
-        {
-            if(CPxInteractons[n]->UpdateContacts(Alpha)) MTD[omp_get_thread_num()].LPCI.Push(n);
-        }
-        PxInteractons.Resize(0);
-        for (size_t i=0;i<Nproc;i++)
-        {
-            for (size_t j=0;j<MTD[i].LPCI.Size();j++)
-            {
-                PxInteractons.Push(CPxInteractons[MTD[i].LPCI[j]]);
-            }
-        }
-        v = Vec3_t(Xmax-Xmin,0.0,0.0);
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<ParXmax.Size();i++)
+#ifdef USE_OMP
+inline void Domain::AddContactInteractons()
+{
+    size_t Nlc = 0;
+    for (size_t i=0;i<Nproc;i++) Nlc += MTD[i].LC.Size();
+    Listofpairs.Reserve(Listofpairs.Size()+Nlc);
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t i=0;i<Nproc;i++)
+    {
+        for (size_t j=0;j<MTD[i].LC.Size();j++)
         {
-            Particle * P1 = ParXmax[i];
-            P1->Translate(v);
+            Listofpairs.InsertConcurrent(MTD[i].LC[j].first,MTD[i].LC[j].second);
         }
     }
-    if (Ymax-Ymin>Alpha)
+    for (size_t i=0;i<Nproc;i++)
     {
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<Nproc;i++)
-        {
-            MTD[i].LBP.Resize(0);
-            MTD[i].LPC.Resize(0);
-            MTD[i].LPCI.Resize(0);
-        }
-
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<Particles.Size();i++)
+        //std::cout << MTD[i].LC.Size() << std::endl;
+        for (size_t j=0;j<MTD[i].LC.Size();j++)
         {
-            Particle * Pa = Particles[i];
-            if ((Pa->MinY()>Ymax)&&Pa->IsFree())
-            {
-                Vec3_t v(0.0,Ymin-Ymax,0.0);
-                Pa->Translate(v);
-            }
-            if ((Pa->MaxY()<Ymin)&&Pa->IsFree())
-            {
-                Vec3_t v(0.0,Ymax-Ymin,0.0);
-                Pa->Translate(v);
-            }
-            if ((Pa->MaxY()>Ymax-2.0*Alpha-2.0*MaxDmax)&&Pa->IsFree())
+        //std::cout << MTD[i].LC.Size() << std::endl;
+            size_t n = MTD[i].LC[j].first;
+            size_t m = MTD[i].LC[j].second;
+            CInteracton * I = NULL;
+            if (Particles[n]->Verts.Size()==1 && Particles[m]->Verts.Size()==1)
             {
-                MTD[omp_get_thread_num()].LBP.Push(i);
+                if (!MostlySpheres) I = CIPool.New<CInteractonSphere>(Particles[n],Particles[m]);
+                //if (!MostlySpheres) SInteractons.Push (new SphereCollision(Particles[n],Particles[m]));
             }
-        }
-        ParYmax.Resize(0);
-        for (size_t i=0;i<Nproc;i++)
-        {
-            for (size_t j=0;j<MTD[i].LBP.Size();j++)
+            else
             {
-                ParYmax.Push(Particles[MTD[i].LBP[j]]);
+                I = CIPool.New<CInteracton>(Particles[n],Particles[m]);
             }
+            if (I==NULL) continue;
+            ImageShift(Particles[n],Particles[m],I->Shift);
+            CInteractons.Push (I);
         }
+    }
+}
 
-        Vec3_t v(0.0,Ymin-Ymax,0.0);
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<ParYmax.Size();i++)
+inline void Domain::ReorderParticles()
+{
+    // Morton key of each centre, 21 bits per axis over the box holding all the centres
+    size_t Np = Particles.Size();
+    if (Np==0) return;
+    Vec3_t xmin = Particles[0]->x;
+    Vec3_t xmax = Particles[0]->x;
+    for (size_t i=1;i<Np;i++)
+    for (size_t d=0;d<3;d++)
+    {
+        xmin(d) = std::min(xmin(d),Particles[i]->x(d));
+        xmax(d) = std::max(xmax(d),Particles[i]->x(d));
+    }
+    Array<std::pair<uint64_t,size_t> > key(Np);
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t i=0;i<Np;i++)
+    {
+        uint64_t k = 0;
+        for (size_t d=0;d<3;d++)
         {
-            Particle * P1 = ParYmax[i];
-            P1->Translate(v);
-            iVec3_t index = (P1->x - LCxmin)/(2.0*Beta*MaxDmax);
-            size_t ic = index(0);
-            size_t jc = index(1);
-            size_t kc = index(2);
-            if (index(1)>LCellDim(1)) jc = 0;
-            for (size_t knb=std::max(0,int(kc)-1);knb<=std::min(LCellDim(2)-1,kc+1);knb++)
-            for (size_t jnb=std::max(0,int(jc)-1);jnb<=std::min(LCellDim(1)-1,jc+1);jnb++)
-            for (size_t inb=std::max(0,int(ic)-1);inb<=std::min(LCellDim(0)-1,ic+1);inb++)
-            {
-                iVec3_t Ptnb(inb,jnb,knb);
-                size_t idxnb = Pt2idx(Ptnb,LCellDim);
-                for (size_t m=0;m<LinkedCell[idxnb].Size()  ;m++)
-                {
-                    size_t i2 = LinkedCell[idxnb][m];
-                    Particle * P2 = Particles[i2];
-                    if (P1==P2||ParYmax.Has(P2))
-                    {
-                        //std::cout << P1->x << " " << P2->x << std::endl;
-                        continue;
-                    }
-
-                    bool close = (Distance(P1->x,P2->x)<=P1->Dmax+P2->Dmax+2*Alpha);
-                    if (!close) continue;
-                    std::set<std::pair<Particle *, Particle *> >::iterator it = PyListofpairs.find(std::make_pair(P1,P2));
-                    if (it != PyListofpairs.end())
-                    {
-                        continue;
-                    }
-                    MTD[omp_get_thread_num()].LPC.Push(std::make_pair(i,i2));
-                }
-            }
+            double   L = xmax(d)-xmin(d);
+            uint64_t c = L>0.0 ? uint64_t(2097151.0*(Particles[i]->x(d)-xmin(d))/L) : 0;
+            for (size_t b=0;b<21;b++) k |= ((c>>b)&1)<<(3*b+d);
         }
+        key[i] = std::make_pair(k,i);
+    }
+    std::sort(key.begin(),key.end());
 
-        for (size_t i=0;i<Nproc;i++)
-        {
-            for (size_t j=0;j<MTD[i].LPC.Size();j++)
-            {
-                size_t n = MTD[i].LPC[j].first;
-                size_t m = MTD[i].LPC[j].second;
-                PyListofpairs.insert(std::make_pair(ParYmax[n],Particles[m]));
-                if (ParYmax[n]->Verts.Size()==1 && Particles[m]->Verts.Size()==1)
-                {
-                    CPyInteractons.Push (new CInteractonSphere(ParYmax[n],Particles[m]));
-                }
-                else
-                {
-                    CPyInteractons.Push (new CInteracton(ParYmax[n],Particles[m]));
-                }
-            }
-        }
+    // Only the pointers are permuted, the objects stay where they are so pointers held by the user code
+    // and by the interactons remain valid
+    Array<Particle*> Old(Np);
+    Array<size_t>    NewIndex(Np);
+    for (size_t i=0;i<Np;i++)
+    {
+        Old[i] = Particles[i];
+        NewIndex[key[i].second] = i;
+    }
+    for (size_t i=0;i<Np;i++)
+    {
+        Particles[i] = Old[key[i].second];
+        Particles[i]->Index = i;
+    }
+    FreePar.Resize(0);
+    NoFreePar.Resize(0);
+    for (size_t i=0;i<Np;i++)
+    {
+        if (Particles[i]->IsFree()) FreePar.Push(i);
+        else                        NoFreePar.Push(i);
+    }
+    SPairs.Renumber(NewIndex);
 
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t n=0;n<CPyInteractons.Size();n++)
-        {
-            if(CPyInteractons[n]->UpdateContacts(Alpha)) MTD[omp_get_thread_num()].LPCI.Push(n);
-        }
-        PyInteractons.Resize(0);
-        for (size_t i=0;i<Nproc;i++)
-        {
-            for (size_t j=0;j<MTD[i].LPCI.Size();j++)
-            {
-                PyInteractons.Push(CPyInteractons[MTD[i].LPCI[j]]);
-            }
-        }
-        v = Vec3_t(0.0,Ymax-Ymin,0.0);
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<ParYmax.Size();i++)
-        {
-            Particle * P1 = ParYmax[i];
-            P1->Translate(v);
-        }
+    // Walk the contact interactons in the new order of their particles and key the pair set by the new indices
+    Array<std::pair<std::pair<size_t,size_t>,CInteracton*> > ci(CInteractons.Size());
+    for (size_t n=0;n<CInteractons.Size();n++)
+    {
+        size_t i = CInteractons[n]->P1->Index;
+        size_t j = CInteractons[n]->P2->Index;
+        ci[n] = std::make_pair(std::make_pair(std::min(i,j),std::max(i,j)),CInteractons[n]);
     }
-    if ((Xmax-Xmin>Alpha)&&(Ymax-Ymin>Alpha))
+    std::sort(ci.begin(),ci.end());
+    Listofpairs.Clear();
+    Listofpairs.Reserve(CInteractons.Size());
+    for (size_t n=0;n<CInteractons.Size();n++)
     {
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<Nproc;i++)
-        {
-            MTD[i].LBP.Resize(0);
-            MTD[i].LPC.Resize(0);
-            MTD[i].LPCI.Resize(0);
-        }
+        CInteractons[n] = ci[n].second;
+        CInteractons[n]->I1 = CInteractons[n]->P1->Index;
+        CInteractons[n]->I2 = CInteractons[n]->P2->Index;
+        Listofpairs.Insert(ci[n].first.first,ci[n].first.second);
+    }
+    for (size_t n=0;n<BInteractons.Size();n++)
+    {
+        BInteractons[n]->I1 = BInteractons[n]->P1->Index;
+        BInteractons[n]->I2 = BInteractons[n]->P2->Index;
+    }
+}
 
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<ParXmax.Size();i++)
-        {
-            if (ParYmax.Has(ParXmax[i]))
-            {
-                MTD[omp_get_thread_num()].LBP.Push(ParXmax[i]->Index);
-            }
-        }
+inline bool Domain::RefreshMovers(double Skin)
+{
+    // The sphere only forces walk ListPosPairs, which is not refreshed
+    if (MostlySpheres) return false;
 
-        ParXYmax.Resize(0);
-        for (size_t i=0;i<Nproc;i++)
-        {
-            for (size_t j=0;j<MTD[i].LBP.Size();j++)
-            {
-                ParXYmax.Push(Particles[MTD[i].LBP[j]]);
-            }
-        }
-        Vec3_t v(Xmin-Xmax,Ymin-Ymax,0.0);
-        for (size_t i=0;i<ParXYmax.Size();i++)
-        {
-            Particle * P1 = ParXYmax[i];
-            P1->Translate(v);
-            iVec3_t index = (P1->x - LCxmin)/(2.0*Beta*MaxDmax);
-            size_t ic = index(0);
-            size_t jc = index(1);
-            size_t kc = index(2);
-            if (index(0)>LCellDim(0)) ic = 0;
-            if (index(1)>LCellDim(1)) jc = 0;
-            for (size_t knb=std::max(0,int(kc)-1);knb<=std::min(LCellDim(2)-1,kc+1);knb++)
-            for (size_t jnb=std::max(0,int(jc)-1);jnb<=std::min(LCellDim(1)-1,jc+1);jnb++)
-            for (size_t inb=std::max(0,int(ic)-1);inb<=std::min(LCellDim(0)-1,ic+1);inb++)
-            {
-                iVec3_t Ptnb(inb,jnb,knb);
-                size_t idxnb = Pt2idx(Ptnb,LCellDim);
-                for (size_t m=0;m<LinkedCell[idxnb].Size()  ;m++)
-                {
-                    size_t i2 = LinkedCell[idxnb][m];
-                    Particle * P2 = Particles[i2];
-                    if (P1==P2||ParXYmax.Has(P2))
-                    {
-                        //std::cout << P1->x << " " << P2->x << std::endl;
-                        continue;
-                    }
+    // Particles that moved more than the skin
+    Array<char> Moved(Particles.Size());
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t i=0;i<Particles.Size();i++)
+    {
+        Moved[i] = (Particles[i]->MaxDisplacement()>Skin);
+    }
+    Array<size_t> Mov;
+    for (size_t i=0;i<Particles.Size();i++)
+    {
+        if (Moved[i]) Mov.Push(i);
+    }
 
-                    bool close = (Distance(P1->x,P2->x)<=P1->Dmax+P2->Dmax+2*Alpha);
-                    if (!close) continue;
-                    std::set<std::pair<Particle *, Particle *> >::iterator it = PxyListofpairs.find(std::make_pair(P1,P2));
-                    if (it != PxyListofpairs.end())
-                    {
-                        continue;
-                    }
-                    MTD[omp_get_thread_num()].LPC.Push(std::make_pair(i,i2));
-                }
-            }
-        }
-        for (size_t i=0;i<Nproc;i++)
+    // Fall back to a full rebuild if many particles moved, a fixed one moved or one left the linked cells
+    // (through a periodic boundary too, since the image shifts of its interactons would change)
+    if (4*Mov.Size()>FreePar.Size()) return false;
+    double        lc = LCellSize();
+    Array<size_t> Cell(Mov.Size());
+    for (size_t k=0;k<Mov.Size();k++)
+    {
+        Particle * Pa = Particles[Mov[k]];
+        if (!Pa->IsFree()) return false;
+        for (size_t d=0;d<3;d++)
         {
-            for (size_t j=0;j<MTD[i].LPC.Size();j++)
-            {
-                size_t n = MTD[i].LPC[j].first;
-                size_t m = MTD[i].LPC[j].second;
-                PxyListofpairs.insert(std::make_pair(ParXYmax[n],Particles[m]));
-                if (ParXYmax[n]->Verts.Size()==1 && Particles[m]->Verts.Size()==1)
-                {
-                    CPxyInteractons.Push (new CInteractonSphere(ParXYmax[n],Particles[m]));
-                }
-                else
-                {
-                    CPxyInteractons.Push (new CInteracton(ParXYmax[n],Particles[m]));
-                }
-            }
+            double Lmin,Lmax;
+            double xmax = Periodic(d,Lmin,Lmax) ? LCxmax(d) : LCxmin(d)+LCellDim(d)*lc;
+            if (Pa->x(d)<LCxmin(d)||Pa->x(d)>=xmax) return false;
         }
+        iVec3_t index;
+        CellOf(Pa->x,index);
+        Cell[k] = Pt2idx(index,LCellDim);
+    }
 
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t n=0;n<CPxyInteractons.Size();n++)
-        {
-            if(CPxyInteractons[n]->UpdateContacts(Alpha)) MTD[omp_get_thread_num()].LPCI.Push(n);
-        }
-        PxyInteractons.Resize(0);
-        for (size_t i=0;i<Nproc;i++)
+    // Move them to their new cells
+    for (size_t k=0;k<Mov.Size();k++)
+    {
+        size_t i = Mov[k];
+        if (Cell[k]==ParCell[i]) continue;
+        Array<size_t> & Old = LinkedCell[ParCell[i]];
+        long pos = Old.Find(i);
+        if (pos<0) throw new Fatal("Domain::RefreshMovers: Particle %zd is not in its linked cell",i);
+        Old[pos] = Old.Last();
+        Old.Resize(Old.Size()-1);
+        LinkedCell[Cell[k]].Push(i);
+        ParCell[i] = Cell[k];
+    }
+
+    // New pairs around them, a pair of movers is found from its first particle only
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t i=0;i<Nproc;i++)
+    {
+        MTD[i].LC.Resize(0);
+        MTD[i].LCI.Resize(0);
+        MTD[i].LCB.Resize(0);
+    }
+    #pragma omp parallel for schedule(dynamic) num_threads(Nproc)
+    for (size_t k=0;k<Mov.Size();k++)
+    {
+        size_t i = Mov[k];
+        Particle * P1 = Particles[i];
+        Array<std::pair<size_t,size_t> > & LC = MTD[omp_get_thread_num()].LC;
+        size_t Nb[27];
+        size_t Nnb = NeighbourCells(ParCell[i],Nb);
+        for (size_t nb=0;nb<Nnb;nb++)
         {
-            for (size_t j=0;j<MTD[i].LPCI.Size();j++)
+            size_t idxnb = Nb[nb];
+            for (size_t m=0;m<LinkedCell[idxnb].Size();m++)
             {
-                PxyInteractons.Push(CPxyInteractons[MTD[i].LPCI[j]]);
+                size_t j = LinkedCell[idxnb][m];
+                if (j==i||(Moved[j]&&j<i)) continue;
+                Particle * P2 = Particles[j];
+                Vec3_t S;
+                ImageShift(P1,P2,S);
+                if (Distance(P1->x,P2->x+S)>P1->Dmax+P2->Dmax+2*Alpha) continue;
+                if (Listofpairs.Has(std::min(i,j),std::max(i,j))) continue;
+                LC.Push(std::make_pair(std::min(i,j),std::max(i,j)));
             }
         }
-        v = Vec3_t(Xmax-Xmin,Ymax-Ymin,0.0);
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-        for (size_t i=0;i<ParXYmax.Size();i++)
+        for (size_t m=0;m<NoFreePar.Size();m++)
         {
-            Particle * P1 = ParXYmax[i];
-            P1->Translate(v);
+            size_t j = NoFreePar[m];
+            Particle * P2 = Particles[j];
+            if (Distance(P1->x,P2->x)>P1->Dmax+P2->Dmax+2*Alpha) continue;
+            if (Listofpairs.Has(std::min(i,j),std::max(i,j))) continue;
+            LC.Push(std::make_pair(std::min(i,j),std::max(i,j)));
         }
     }
-#else
-    for (size_t i=0; i<Particles.Size()-1; i++)
-    {
-        bool pi_has_vf = !Particles[i]->IsFree();
-        for (size_t j=i+1; j<Particles.Size(); j++)
-        {
-            bool pj_has_vf = !Particles[j]->IsFree();
+    AddContactInteractons();
 
-            bool close = (Distance(Particles[i]->x,Particles[j]->x)<=Particles[i]->Dmax+Particles[j]->Dmax+2*Alpha);
-            if ((pi_has_vf && pj_has_vf) || !close) continue;
-            
-            // checking if the interacton exist for that pair of particles
-            std::set<std::pair<Particle *, Particle *> >::iterator it = Listofpairs.find(std::make_pair(Particles[i],Particles[j]));
-            if (it != Listofpairs.end())
-            {
-                continue;
-            }
-            Listofpairs.insert(std::make_pair(Particles[i],Particles[j]));
-            
-            // if both particles are spheres (just one vertex)
-            if (Particles[i]->Verts.Size()==1 && Particles[j]->Verts.Size()==1)
-            {
-                CInteractons.Push (new CInteractonSphere(Particles[i],Particles[j]));
-            }
+    // Refresh the contacts of every interacton touching a mover, the new ones included
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t n=0;n<CInteractons.Size();n++)
+    {
+        if (!Moved[CInteractons[n]->P1->Index]&&!Moved[CInteractons[n]->P2->Index]) continue;
+        if (CInteractons[n]->UpdateContacts(Alpha)) MTD[omp_get_thread_num()].LCI.Push(n);
+    }
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t n=0;n<BInteractons.Size();n++)
+    {
+        if (!Moved[BInteractons[n]->P1->Index]&&!Moved[BInteractons[n]->P2->Index]) continue;
+        if (BInteractons[n]->UpdateContacts(Alpha)) MTD[omp_get_thread_num()].LCB.Push(n);
+    }
 
-            // normal particles
-            else
-            {
-                CInteractons.Push (new CInteracton(Particles[i],Particles[j]));
-            }
-        }
+    // The other active interactons are still valid
+    size_t idx = 0;
+    for (size_t n=0;n<Interactons.Size();n++)
+    {
+        if (Moved[Interactons[n]->P1->Index]||Moved[Interactons[n]->P2->Index]) continue;
+        Interactons[idx++] = Interactons[n];
     }
-    Interactons.Resize(0);
-    for (size_t i=0; i<CInteractons.Size(); i++)
+    Interactons.Resize(idx);
+    for (size_t i=0;i<Nproc;i++)
     {
-        if(CInteractons[i]->UpdateContacts(Alpha)) Interactons.Push(CInteractons[i]);
+        for (size_t j=0;j<MTD[i].LCI.Size();j++) Interactons.Push(CInteractons[MTD[i].LCI[j]]);
+        for (size_t j=0;j<MTD[i].LCB.Size();j++) Interactons.Push(BInteractons[MTD[i].LCB[j]]);
     }
-    for (size_t i=0; i<BInteractons.Size(); i++)
+
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t k=0;k<Mov.Size();k++)
     {
-        if(BInteractons[i]->UpdateContacts(Alpha)) Interactons.Push(BInteractons[i]);
+        Particles[Mov[k]]->ResetDisplacements();
     }
+    UpdateForceLists();
+    Nrefreshed += Mov.Size();
+    return true;
+}
 #endif
+
+inline void Domain::UpdateForceLists()
+{
+    // Count the interacton ends of each particle and build the offsets
+    FLOffset.Resize(Particles.Size()+1);
+    for (size_t i=0;i<FLOffset.Size();i++) FLOffset[i] = 0;
+    for (size_t i=0;i<Interactons.Size();i++)
+    {
+        FLOffset[Interactons[i]->P1->Index+1]++;
+        FLOffset[Interactons[i]->P2->Index+1]++;
+    }
+    for (size_t i=0;i<Particles.Size();i++) FLOffset[i+1] += FLOffset[i];
+
+    // Fill the lists keeping the interacton order so the sums are reproducible
+    FList.Resize(FLOffset[Particles.Size()]);
+    Array<size_t> Pos(Particles.Size());
+    for (size_t i=0;i<Particles.Size();i++) Pos[i] = FLOffset[i];
+    for (size_t i=0;i<Interactons.Size();i++)
+    {
+        Interacton * I = Interactons[i];
+        FList[Pos[I->P1->Index]++] = std::make_pair(&I->F1,&I->T1);
+        FList[Pos[I->P2->Index]++] = std::make_pair(&I->F2,&I->T2);
+    }
 }
 
-inline void Domain::ResetBoundaries()
+inline void Domain::GatherForces()
 {
-    /*
-    ParXmax.Resize(0);
+    // Each particle only reads its own slice of FList, so no locks are needed
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
     for (size_t i=0;i<Particles.Size();i++)
     {
         Particle * Pa = Particles[i];
-        if ((Pa->MinX()>Xmax)&&Pa->IsFree())
-        {
-            Vec3_t v(Xmin-Xmax,0.0,0.0);
-            Pa->Translate(v);
-        }
-        if ((Pa->MaxX()<Xmin)&&Pa->IsFree())
+        for (size_t n=FLOffset[i];n<FLOffset[i+1];n++)
         {
-            Vec3_t v(Xmax-Xmin,0.0,0.0);
-            Pa->Translate(v);
-        }
-        if ((Pa->MaxX()>Xmax-2.0*Alpha-2.0*MaxDmax)&&Pa->IsFree())
-        {
-            ParXmax.Push(Pa);
+            Pa->F += *FList[n].first;
+            Pa->T += *FList[n].second;
         }
     }
-    
-    for (size_t i=0;i<ParXmax.Size();i++) 
+}
+
+inline bool Domain::Periodic(size_t d, double & Lmin, double & Lmax) const
+{
+    Lmin = d==0 ? Xmin : (d==1 ? Ymin : Zmin);
+    Lmax = d==0 ? Xmax : (d==1 ? Ymax : Zmax);
+    return (Lmax-Lmin>Alpha);
+}
+
+inline void Domain::ImageShift(Particle * P1, Particle * P2, Vec3_t & S) const
+{
+    // Only the free particles cross the periodic boundaries, walls and fixed particles stay where they are
+    S = OrthoSys::O;
+    if (!P1->IsFree()||!P2->IsFree()) return;
+    for (size_t d=0;d<3;d++)
     {
-        Particle * P1 = ParXmax[i];
-        Vec3_t v(Xmin-Xmax,0.0,0.0);
-        P1->Translate(v);
-        for (size_t j=0; j<Particles.Size(); j++)
-        {
-            Particle * P2 = Particles[j];
-            if (P1==P2||!P2->IsFree()||ParXmax.Has(P2)) continue;
-            bool close = (Distance(P1->x,P2->x)<=P1->Dmax+P2->Dmax+2*Alpha);
-            if (!close) continue;
-            std::set<std::pair<Particle *, Particle *> >::iterator it = PListofpairs.find(std::make_pair(P1,P2));
-            if (it != PListofpairs.end())
-            {
-                continue;
-            }
-            PListofpairs.insert(std::make_pair(P1,P2));
-            // if both particles are spheres (just one vertex)
-            if (P1->Verts.Size()==1 && P2->Verts.Size()==1)
-            {
-                CPInteractons.Push (new CInteractonSphere(P1,P2));
-            }
+        double Lmin,Lmax;
+        if (!Periodic(d,Lmin,Lmax)) continue;
+        double L = Lmax-Lmin;
+        S(d) = L*round((P1->x(d)-P2->x(d))/L);
+    }
+}
 
-            // normal particles
-            else
-            {
-                CPInteractons.Push (new CInteracton(P1,P2));
-            }
+inline void Domain::ResetBoundaries()
+{
+    Vec3_t Lmin,Lmax;
+    bool   periodic = false;
+    for (size_t d=0;d<3;d++)
+    {
+        if (Periodic(d,Lmin(d),Lmax(d))) periodic = true;
+        else Lmin(d) = Lmax(d) = 0.0;
+    }
+    if (!periodic) return;
+
+    // Free particles whose centre left the box are moved to the opposite side
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t i=0;i<Particles.Size();i++)
+    {
+        Particle * Pa = Particles[i];
+        if (!Pa->IsFree()) continue;
+        Vec3_t v = OrthoSys::O;
+        for (size_t d=0;d<3;d++)
+        {
+            double L = Lmax(d)-Lmin(d);
+            if (L>0.0) v(d) = -L*floor((Pa->x(d)-Lmin(d))/L);
         }
+        if (dot(v,v)>0.0) Pa->Translate(v);
     }
-    PInteractons.Resize(0);
-    for (size_t i=0; i<CPInteractons.Size(); i++)
+
+    // so the two particles of an interacton may now touch through a different image
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t n=0;n<CInteractons.Size();n++)
     {
-        if(CPInteractons[i]->UpdateContacts(Alpha)) PInteractons.Push(CPInteractons[i]);
+        ImageShift(CInteractons[n]->P1,CInteractons[n]->P2,CInteractons[n]->Shift);
     }
-    Vec3_t vmin(Xmax-Xmin,0.0,0.0);
-    for (size_t i=0;i<ParXmax.Size();i++) ParXmax[i]->Translate(vmin);
-    */
 }
 
-inline void Domain::CalcForceSphere()
+inline void Domain::UpdateSpherePairs()
 {
-    //std::cout << "Pairs size = " << ListPosPairs.Size() << std::endl;
-    //std::set<std::pair<Particle *,Particle *> >::iterator it;
-#ifdef USE_OMP
-    #pragma omp parallel for schedule(static) num_threads(Nproc)
-#endif
-    //for (it=Listofpairs.begin();it!=Listofpairs.end();++it)
-    for (size_t np=0;np<ListPosPairs.size();np++)
+    Array<size_t> Pi,Pj;
+    Array<Vec3_t> Ps;
+    for (size_t n=0;n<ListPosPairs.Size();n++)
     {
-        //std::cout << "1" << std::endl;
-        size_t i = ListPosPairs[np].first;
-        size_t j = ListPosPairs[np].second;
-        //std::cout << i << " " << j << std::endl;
+        size_t i = ListPosPairs[n].first;
+        size_t j = ListPosPairs[n].second;
         DEM::Particle * P1 = Particles[i];
         DEM::Particle * P2 = Particles[j];
-        //DEM::Particle * P1 = it->first;
-        //DEM::Particle * P2 = it->second;
-        //size_t i = P1->Index;
-        //size_t j = P2->Index;
-        bool pi = (P1->Verts.Size()==1);
-        bool pj = (P2->Verts.Size()==1);
-        //bool close = (Distance(P1->x,P2->x)<=P1->Dmax+P2->Dmax+2*Alpha);
-        if (!(pi&&pj)) continue;
-        //std::cout << i << " " << j << std::endl;
-
-        Vec3_t xi = P1->x;
-        Vec3_t xf = P2->x;
-        double dist = norm(P1->x - P2->x);
-        double delta = P1->Props.R + P2->Props.R - dist;
-        if (delta>0)
-        {
-            //std::cout << "2" << std::endl;
-            Vec3_t n = (xf-xi)/dist;
-            Vec3_t x = xi+n*((P1->Props.R*P1->Props.R-P2->Props.R*P2->Props.R+dist*dist)/(2*dist));
-            Vec3_t t1,t2,x1,x2;
-            Rotation(P1->w,P1->Q,t1);
-            Rotation(P2->w,P2->Q,t2);
-            x1 = x - P1->x;
-            x2 = x - P2->x;
-            Vec3_t vrel = -((P2->v-P1->v)+cross(t2,x2)-cross(t1,x1));
-            Vec3_t vt = vrel - dot(n,vrel)*n;
-
-            double Kn = ReducedValue(P1->Props.Kn,P2->Props.Kn);
-            double Kt = 2*ReducedValue(P1->Props.Kt,P2->Props.Kt);
-            double me = ReducedValue(P1->Props.m ,P2->Props.m );
-            double Gn = 2*ReducedValue(P1->Props.Gn,P2->Props.Gn);
-            double Gt = 2*ReducedValue(P1->Props.Gt,P2->Props.Gt);
-            double beta = 2*ReducedValue(P1->Props.Beta,P2->Props.Beta);
-            double eta  = 2*ReducedValue(P1->Props.Eta,P2->Props.Eta);
-            //double Bn   = 2*ReducedValue(P1->Props.Bn,P2->Props.Bn);
-            //double Bt   = 2*ReducedValue(P1->Props.Bt,P2->Props.Bt);
-            //double eps  = 2*ReducedValue(P1->Props.eps,P2->Props.eps);
-            double Mu;
-
-            if (P1->Props.Mu>1.0e-12&&P2->Props.Mu>1.0e-12)
-            {
-                Mu          = std::max(P1->Props.Mu,P2->Props.Mu);
-            }
-            else 
-            {
-                Mu          = 0.0;
-            }
-
-            if (Gn < -0.001)
-            {
-                if (fabs(Gn)>1.0) throw new Fatal("CInteractonSphere the restitution coefficient is greater than 1");
-                Gn = 2.0*sqrt((pow(log(-Gn),2.0)*(Kn/me))/(M_PI*M_PI+pow(log(-Gn),2.0)));
-                Gt = 0.0;
-            }
-            Gn *= me;
-            Gt *= me;
-
-            Vec3_t Fn = Kn*delta*n;
-            std::pair<int,int> p;
-            p = std::make_pair(i,j);
-            if (FricSpheres.count(p)==0) 
-            {             
-#ifdef USE_OMP
-                omp_set_lock  (&lck);
-#endif
-                FricSpheres[p] = OrthoSys::O;
-#ifdef USE_OMP
-                omp_unset_lock(&lck);
-#endif
-            }
-            FricSpheres[p] += vt*Dt;
-            FricSpheres[p] -= dot(FricSpheres[p],n)*n;
-            Vec3_t tan = FricSpheres[p];
-            if (norm(tan)>0.0) tan/=norm(tan);
-            if (norm(FricSpheres[p])>Mu*norm(Fn)/Kt)
-            {
-                FricSpheres[p] = Mu*norm(Fn)/Kt*tan;
-            }
-            Vec3_t F = Fn + Kt*FricSpheres[p] + Gn*dot(n,vrel)*n + Gt*vt;
-            //Vec3_t F = Fn + P1->Props.Gn*dot(n,vrel)*n + P1->Props.Gt*vt;
-            Vec3_t F1   = -F;
-            Vec3_t F2   =  F;
-
-            Vec3_t T, Tt;
-            Tt = cross (x1,F);
-            Quaternion_t q;
-            Conjugate (P1->Q,q);
-            Rotation  (Tt,q,T);
-            Vec3_t T1 = -T;
-
-            Tt = cross (x2,F);
-            Conjugate (P2->Q,q);
-            Rotation  (Tt,q,T);
-            Vec3_t T2 =  T;
-            
-            //std::cout << "3" << std::endl;
-
-
-            //rolling resistance
-            if (dot(F,n)<0) F-=dot(F,n)*n;
-            Vec3_t Normal = Fn/norm(Fn);
-            Vec3_t Vr = P1->Props.R*P2->Props.R*cross(Vec3_t(t1 - t2),Normal)/(P1->Props.R+P2->Props.R);
-            if (RollSpheres.count(p)==0) 
-            {
-#ifdef USE_OMP
-                omp_set_lock  (&lck);
-#endif
-                RollSpheres[p] = OrthoSys::O;
-#ifdef USE_OMP
-                omp_unset_lock(&lck);
-#endif
-            }
-            RollSpheres[p] += Vr*Dt;
-            RollSpheres[p] -= dot(RollSpheres[p],Normal)*Normal;
-            tan = RollSpheres[p];
-            if (norm(tan)>0.0) tan/=norm(tan);
-            double Kr = beta*Kt;
-            if (norm(RollSpheres[p])>eta*Mu*norm(Fn)/Kr)
-            {
-                RollSpheres[p] = eta*Mu*norm(Fn)/Kr*tan;
-            }
-            Vec3_t Ft = -Kr*RollSpheres[p];
-
-            //std::cout << "4" << std::endl;
-
-            Tt = P1->Props.R*cross(Normal,Ft);
-            Conjugate (P1->Q,q);
-            Rotation  (Tt,q,T);
-            T1 += T;
-//
-            Tt = P2->Props.R*cross(Normal,Ft);
-            Conjugate (P2->Q,q);
-            Rotation  (Tt,q,T);
-            T2 -= T;
+        if (P1->Verts.Size()!=1||P2->Verts.Size()!=1) continue;
+        Vec3_t S;
+        ImageShift(P1,P2,S);
+        if (Distance(P1->x,P2->x+S)>P1->Props.R+P2->Props.R+2*Alpha) continue;
+        Pi.Push(i);
+        Pj.Push(j);
+        Ps.Push(S);
+    }
+    SPairs.Reset(Particles,Pi,Pj,Ps,Nproc);
+}
 
-#ifdef USE_OMP
-            omp_set_lock  (&P1->lck);
-#endif
-            P1->F += F1;
-            P1->T += T1;
-#ifdef USE_OMP
-            omp_unset_lock(&P1->lck);
-            omp_set_lock  (&P2->lck);
-#endif
-            P2->F += F2;
-            P2->T += T2;
-#ifdef USE_OMP
-            omp_unset_lock(&P2->lck);
-#endif
-        }
-    }
-    
+inline void Domain::CalcForceSphere()
+{
+    SPairs.CalcForces(Particles,Dt,Nproc);
 }
 
 // Auxiliar methods
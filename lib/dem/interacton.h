@@ -23,9 +23,9 @@
 // Std Lib
 #include <math.h>
 #include <map>
-//#include <unordered_map>
 #include <vector>
 #include <utility>
+#include <new>
 
 // MechSys
 #include <mechsys/dem/particle.h>
@@ -34,16 +34,32 @@ namespace DEM
 {
 
 // typedefs
-//typedef std::unordered_map<std::pair<int,int>,Vec3_t> FrictionMap_t;
 typedef std::map<std::pair<int,int>,Vec3_t> FrictionMap_t;
 typedef Array<std::pair<int,int> > ListContacts_t;
 
+class FrictionHistory // Static friction displacements of the feature pairs of an interacton, stored contiguously
+{
+public:
+    // Methods
+    void     Bind (ListContacts_t const & L);           ///< Find the stored displacement of every entry of the contact list L
+    Vec3_t & Get  (size_t k, ListContacts_t const & L); ///< Displacement of the k-th entry of L, created as zero the first time it is needed
+    size_t   Size () const { return Disp.Size(); }     ///< Number of feature pairs with a stored displacement
+
+    // Data
+    ListContacts_t Keys;                                ///< Feature pairs that have been in contact
+    Array<Vec3_t>  Disp;                                ///< Friction displacement of each pair in Keys
+    Array<int>     Slot;                                ///< Position in Disp of each entry of the bound contact list, -1 if the pair has not touched yet
+    Array<int>     Order;                               ///< Positions in Keys sorted by feature pair, searched by Bind
+private:
+    size_t   _lower (std::pair<int,int> const & P) const; ///< First position in Order whose key is not less than P
+};
+
 class Interacton   //General class for interactons
 {
 public:
 
     // Constructor and destructor
-    Interacton () {}           ///< Default constructor
+    Interacton () : Shift(OrthoSys::O) {} ///< Default constructor
     virtual ~Interacton () {}  ///< Destructor
 
     // Methods
@@ -60,6 +76,7 @@ public:
     Vec3_t         F2;        ///< Provisional force  for particle 2
     Vec3_t         T1;        ///< Provisional torque for particle 1
     Vec3_t         T2;        ///< Provisional torque for particle 2
+    Vec3_t         Shift;     ///< Displacement of the periodic image of particle 2 that particle 1 touches, zero if there is no boundary in between
 #ifdef USE_THREAD
     pthread_mutex_t lck;              ///< to protect variables in multithreading
 #endif
@@ -76,44 +93,47 @@ public:
     virtual bool UpdateContacts (double alpha);    ///< Update contacts by verlet algorithm
     virtual bool CalcForce      (double dt = 0.0); ///< Calculates the contact force between particles
     virtual void UpdateParameters ();              ///< Update the parameters
+    virtual bool HasHistory     ();                ///< Is there any non zero friction displacement stored?
 
     // Data
-    bool           First;     ///< Is it the first collision?
-    double         Kn;        ///< Normal stiffness
-    double         Kt;        ///< Tengential stiffness
-    double         Gn;        ///< Normal viscous coefficient
-    double         Gt;        ///< Tangential viscous coefficient
-    double         Mu;        ///< Microscpic coefficient of friction
-    double         Epot;      ///< Potential elastic energy
-    double         dEvis;     ///< Energy dissipated in viscosity at time step
-    double         dEfric;    ///< Energy dissipated by friction at time step
-    size_t         Nc;        ///< Number of contacts
-    size_t         Nsc;       ///< Number of sliding contacts
-    size_t         Nr;        ///< Number of rolling contacts (only for spheres)
-    Vec3_t         Fn;        ///< Normal force between elements
-    Vec3_t         Fnet;      ///< Net normal force
-    Vec3_t         Ftnet;     ///< Net tangential force
-    Vec3_t         Xc;        ///< Net Position of the contact
-    Mat3_t         B;         ///< Branch tensor for the study of isotropy
-    ListContacts_t Lee;       ///< List of edge-edge contacts 
-    ListContacts_t Lvf;       ///< List of vertex-face contacts 
-    ListContacts_t Lfv;       ///< List of face-vertex contacts
-    ListContacts_t Lvt;       ///< List of vertex-torus contacts
-    ListContacts_t Ltv;       ///< List of torus-vertex contacts
-    ListContacts_t Lvc;       ///< List of vertex-cylinder contacts
-    ListContacts_t Lcv;       ///< List of cylinder-vertex contacts
-    FrictionMap_t  Fdee;      ///< Static friction displacement for pair of edges
-    FrictionMap_t  Fdvf;      ///< Static friction displacement for pair of vertex-face
-    FrictionMap_t  Fdfv;      ///< Static friction displacement for pair of face-vertex
-    FrictionMap_t  Fdvt;      ///< Static friction displacement for pair of vertex-torus
-    FrictionMap_t  Fdtv;      ///< Static friction displacement for pair of torus-vertex
-    FrictionMap_t  Fdvc;      ///< Static friction displacement for pair of vertex-cylinder
-    FrictionMap_t  Fdcv;      ///< Static friction displacement for pair of cylinder-vertex
+    bool            First;    ///< Is it the first collision?
+    double          Kn;       ///< Normal stiffness
+    double          Kt;       ///< Tengential stiffness
+    double          Gn;       ///< Normal viscous coefficient
+    double          Gt;       ///< Tangential viscous coefficient
+    double          Mu;       ///< Microscpic coefficient of friction
+    double          Epot;     ///< Potential elastic energy
+    double          dEvis;    ///< Energy dissipated in viscosity at time step
+    double          dEfric;   ///< Energy dissipated by friction at time step
+    size_t          Nc;       ///< Number of contacts
+    size_t          Nsc;      ///< Number of sliding contacts
+    size_t          Nr;       ///< Number of rolling contacts (only for spheres)
+    Vec3_t          Fn;       ///< Normal force between elements
+    Vec3_t          Fnet;     ///< Net normal force
+    Vec3_t          Ftnet;    ///< Net tangential force
+    Vec3_t          Xc;       ///< Net Position of the contact
+    Mat3_t          B;        ///< Branch tensor for the study of isotropy
+    ListContacts_t  Lee;      ///< List of edge-edge contacts 
+    ListContacts_t  Lvf;      ///< List of vertex-face contacts 
+    ListContacts_t  Lfv;      ///< List of face-vertex contacts
+    ListContacts_t  Lvt;      ///< List of vertex-torus contacts
+    ListContacts_t  Ltv;      ///< List of torus-vertex contacts
+    ListContacts_t  Lvc;      ///< List of vertex-cylinder contacts
+    ListContacts_t  Lcv;      ///< List of cylinder-vertex contacts
+    FrictionHistory Fdee;     ///< Static friction displacement for pair of edges
+    FrictionHistory Fdvf;     ///< Static friction displacement for pair of vertex-face
+    FrictionHistory Fdfv;     ///< Static friction displacement for pair of face-vertex
+    FrictionHistory Fdvt;     ///< Static friction displacement for pair of vertex-torus
+    FrictionHistory Fdtv;     ///< Static friction displacement for pair of torus-vertex
+    FrictionHistory Fdvc;     ///< Static friction displacement for pair of vertex-cylinder
+    FrictionHistory Fdcv;     ///< Static friction displacement for pair of cylinder-vertex
 protected:
     template<typename FeatureA_T, typename FeatureB_T>
-    bool _update_disp_calc_force (FeatureA_T & A, FeatureB_T & B, FrictionMap_t & FMap, ListContacts_t & L, double dt);
+    bool _update_disp_calc_force (FeatureA_T & A, FeatureB_T & B, FrictionHistory & FMap, ListContacts_t & L, double dt);
     template<typename FeatureA_T, typename FeatureB_T>
-    void _update_contacts        (FeatureA_T & A, FeatureB_T & B, ListContacts_t & L, double alpha);
+    void _update_contacts        (FeatureA_T & A, FeatureB_T & B, ListContacts_t & L, double alpha, bool Cull);
+    template<typename Feature_T>
+    void _near_features          (Feature_T & A, Vec3_t const & X, double Dmax, double Reach, Array<size_t> & Idx);
 };
 
 class CInteractonSphere: public CInteracton // Collision interacton for spheres
@@ -124,6 +144,7 @@ public:
     bool UpdateContacts (double alpha);                 ///< Update contacts by verlet algorithm
     bool CalcForce (double dt = 0.0);                   ///< Calculates the contact force between particles
     void UpdateParameters ();                           ///< Update the parameters
+    bool HasHistory ();                                 ///< Is there any non zero friction or rolling displacement stored?
 
     // Data
     //ListContacts_t Lvv;                            ///< List of edge-edge contacts 
@@ -173,8 +194,73 @@ public:
 
 };
 
+class InteractonPool // Block storage for contact interactons
+{
+public:
+    // Constructor and destructor
+    InteractonPool (size_t TheBlockSize=1024) : BlockSize(TheBlockSize), Next(TheBlockSize), Nlive(0) {} ///< Constructor, objects are stored in blocks of BlockSize slots
+    ~InteractonPool ();                                                                                    ///< Destructor, releases the blocks (the objects must be deleted before)
+
+    // Methods
+    template<typename T>
+    T *    New    (Particle * Pt1, Particle * Pt2);  ///< Construct a CInteracton or a CInteractonSphere in a free slot
+    void   Delete (CInteracton * I);                 ///< Destroy the interacton and recycle its slot
+    size_t Size   () const { return Nlive; }         ///< Number of live interactons
+
+    // Data
+    size_t        BlockSize;                         ///< Number of slots per block
+    size_t        Next;                              ///< Next unused slot of the last block
+    size_t        Nlive;                             ///< Number of live interactons
+    Array<char *> Blocks;                            ///< Contiguous blocks of slots
+    Array<void *> Free;                              ///< Recycled slots
+
+private:
+    static size_t _slot () { return ((sizeof(CInteractonSphere)+63)/64)*64; } ///< Slot size, enough for the largest contact interacton
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////// Implementation /////
 
+// Friction history
+
+inline size_t FrictionHistory::_lower (std::pair<int,int> const & P) const
+{
+    size_t lo = 0;
+    size_t hi = Order.Size();
+    while (lo<hi)
+    {
+        size_t mid = (lo+hi)/2;
+        if (Keys[Order[mid]]<P) lo = mid+1;
+        else                    hi = mid;
+    }
+    return lo;
+}
+
+inline void FrictionHistory::Bind (ListContacts_t const & L)
+{
+    Slot.Resize(L.Size());
+    for (size_t k=0; k<L.Size(); ++k)
+    {
+        size_t m = _lower(L[k]);
+        Slot[k]  = (m<Order.Size()&&Keys[Order[m]]==L[k]) ? Order[m] : -1;
+    }
+}
+
+inline Vec3_t & FrictionHistory::Get (size_t k, ListContacts_t const & L)
+{
+    if (Slot[k]<0)
+    {
+        // Append the pair and insert its position in Order, the slots already bound do not move
+        size_t m = _lower(L[k]);
+        Slot[k]  = Disp.Size();
+        Keys.Push(L[k]);
+        Disp.Push(OrthoSys::O);
+        Order.Push(Slot[k]);
+        for (size_t n=Order.Size()-1; n>m; --n) Order[n] = Order[n-1];
+        Order[m] = Slot[k];
+    }
+    return Disp[Slot[k]];
+}
+
 // Collision interacton
 
 inline CInteracton::CInteracton (Particle * Pt1, Particle * Pt2)
@@ -227,15 +313,23 @@ inline bool CInteracton::UpdateContacts (double alpha)
     Ltv.Resize(0);
     Lvc.Resize(0);
     Lcv.Resize(0);
-    if (Distance(P1->x,P2->x)<=P1->Dmax+P2->Dmax+2*alpha)
+    if (norm(P2->x+Shift-P1->x)<=P1->Dmax+P2->Dmax+2*alpha)
     {
-        _update_contacts (P1->Edges     ,P2->Edges     ,Lee,alpha);
-        _update_contacts (P1->Verts     ,P2->Faces     ,Lvf,alpha);
-        _update_contacts (P1->Faces     ,P2->Verts     ,Lfv,alpha);
-        _update_contacts (P1->Verts     ,P2->Tori      ,Lvt,alpha);
-        _update_contacts (P1->Tori      ,P2->Verts     ,Ltv,alpha);
-        _update_contacts (P1->Verts     ,P2->Cylinders ,Lvc,alpha);
-        _update_contacts (P1->Cylinders ,P2->Verts     ,Lcv,alpha);
+        // Vertices, edges and faces lie inside the bounding sphere of their particle, so these pairs can be culled
+        _update_contacts (P1->Edges     ,P2->Edges     ,Lee,alpha,true );
+        _update_contacts (P1->Verts     ,P2->Faces     ,Lvf,alpha,true );
+        _update_contacts (P1->Faces     ,P2->Verts     ,Lfv,alpha,true );
+        _update_contacts (P1->Verts     ,P2->Tori      ,Lvt,alpha,false);
+        _update_contacts (P1->Tori      ,P2->Verts     ,Ltv,alpha,false);
+        _update_contacts (P1->Verts     ,P2->Cylinders ,Lvc,alpha,false);
+        _update_contacts (P1->Cylinders ,P2->Verts     ,Lcv,alpha,false);
+        Fdee.Bind(Lee);
+        Fdvf.Bind(Lvf);
+        Fdfv.Bind(Lfv);
+        Fdvt.Bind(Lvt);
+        Fdtv.Bind(Ltv);
+        Fdvc.Bind(Lvc);
+        Fdcv.Bind(Lcv);
         if (Lee.Size()>0||Lvf.Size()>0||Lfv.Size()>0||Ltv.Size()>0||Lvt.Size()>0||Lcv.Size()>0||Lvc.Size()>0) return true;
         else return false;
     }
@@ -258,7 +352,7 @@ inline bool CInteracton::CalcForce (double dt)
     F2     = OrthoSys::O;
     T1     = OrthoSys::O;
     T2     = OrthoSys::O;
-    if (norm(P1->x - P2->x) > P1->Dmax + P2->Dmax) return false;
+    if (norm(P1->x - P2->x - Shift) > P1->Dmax + P2->Dmax) return false;
     if (_update_disp_calc_force (P1->Edges     ,P2->Edges     ,Fdee,Lee,dt)) overlap = true;
     if (_update_disp_calc_force (P1->Verts     ,P2->Faces     ,Fdvf,Lvf,dt)) overlap = true;
     if (_update_disp_calc_force (P1->Faces     ,P2->Verts     ,Fdfv,Lfv,dt)) overlap = true;
@@ -301,17 +395,39 @@ inline void CInteracton::UpdateParameters ()
     Mu              = 2*ReducedValue(P1->Props.Mu,P2->Props.Mu);
 }
 
+inline bool CInteracton::HasHistory ()
+{
+    FrictionHistory * FMaps[7] = {&Fdee, &Fdvf, &Fdfv, &Fdvt, &Fdtv, &Fdvc, &Fdcv};
+    for (size_t m=0; m<7; ++m)
+    for (size_t n=0; n<FMaps[m]->Size(); ++n)
+    {
+        if (norm(FMaps[m]->Disp[n])>0.0) return true;
+    }
+    return false;
+}
+
 template<typename FeatureA_T, typename FeatureB_T>
-inline bool CInteracton::_update_disp_calc_force (FeatureA_T & A, FeatureB_T & B, FrictionMap_t & FMap, ListContacts_t & L, double dt)
+inline bool CInteracton::_update_disp_calc_force (FeatureA_T & A, FeatureB_T & B, FrictionHistory & FMap, ListContacts_t & L, double dt)
 {
     // update
+    if (FMap.Slot.Size()!=L.Size()) FMap.Bind(L);
+    bool   image = (dot(Shift,Shift)>0.0);
+    Vec3_t x2c   = P2->x+Shift;
     for (size_t k=0; k<L.Size(); ++k)
     {
         size_t i = L[k].first;
         size_t j = L[k].second;
-        if (!Overlap((*A[i]), (*B[j]),P1->Props.R,P2->Props.R)) continue;
         Vec3_t xi, xf;
-        Distance ((*A[i]), (*B[j]), xi, xf);
+        if (image)
+        {
+            if (!Overlap((*A[i]), (*B[j]),Shift,P1->Props.R,P2->Props.R)) continue;
+            Distance ((*A[i]), (*B[j]), Shift, xi, xf);
+        }
+        else
+        {
+            if (!Overlap((*A[i]), (*B[j]),P1->Props.R,P2->Props.R)) continue;
+            Distance ((*A[i]), (*B[j]), xi, xf);
+        }
         double dist  = norm(xf-xi);
         double delta = P1->Props.R + P2->Props.R - dist;
         if (delta>0)
@@ -358,27 +474,25 @@ inline bool CInteracton::_update_disp_calc_force (FeatureA_T & A, FeatureB_T & B
             Rotation(P1->w,P1->Q,t1);
             Rotation(P2->w,P2->Q,t2);
             x1 = x - P1->x;
-            x2 = x - P2->x;
+            x2 = x - x2c;
             Vec3_t vrel = -((P2->v-P1->v)+cross(t2,x2)-cross(t1,x1));
             Vec3_t vt = vrel - dot(n,vrel)*n;
             Fn = Kn*delta*n;
             Fnet += Fn;
-            std::pair<int,int> p;
-            p = std::make_pair(i,j);
-            if (FMap.count(p)==0) FMap[p] = OrthoSys::O;
-            FMap[p] += vt*dt;
-            FMap[p] -= dot(FMap[p],n)*n;
-            Vec3_t tan = FMap[p];
+            Vec3_t & Fd = FMap.Get(k,L);
+            Fd += vt*dt;
+            Fd -= dot(Fd,n)*n;
+            Vec3_t tan = Fd;
             if (norm(tan)>0.0) tan/=norm(tan);
-            if (norm(FMap[p])>Mu*norm(Fn)/Kt)
+            if (norm(Fd)>Mu*norm(Fn)/Kt)
             {
                 // Count a sliding contact
                 Nsc++;
-                FMap[p] = Mu*norm(Fn)/Kt*tan;
-                dEfric += Kt*dot(FMap[p],vt)*dt;
+                Fd = Mu*norm(Fn)/Kt*tan;
+                dEfric += Kt*dot(Fd,vt)*dt;
             }
-            Ftnet += Kt*FMap[p];
-            Vec3_t F = Fn + Kt*FMap[p] + Gn*dot(n,vrel)*n + Gt*vt;
+            Ftnet += Kt*Fd;
+            Vec3_t F = Fn + Kt*Fd + Gn*dot(n,vrel)*n + Gt*vt;
 
 
 
@@ -412,7 +526,7 @@ inline bool CInteracton::_update_disp_calc_force (FeatureA_T & A, FeatureB_T & B
             T2 += T;
             //Transfering the branch vector information
             Vec3_t nor = n;
-            Vec3_t dif = P2->x - P1->x;
+            Vec3_t dif = x2c - P1->x;
             //if (P1->IsFree()&&P2->IsFree())
             //{
                 //for (size_t m=0;m<3;m++)
@@ -435,20 +549,52 @@ inline bool CInteracton::_update_disp_calc_force (FeatureA_T & A, FeatureB_T & B
     //std::cout << P1->Index << " " << P2->Index << std::endl;
 
             // potential energy
-            Epot += 0.5*Kn*delta*delta+0.5*Kt*dot(FMap[p],FMap[p]);
+            Epot += 0.5*Kn*delta*delta+0.5*Kt*dot(Fd,Fd);
         }
     }
     return false;
 }
 
 template<typename FeatureA_T, typename FeatureB_T>
-inline void CInteracton::_update_contacts (FeatureA_T & A, FeatureB_T & B, ListContacts_t & L, double alpha)
+inline void CInteracton::_update_contacts (FeatureA_T & A, FeatureB_T & B, ListContacts_t & L, double alpha, bool Cull)
 {
-    for (size_t i=0; i<A.Size(); ++i)
-    for (size_t j=0; j<B.Size(); ++j)
+    if (A.Size()==0||B.Size()==0) return;
+
+    // Features of each particle that may reach the other one, all of them if there is no culling
+    Array<size_t> IA, IB;
+    if (Cull)
+    {
+        _near_features (A,P2->x+Shift,P2->Dmax,P1->Props.R+2*alpha,IA);
+        _near_features (B,P1->x-Shift,P1->Dmax,P2->Props.R+2*alpha,IB);
+    }
+    else
+    {
+        IA.Resize(A.Size());
+        IB.Resize(B.Size());
+        for (size_t i=0; i<A.Size(); ++i) IA[i] = i;
+        for (size_t j=0; j<B.Size(); ++j) IB[j] = j;
+    }
+
+    bool image = (dot(Shift,Shift)>0.0);
+    for (size_t a=0; a<IA.Size(); ++a)
+    for (size_t b=0; b<IB.Size(); ++b)
     {
-        if (!Overlap ((*A[i]), (*B[j]),P1->Props.R + alpha,P2->Props.R + alpha)) continue;
-        if (Distance ((*A[i]), (*B[j]))<=P1->Props.R+P2->Props.R+2*alpha)
+        size_t i = IA[a];
+        size_t j = IB[b];
+        double dist;
+        if (image)
+        {
+            if (!Overlap ((*A[i]), (*B[j]),Shift,P1->Props.R + alpha,P2->Props.R + alpha)) continue;
+            Vec3_t xi, xf;
+            Distance ((*A[i]), (*B[j]), Shift, xi, xf);
+            dist = norm(xf-xi);
+        }
+        else
+        {
+            if (!Overlap ((*A[i]), (*B[j]),P1->Props.R + alpha,P2->Props.R + alpha)) continue;
+            dist = Distance ((*A[i]), (*B[j]));
+        }
+        if (dist<=P1->Props.R+P2->Props.R+2*alpha)
         {
             std::pair<int,int> p;
             p = std::make_pair(i,j);
@@ -457,6 +603,21 @@ inline void CInteracton::_update_contacts (FeatureA_T & A, FeatureB_T & B, ListC
     }
 }
 
+template<typename Feature_T>
+inline void CInteracton::_near_features (Feature_T & A, Vec3_t const & X, double Dmax, double Reach, Array<size_t> & Idx)
+{
+    // The skeleton of the other particle lies inside the sphere of radius Dmax-R around its centre X, so a
+    // feature of A farther than its own radius plus Dmax plus Reach cannot get within Reach of its surface
+    Idx.Resize(0);
+    for (size_t i=0; i<A.Size(); ++i)
+    {
+        Vec3_t C;
+        double R;
+        BoundingSphere ((*A[i]),C,R);
+        if (norm(C-X)<=R+Dmax+Reach) Idx.Push(i);
+    }
+}
+
 //Collision interacton for spheres
 
 inline CInteractonSphere::CInteractonSphere (Particle * Pt1, Particle * Pt2)
@@ -587,8 +748,8 @@ inline bool CInteractonSphere::CalcForce(double dt)
     //if (Epot>0.0) _update_rolling_resistance(dt);
 
     Vec3_t xi = P1->x;
-    Vec3_t xf = P2->x;
-    double dist = norm(P1->x - P2->x);
+    Vec3_t xf = P2->x+Shift;
+    double dist = norm(xi - xf);
     double delta = P1->Props.R + P2->Props.R - dist;
 
     if (delta>0)
@@ -633,7 +794,7 @@ inline bool CInteractonSphere::CalcForce(double dt)
         Rotation(P1->w,P1->Q,t1);
         Rotation(P2->w,P2->Q,t2);
         x1 = x - P1->x;
-        x2 = x - P2->x;
+        x2 = x - xf;
         Vec3_t vrel = -((P2->v-P1->v)+cross(t2,x2)-cross(t1,x1));
         Vec3_t vt = vrel - dot(n,vrel)*n;
         
@@ -732,10 +893,15 @@ inline bool CInteractonSphere::CalcForce(double dt)
 
 inline bool CInteractonSphere::UpdateContacts (double alpha)
 {
-    if (Distance(P1->x,P2->x)<=P1->Dmax+P2->Dmax+2*alpha) return true;
+    if (norm(P2->x+Shift-P1->x)<=P1->Dmax+P2->Dmax+2*alpha) return true;
     else return false;
 }
 
+inline bool CInteractonSphere::HasHistory ()
+{
+    return (norm(Fdvv)>0.0||norm(Fdr)>0.0);
+}
+
 inline void CInteractonSphere::UpdateParameters ()
 {
     Kn   = 2*ReducedValue(P1->Props.Kn,P2->Props.Kn);
@@ -937,5 +1103,42 @@ inline void BInteracton::UpdateParameters ()
     I2              = P2->Index;
 }
 
+// Interacton pool
+
+inline InteractonPool::~InteractonPool ()
+{
+    for (size_t i=0; i<Blocks.Size(); ++i) ::operator delete(Blocks[i]);
+}
+
+template<typename T>
+inline T * InteractonPool::New (Particle * Pt1, Particle * Pt2)
+{
+    void * slot;
+    if (Free.Size()>0)
+    {
+        slot = Free[Free.Size()-1];
+        Free.Resize(Free.Size()-1);
+    }
+    else
+    {
+        if (Next==BlockSize)
+        {
+            Blocks.Push(static_cast<char *>(::operator new(BlockSize*_slot())));
+            Next = 0;
+        }
+        slot = Blocks[Blocks.Size()-1] + Next*_slot();
+        Next++;
+    }
+    Nlive++;
+    return new (slot) T(Pt1,Pt2);
+}
+
+inline void InteractonPool::Delete (CInteracton * I)
+{
+    I->~CInteracton();
+    Free.Push(I);
+    Nlive--;
+}
+
 }
 #endif //  MECHSYS_DEM_INTERACTON_H
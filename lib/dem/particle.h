@@ -74,7 +74,7 @@ public:
     void poly_calc_props     (Array<Vec3_t> & V);                        ///< Calculates properties for polyhedra
 
     // Constructor
-    Particle() {}
+    Particle() : Id(-1) {}
     Particle(int                         Tag,      ///< Tag of the particle
              Array<Vec3_t>       const & V,        ///< List of vertices
              Array<Array <int> > const & E,        ///< List of edges with connectivity
@@ -116,6 +116,7 @@ public:
 
     int             Tag;             ///< Tag of the particle
     size_t          Index;           ///< index of the particle in the domain
+    int             Id;              ///< Identifier kept when the domain reorders its particles (-1 until the domain sets it)
     int             Cluster;         ///< The number of the cohesive cluster the particle belongs to.
     bool            PropsReady;      ///< Are the properties calculated ready ?
     bool            Eroded;          ///< True if the particle has been eroded
@@ -180,6 +181,7 @@ std::ostream & operator<< (std::ostream & os, Particle const & P)
 {
     os << "Tag           = "  << P.Tag        << std::endl;
     os << "Index         = "  << P.Index      << std::endl;
+    os << "Id            = "  << P.Id         << std::endl;
     os << "PropsReady    = "  << P.PropsReady << std::endl;
     os << "vxf, vyf, vzf = "  << P.vxf << ", " << P.vyf << ", " << P.vzf << std::endl;
     os << "wxf, wyf, wzf = "  << P.wxf << ", " << P.wyf << ", " << P.wzf << std::endl;
@@ -295,7 +297,7 @@ inline void Particle::poly_calc_props(Array<Vec3_t> & V)
 }
 
 inline Particle::Particle (int TheTag, Array<Vec3_t> const & V, Array<Array <int> > const & E, Array<Array <int> > const & Fa, Vec3_t const & v0, Vec3_t const & w0, double TheR, double TheRho)
-    : Tag(TheTag), Cluster(0), PropsReady(false), Eroded(false), v(v0), w(w0)
+    : Tag(TheTag), Id(-1), Cluster(0), PropsReady(false), Eroded(false), v(v0), w(w0)
 {
     // default values
     init_default_values(TheTag, TheR, TheRho);
@@ -322,7 +324,7 @@ inline Particle::Particle (int TheTag, Array<Vec3_t> const & V, Array<Array <int
 }
 
 inline Particle::Particle (int TheTag, Mesh::Generic const & M, double TheR, double TheRho)
-    : Tag(TheTag), Cluster(0), PropsReady(false), Eroded(false), v(Vec3_t(0.0,0.0,0.0)), w(Vec3_t(0.0,0.0,0.0))
+    : Tag(TheTag), Id(-1), Cluster(0), PropsReady(false), Eroded(false), v(Vec3_t(0.0,0.0,0.0)), w(Vec3_t(0.0,0.0,0.0))
 {
     // default values
     init_default_values(TheTag, TheR, TheRho);
@@ -389,7 +391,7 @@ inline Particle::Particle (int TheTag, Mesh::Generic const & M, double TheR, dou
 }
 
 inline Particle::Particle(int TheTag, char const * TheFileKey, double TheR, double TheRho, double scale)
-    : Tag(TheTag), Cluster(0), PropsReady(false), Eroded(false), v(Vec3_t(0.0,0.0,0.0)), w(Vec3_t(0.0,0.0,0.0))
+    : Tag(TheTag), Id(-1), Cluster(0), PropsReady(false), Eroded(false), v(Vec3_t(0.0,0.0,0.0)), w(Vec3_t(0.0,0.0,0.0))
 {
     // default values
     init_default_values(TheTag, TheR, TheRho);
@@ -392,7 +392,7 @@ inline void Dilation(Array<Vec3_t> & V, Array<Array<int> > & E, Array<Array <int
 
 inline double SphereCube (Vec3_t & Xs, Vec3_t & Xc, double R, double dx) // Calculates the volume of intersection between a Cube and a Sphere
 {
-    Array<Vec3_t> P(8);
+    Vec3_t P[8];
     P[0] = Xc - 0.5*dx*OrthoSys::e0 - 0.5*dx*OrthoSys::e1 + 0.5*dx*OrthoSys::e2; 
     P[1] = Xc + 0.5*dx*OrthoSys::e0 - 0.5*dx*OrthoSys::e1 + 0.5*dx*OrthoSys::e2;
     P[2] = Xc + 0.5*dx*OrthoSys::e0 + 0.5*dx*OrthoSys::e1 + 0.5*dx*OrthoSys::e2;
@@ -404,7 +404,7 @@ inline double SphereCube (Vec3_t & Xs, Vec3_t & Xc, double R, double dx) // Calc
     
     double dmin = 2*R;
     double dmax = 0.0;
-    for (size_t j=0;j<P.Size();j++)
+    for (size_t j=0;j<8;j++)
     {
         double dist = norm(P[j] - Xs);
         if (dmin>dist) dmin = dist;
@@ -472,7 +472,7 @@ inline double SphereCube (Vec3_t & Xs, Vec3_t & Xc, double R, double dx) // Calc
 
 inline double DiskSquare (Vec3_t & Xs, Vec3_t & Xc, double R, double dx) // Calculates the area of intersection between a Square an a Disk
 {
-    Array<Vec3_t> P(4);
+    Vec3_t P[4];
     P[0] = Xc - 0.5*dx*OrthoSys::e0 - 0.5*dx*OrthoSys::e1 + 0.5*dx*OrthoSys::e2; 
     P[1] = Xc + 0.5*dx*OrthoSys::e0 - 0.5*dx*OrthoSys::e1 + 0.5*dx*OrthoSys::e2;
     P[2] = Xc + 0.5*dx*OrthoSys::e0 + 0.5*dx*OrthoSys::e1 + 0.5*dx*OrthoSys::e2;
@@ -480,7 +480,7 @@ inline double DiskSquare (Vec3_t & Xs, Vec3_t & Xc, double R, double dx) // Calc
     
     double dmin = 2*R;
     double dmax = 0.0;
-    for (size_t j=0;j<P.Size();j++)
+    for (size_t j=0;j<4;j++)
     {
         double dist = norm(P[j] - Xs);
         if (dmin>dist) dmin = dist;
@@ -513,6 +513,115 @@ inline double DiskSquare (Vec3_t & Xs, Vec3_t & Xc, double R, double dx) // Calc
     return len;
 }
 
+// The overlap lengths of SphereCube and DiskSquare depend on the direction from the sphere to the cell and
+// not only on their distance, OverlapTable keeps their mean over the directions in units of dx, sampled
+// along the partial band (d-R)/dx in [-H,1+H] (H the half diagonal of the cell) for a range of R/dx and
+// interpolated bilinearly. Outside of the band the lengths are exact (full cell or zero).
+// Being an average over the directions, the table is not an approximation of the length of a given cell:
+// the weight gamma of a single partial cell may be off by up to half a cell (about 0.03-0.05 on average),
+// while the sums over the band, such as the solid volume of a particle, agree within about 1 %.
+class OverlapTable
+{
+public:
+    // Constructor
+    OverlapTable () : Dim(3), Ns(0), Nr(0), H(0.0), Full(0.0), R0(0.0), Dr(0.0), Ds(0.0) {}
+
+    // Methods
+    void   Build (size_t TheDim, double Rmin, double Rmax, size_t TheNs=128, size_t TheNr=32, size_t Ndir=128); ///< Tabulate SphereCube (TheDim=3) or DiskSquare (TheDim=2) for radii Rmin to Rmax given in units of dx
+    double Len   (double d, double R, double dx) const;                                                             ///< Mean overlap length of a cell whose center is at a distance d from a sphere (disk) of radius R
+    bool   Covers(size_t TheDim, double Rmin, double Rmax) const;                                                   ///< The table was built for this dimension and radii range (in units of dx)
+
+    // Data
+    size_t        Dim;   ///< 3 for SphereCube and 2 for DiskSquare
+    size_t        Ns;    ///< Number of samples of (d-R)/dx
+    size_t        Nr;    ///< Number of samples of R/dx
+    double        H;     ///< Half diagonal of the cell in units of dx
+    double        Full;  ///< Length of a fully covered cell in units of dx (12 or 4)
+    double        R0;    ///< First sample of R/dx
+    double        Dr;    ///< Spacing of the samples of R/dx
+    double        Ds;    ///< Spacing of the samples of (d-R)/dx
+    Array<double> L;     ///< Mean lengths in units of dx, sample (is,ir) at L[ir*Ns+is]
+};
+
+inline void OverlapTable::Build (size_t TheDim, double Rmin, double Rmax, size_t TheNs, size_t TheNr, size_t Ndir)
+{
+    if (TheDim!=2&&TheDim!=3) throw new Fatal("OverlapTable::Build: Dim must be 2 or 3");
+    if (Rmin<=0.0||Rmax<Rmin) throw new Fatal("OverlapTable::Build: The radii range (%g,%g) is not valid",Rmin,Rmax);
+    Dim  = TheDim;
+    Ns   = std::max(TheNs,(size_t)2);
+    Nr   = (Rmax-Rmin<1.0e-9*Rmax) ? 1 : std::max(TheNr,(size_t)2);
+    H    = (Dim==3) ? 0.5*sqrt(3.0) : 0.5*sqrt(2.0);
+    Full = (Dim==3) ? 12.0 : 4.0;
+    R0   = Rmin;
+    Dr   = (Nr>1) ? (Rmax-Rmin)/(Nr-1) : 0.0;
+    Ds   = (1.0+2.0*H)/(Ns-1);
+    L.Resize(Ns*Nr);
+
+    // Directions evenly spread over the sphere (Fibonacci lattice), or over the first octant of the circle
+    // which by symmetry of the square gives the whole mean
+    Array<Vec3_t> N(Ndir);
+    for (size_t k=0;k<Ndir;k++)
+    {
+        if (Dim==3)
+        {
+            double z   = 1.0 - (2.0*k+1.0)/Ndir;
+            double r   = sqrt(1.0-z*z);
+            double phi = k*M_PI*(3.0-sqrt(5.0));
+            N[k] = r*cos(phi),r*sin(phi),z;
+        }
+        else
+        {
+            double phi = 0.25*M_PI*(k+0.5)/Ndir;
+            N[k] = cos(phi),sin(phi),0.0;
+        }
+    }
+
+    Vec3_t Xs(OrthoSys::O);
+    for (size_t ir=0;ir<Nr;ir++)
+    for (size_t is=0;is<Ns;is++)
+    {
+        double R = R0 + ir*Dr;
+        double d = std::max(R - H + is*Ds,0.0);
+        double l = 0.0;
+        for (size_t k=0;k<Ndir;k++)
+        {
+            Vec3_t Xc(d*N[k]);
+            l += (Dim==3) ? SphereCube(Xs,Xc,R,1.0) : DiskSquare(Xs,Xc,R,1.0);
+        }
+        L[ir*Ns+is] = l/Ndir;
+    }
+    // The ends of the band are a full and an empty cell whatever the direction
+    for (size_t ir=0;ir<Nr;ir++)
+    {
+        L[ir*Ns]        = Full;
+        L[ir*Ns+Ns-1]   = 0.0;
+    }
+}
+
+inline double OverlapTable::Len (double d, double R, double dx) const
+{
+    double s = (d-R)/dx + H;
+    if (s<=0.0)          return Full*dx;
+    if (s>=1.0+2.0*H)    return 0.0;
+    double fs = s/Ds;
+    size_t is = std::min((size_t)fs,Ns-2);
+    fs -= is;
+    double const * l = L.GetPtr() + is;
+    if (Nr==1) return ((1.0-fs)*l[0] + fs*l[1])*dx;
+    double fr = std::min(std::max((R/dx-R0)/Dr,0.0),double(Nr-1));
+    size_t ir = std::min((size_t)fr,Nr-2);
+    fr -= ir;
+    l += ir*Ns;
+    return ((1.0-fr)*((1.0-fs)*l[0] + fs*l[1]) + fr*((1.0-fs)*l[Ns] + fs*l[Ns+1]))*dx;
+}
+
+inline bool OverlapTable::Covers (size_t TheDim, double Rmin, double Rmax) const
+{
+    if (Ns==0||Dim!=TheDim) return false;
+    double tol = 1.0e-9*Rmax;
+    return Rmin>=R0-tol&&Rmax<=R0+(Nr-1)*Dr+tol;
+}
+
 inline size_t Pt2idx(iVec3_t & iv, iVec3_t & Dim) // Calculates the index of the cell at coordinates iv for a cubic lattice of dimensions Dim
 {
     return iv(0) + iv(1)*Dim(0) + iv(2)*Dim(0)*Dim(1);
@@ -0,0 +1,347 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+#ifndef MECHSYS_DEM_SPHEREPAIRS_H
+#define MECHSYS_DEM_SPHEREPAIRS_H
+
+// Std lib
+#include <stdint.h> // for uint64_t
+#include <algorithm>
+#ifdef USE_OMP
+    #include <omp.h>
+#endif
+
+// MechSys
+#include <mechsys/dem/particle.h>
+#include <mechsys/dem/basic_functions.h>
+#include <mechsys/util/array.h>
+#include <mechsys/util/fatal.h>
+
+namespace DEM
+{
+
+/** Contact forces between spheres kept as a structure of arrays.
+ *  Reset is called after each rebuild of the contact lists with the sphere pairs that may touch
+ *  before the next one. It mixes the constants of every pair once and carries over the friction
+ *  and rolling displacements of the pairs that were already in the list. CalcForces copies the
+ *  particle states to flat arrays, runs a single loop over the pairs without any map look up or
+ *  lock, and gathers the results per particle. */
+class SpherePairs
+{
+public:
+    // Constructor
+    SpherePairs () : Npar(0) {}
+
+    // Methods
+    size_t Size      () const { return I.Size(); }                                             ///< Number of sphere pairs
+    void   Reset     (Array<Particle*> const & Particles, Array<size_t> const & Pi,
+                      Array<size_t> const & Pj, Array<Vec3_t> const & Ps, size_t Nproc=1);      ///< Set the pairs (Pi[n],Pj[n]) with image shifts Ps[n]
+    void   CalcForces(Array<Particle*> & Particles, double Dt, size_t Nproc=1);                ///< Add the contact forces and torques to the particles
+    void   Renumber  (Array<size_t> const & NewIndex);                                         ///< Follow a reordering of the particles, particle i becomes NewIndex[i]
+
+    // Pair data
+    Array<size_t>   I,J;              ///< Particle indices of each pair, sorted by (I,J)
+    Array<double>   Sx,Sy,Sz;         ///< Image shift of J as seen by I
+    Array<double>   Kn,Kt,Gn,Gt;      ///< Mixed stiffnesses and damping coefficients
+    Array<double>   Mu,Kr,EtaMu,Rr;   ///< Friction coefficient, rolling stiffness, rolling limit and reduced radius
+    Array<double>   Dx,Dy,Dz;         ///< Tangential (friction) displacement
+    Array<double>   Ux,Uy,Uz;         ///< Rolling displacement
+    Array<double>   Fx,Fy,Fz;         ///< Force on J of the last step
+    Array<double>   T1x,T1y,T1z;      ///< Torque on I of the last step in the global frame
+    Array<double>   T2x,T2y,T2z;      ///< Torque on J of the last step in the global frame
+
+    // Particle data
+    size_t          Npar;             ///< Number of particles
+    Array<double>   X,Y,Z;            ///< Centres
+    Array<double>   Vx,Vy,Vz;         ///< Velocities
+    Array<double>   Wx,Wy,Wz;         ///< Angular velocities in the global frame
+    Array<double>   R;                ///< Radii
+    Array<size_t>   Off;              ///< Start of the pair ends of each particle in Ends
+    Array<size_t>   Ends;             ///< 2*pair for the I end and 2*pair+1 for the J end, grouped by particle
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////// Implementation /////
+
+
+inline void SpherePairs::Reset (Array<Particle*> const & Particles, Array<size_t> const & Pi, Array<size_t> const & Pj, Array<Vec3_t> const & Ps, size_t Nproc)
+{
+    // Sort the new pairs so their history can be found in the old ones with a single merge
+    size_t Np = Pi.Size();
+    Array<std::pair<uint64_t,size_t> > key(Np);
+    for (size_t n=0;n<Np;n++) key[n] = std::make_pair((uint64_t(Pi[n])<<32)|uint64_t(Pj[n]),n);
+    std::sort(key.begin(),key.end());
+
+    Array<double> dx(Np),dy(Np),dz(Np),ux(Np),uy(Np),uz(Np);
+    size_t m = 0;
+    for (size_t n=0;n<Np;n++)
+    {
+        while (m<I.Size()&&((uint64_t(I[m])<<32)|uint64_t(J[m]))<key[n].first) m++;
+        if (m<I.Size()&&((uint64_t(I[m])<<32)|uint64_t(J[m]))==key[n].first)
+        {
+            dx[n] = Dx[m]; dy[n] = Dy[m]; dz[n] = Dz[m];
+            ux[n] = Ux[m]; uy[n] = Uy[m]; uz[n] = Uz[m];
+        }
+        else
+        {
+            dx[n] = dy[n] = dz[n] = 0.0;
+            ux[n] = uy[n] = uz[n] = 0.0;
+        }
+    }
+    Dx = dx; Dy = dy; Dz = dz;
+    Ux = ux; Uy = uy; Uz = uz;
+
+    I .Resize(Np); J .Resize(Np); Sx.Resize(Np); Sy.Resize(Np); Sz.Resize(Np);
+    Kn.Resize(Np); Kt.Resize(Np); Gn.Resize(Np); Gt.Resize(Np);
+    Mu.Resize(Np); Kr.Resize(Np); EtaMu.Resize(Np); Rr.Resize(Np);
+    Fx .Resize(Np); Fy .Resize(Np); Fz .Resize(Np);
+    T1x.Resize(Np); T1y.Resize(Np); T1z.Resize(Np);
+    T2x.Resize(Np); T2y.Resize(Np); T2z.Resize(Np);
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+#endif
+    for (size_t n=0;n<Np;n++)
+    {
+        size_t k = key[n].second;
+        Particle * P1 = Particles[Pi[k]];
+        Particle * P2 = Particles[Pj[k]];
+        I [n] = Pi[k];
+        J [n] = Pj[k];
+        Sx[n] = Ps[k](0);
+        Sy[n] = Ps[k](1);
+        Sz[n] = Ps[k](2);
+
+        // Same mixing rules as the per pair Domain::CalcForceSphere it replaces (Kn is not doubled, unlike CInteractonSphere)
+        double kn   = ReducedValue(P1->Props.Kn,P2->Props.Kn);
+        double kt   = 2*ReducedValue(P1->Props.Kt,P2->Props.Kt);
+        double me   = ReducedValue(P1->Props.m ,P2->Props.m );
+        double gn   = 2*ReducedValue(P1->Props.Gn,P2->Props.Gn);
+        double gt   = 2*ReducedValue(P1->Props.Gt,P2->Props.Gt);
+        double beta = 2*ReducedValue(P1->Props.Beta,P2->Props.Beta);
+        double eta  = 2*ReducedValue(P1->Props.Eta,P2->Props.Eta);
+        double mu   = 0.0;
+        if (P1->Props.Mu>1.0e-12&&P2->Props.Mu>1.0e-12) mu = std::max(P1->Props.Mu,P2->Props.Mu);
+        if (gn < -0.001)
+        {
+            if (fabs(gn)>1.0) throw new Fatal("SpherePairs::Reset the restitution coefficient is greater than 1");
+            gn = 2.0*sqrt((pow(log(-gn),2.0)*(kn/me))/(M_PI*M_PI+pow(log(-gn),2.0)));
+            gt = 0.0;
+        }
+        Kn   [n] = kn;
+        Kt   [n] = kt;
+        Gn   [n] = gn*me;
+        Gt   [n] = gt*me;
+        Mu   [n] = mu;
+        Kr   [n] = beta*kt;
+        EtaMu[n] = eta*mu;
+        Rr   [n] = P1->Props.R*P2->Props.R/(P1->Props.R+P2->Props.R);
+    }
+
+    // Ends of the pairs grouped by particle, in pair order so the sums do not depend on the threads
+    Npar = Particles.Size();
+    Off.Resize(Npar+1);
+    for (size_t i=0;i<=Npar;i++) Off[i] = 0;
+    for (size_t n=0;n<Np;n++)
+    {
+        Off[I[n]+1]++;
+        Off[J[n]+1]++;
+    }
+    for (size_t i=0;i<Npar;i++) Off[i+1] += Off[i];
+    Array<size_t> pos(Npar);
+    for (size_t i=0;i<Npar;i++) pos[i] = Off[i];
+    Ends.Resize(2*Np);
+    for (size_t n=0;n<Np;n++)
+    {
+        Ends[pos[I[n]]++] = 2*n;
+        Ends[pos[J[n]]++] = 2*n+1;
+    }
+
+    X .Resize(Npar); Y .Resize(Npar); Z .Resize(Npar);
+    Vx.Resize(Npar); Vy.Resize(Npar); Vz.Resize(Npar);
+    Wx.Resize(Npar); Wy.Resize(Npar); Wz.Resize(Npar);
+    R .Resize(Npar);
+}
+
+inline void SpherePairs::Renumber (Array<size_t> const & NewIndex)
+{
+    // Only the indices and the history are needed by the next Reset
+    size_t Np = I.Size();
+    Array<std::pair<uint64_t,size_t> > key(Np);
+    for (size_t n=0;n<Np;n++)
+    {
+        size_t i = NewIndex[I[n]];
+        size_t j = NewIndex[J[n]];
+        key[n] = std::make_pair((uint64_t(std::min(i,j))<<32)|uint64_t(std::max(i,j)),n);
+    }
+    std::sort(key.begin(),key.end());
+    Array<size_t> ni(Np),nj(Np);
+    Array<double> dx(Np),dy(Np),dz(Np),ux(Np),uy(Np),uz(Np);
+    for (size_t n=0;n<Np;n++)
+    {
+        size_t k = key[n].second;
+        ni[n] = key[n].first>>32;
+        nj[n] = key[n].first&0xffffffff;
+        // Swapping the ends flips the normal and the tangential displacement with it, the rolling one does not change
+        double s = NewIndex[I[k]]<NewIndex[J[k]] ? 1.0 : -1.0;
+        dx[n] = s*Dx[k]; dy[n] = s*Dy[k]; dz[n] = s*Dz[k];
+        ux[n] = Ux[k];   uy[n] = Uy[k];   uz[n] = Uz[k];
+    }
+    I  = ni; J  = nj;
+    Dx = dx; Dy = dy; Dz = dz;
+    Ux = ux; Uy = uy; Uz = uz;
+}
+
+inline void SpherePairs::CalcForces (Array<Particle*> & Particles, double Dt, size_t Nproc)
+{
+    if (Npar!=Particles.Size()) throw new Fatal("SpherePairs::CalcForces the number of particles changed since the last Reset");
+
+    // Particle states as flat arrays
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+#endif
+    for (size_t i=0;i<Npar;i++)
+    {
+        if (Off[i]==Off[i+1]) continue;
+        Particle * P = Particles[i];
+        Vec3_t t;
+        Rotation(P->w,P->Q,t);
+        X [i] = P->x(0); Y [i] = P->x(1); Z [i] = P->x(2);
+        Vx[i] = P->v(0); Vy[i] = P->v(1); Vz[i] = P->v(2);
+        Wx[i] = t(0);    Wy[i] = t(1);    Wz[i] = t(2);
+        R [i] = P->Props.R;
+    }
+
+    // Pair forces and torques, every pair writes only its own slots
+    size_t Np = I.Size();
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+#endif
+    for (size_t p=0;p<Np;p++)
+    {
+        size_t i = I[p];
+        size_t j = J[p];
+        double r1 = R[i];
+        double r2 = R[j];
+        double ex = X[j]+Sx[p]-X[i];
+        double ey = Y[j]+Sy[p]-Y[i];
+        double ez = Z[j]+Sz[p]-Z[i];
+        double dist  = sqrt(ex*ex+ey*ey+ez*ez);
+        double delta = r1+r2-dist;
+        if (!(delta>0))
+        {
+            Fx [p] = Fy [p] = Fz [p] = 0.0;
+            T1x[p] = T1y[p] = T1z[p] = 0.0;
+            T2x[p] = T2y[p] = T2z[p] = 0.0;
+            continue;
+        }
+
+        // Normal and branch vectors from the centres to the contact point
+        double nx = ex/dist, ny = ey/dist, nz = ez/dist;
+        double a  = (r1*r1-r2*r2+dist*dist)/(2*dist);
+        double ax = nx*a, ay = ny*a, az = nz*a;
+        double bx = ax-ex, by = ay-ey, bz = az-ez;
+
+        // Relative velocity at the contact point
+        double vx = -((Vx[j]-Vx[i])+(Wy[j]*bz-Wz[j]*by)-(Wy[i]*az-Wz[i]*ay));
+        double vy = -((Vy[j]-Vy[i])+(Wz[j]*bx-Wx[j]*bz)-(Wz[i]*ax-Wx[i]*az));
+        double vz = -((Vz[j]-Vz[i])+(Wx[j]*by-Wy[j]*bx)-(Wx[i]*ay-Wy[i]*ax));
+        double vn = nx*vx+ny*vy+nz*vz;
+        double tx = vx-vn*nx, ty = vy-vn*ny, tz = vz-vn*nz;
+
+        // Sliding friction
+        double fn = Kn[p]*delta;
+        double dx = Dx[p]+tx*Dt, dy = Dy[p]+ty*Dt, dz = Dz[p]+tz*Dt;
+        double dn = dx*nx+dy*ny+dz*nz;
+        dx -= dn*nx; dy -= dn*ny; dz -= dn*nz;
+        double dd = sqrt(dx*dx+dy*dy+dz*dz);
+        double dl = Mu[p]*fn/Kt[p];
+        if (dd>dl)
+        {
+            double s = dl/dd;
+            dx *= s; dy *= s; dz *= s;
+        }
+        Dx[p] = dx; Dy[p] = dy; Dz[p] = dz;
+        double fx = fn*nx + Kt[p]*dx + Gn[p]*vn*nx + Gt[p]*tx;
+        double fy = fn*ny + Kt[p]*dy + Gn[p]*vn*ny + Gt[p]*ty;
+        double fz = fn*nz + Kt[p]*dz + Gn[p]*vn*nz + Gt[p]*tz;
+
+        // Rolling resistance
+        double wx = Wx[i]-Wx[j], wy = Wy[i]-Wy[j], wz = Wz[i]-Wz[j];
+        double ux = Ux[p]+Rr[p]*(wy*nz-wz*ny)*Dt;
+        double uy = Uy[p]+Rr[p]*(wz*nx-wx*nz)*Dt;
+        double uz = Uz[p]+Rr[p]*(wx*ny-wy*nx)*Dt;
+        double un = ux*nx+uy*ny+uz*nz;
+        ux -= un*nx; uy -= un*ny; uz -= un*nz;
+        double uu = sqrt(ux*ux+uy*uy+uz*uz);
+        double ul = EtaMu[p]*fn/Kr[p];
+        if (uu>ul)
+        {
+            double s = ul/uu;
+            ux *= s; uy *= s; uz *= s;
+        }
+        Ux[p] = ux; Uy[p] = uy; Uz[p] = uz;
+        double rx = -Kr[p]*(ny*uz-nz*uy);
+        double ry = -Kr[p]*(nz*ux-nx*uz);
+        double rz = -Kr[p]*(nx*uy-ny*ux);
+
+        Fx [p] = fx;
+        Fy [p] = fy;
+        Fz [p] = fz;
+        T1x[p] = -(ay*fz-az*fy) + r1*rx;
+        T1y[p] = -(az*fx-ax*fz) + r1*ry;
+        T1z[p] = -(ax*fy-ay*fx) + r1*rz;
+        T2x[p] =  (by*fz-bz*fy) - r2*rx;
+        T2y[p] =  (bz*fx-bx*fz) - r2*ry;
+        T2z[p] =  (bx*fy-by*fx) - r2*rz;
+    }
+
+    // Gather per particle and rotate the torque to the body frame once
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+#endif
+    for (size_t i=0;i<Npar;i++)
+    {
+        if (Off[i]==Off[i+1]) continue;
+        Vec3_t F(0.0,0.0,0.0);
+        Vec3_t Tt(0.0,0.0,0.0);
+        for (size_t k=Off[i];k<Off[i+1];k++)
+        {
+            size_t p = Ends[k]/2;
+            if (Ends[k]%2==0)
+            {
+                F  -= Vec3_t(Fx [p],Fy [p],Fz [p]);
+                Tt += Vec3_t(T1x[p],T1y[p],T1z[p]);
+            }
+            else
+            {
+                F  += Vec3_t(Fx [p],Fy [p],Fz [p]);
+                Tt += Vec3_t(T2x[p],T2y[p],T2z[p]);
+            }
+        }
+        Particle * P = Particles[i];
+        Quaternion_t q;
+        Vec3_t T;
+        Conjugate (P->Q,q);
+        Rotation  (Tt,q,T);
+        P->F += F;
+        P->T += T;
+    }
+}
+
+}
+#endif // MECHSYS_DEM_SPHEREPAIRS_H
@@ -37,6 +37,10 @@
 
 //STD
 #include<iostream>
+#include<algorithm>
+#include<new>
+#include<stdlib.h>   // for posix_memalign
+#include<sys/mman.h> // for madvise
 
 // Mechsys
 #include <mechsys/linalg/matvec.h>
@@ -58,6 +62,14 @@ namespace FLBM
 {
 
 #ifdef USE_OCL
+typedef cl_double3 lbm_double3;
+#else
+typedef struct lbm_double3
+{
+    double        s[4];        ///< Same layout as cl_double3, the fourth component is padding
+} lbm_double3;
+#endif
+
 typedef struct lbm_aux
 {
     size_t        Nl;          ///< Numver of Lattices
@@ -67,7 +79,7 @@ typedef struct lbm_aux
     size_t        Ny;          ///< Integer vector with the dimensions of the LBM domain
     size_t        Nz;          ///< Integer vector with the dimensions of the LBM domain
     size_t        Op[27];      ///< Array with the opposite directions for bounce back calculation
-    cl_double3    C[27];       ///< Collection of discrete velocity vectors
+    lbm_double3   C[27];       ///< Collection of discrete velocity vectors
     double        EEk[27];     ///< Dyadic product of discrete velocities for LES calculation
     double        W[27];       ///< Collection of discrete weights
     double        Tau[2];      ///< Collection of characteristic collision times
@@ -80,7 +92,6 @@ typedef struct lbm_aux
     double        Sc;          ///< Smagorinsky constant
     
 } d_lbm_aux;
-#endif
 
 inline size_t Pt2idx(iVec3_t iv, iVec3_t & Dim) // Calculates the index of the cell at coordinates iv for a cubic lattice of dimensions Dim
 {
@@ -94,6 +105,21 @@ inline void   idx2Pt(size_t n, iVec3_t & iv, iVec3_t & Dim) // Calculates the co
     iv(2) = n/(Dim(0)*Dim(1));
 }
 
+template<typename T>
+inline T * NewBlock(size_t N, T const & Val) // Allocates N copies of Val in a 64 byte aligned block, backed by huge pages when it spans at least one
+{
+    size_t const Huge = 2*1024*1024;
+    size_t Nb  = N*sizeof(T);
+    void * ptr = NULL;
+    if (posix_memalign(&ptr,Nb>=Huge?Huge:64,Nb)!=0) throw new Fatal("FLBM::NewBlock: cannot allocate a block of %zd bytes",Nb);
+    #ifdef MADV_HUGEPAGE
+    if (Nb>=Huge) madvise(ptr,Nb,MADV_HUGEPAGE);
+    #endif
+    T * blk = static_cast<T *>(ptr);
+    for (size_t n=0;n<N;n++) new (blk+n) T(Val);
+    return blk;
+}
+
 class Domain
 {
 public:
@@ -107,6 +133,7 @@ public:
 	static const Vec3_t   LVELOCD3Q15   [15]; ///< Local velocities (D3Q15)
 	static const Vec3_t   LVELOCD3Q19   [19]; ///< Local velocities (D3Q19)
 	//static const Vec3_t   LVELOCD3Q27   [27]; ///< Local velocities (D3Q27)
+	static const size_t   BLOCKSIZE     = 64; ///< Number of consecutive cells collided together when sweeping the flat arrays
 	static const size_t   OPPOSITED2Q5  [ 5]; ///< Opposite directions (D2Q5) 
 	static const size_t   OPPOSITED2Q9  [ 9]; ///< Opposite directions (D2Q9) 
 	static const size_t   OPPOSITED3Q15 [15]; ///< Opposite directions (D3Q15)
@@ -149,6 +176,12 @@ public:
     void   CollideMP();                                                           ///< The collide step of LBM for multi phase simulations
     void   StreamSC();                                                            ///< The stream step of LBM SC
     void   StreamMP();                                                            ///< The stream step of LBM MP
+    void   CollideStreamSC();                                                     ///< Collide, stream and rebuild the moments tile by tile for SC simulations
+    void   CollideCellSC(size_t n, double const * f, double * Fc);                ///< Collide cell n of lattice 0 with functions f writing the post collision functions in Fc
+    void   CollideRowSC(size_t n0, size_t Nb, double * Fo);                       ///< Collide the Nb consecutive cells from n0, Fo holds the results cell by cell (Fo[j*Nneigh+k])
+    void   MomentsSC(size_t n0, size_t Nb, double const * Fn);                    ///< Rebuild density and velocity of the Nb consecutive cells from n0 out of the function block Fn
+    void   StreamLattice(size_t il);                                              ///< Push the functions of lattice il into Ftemp, one x row at a time
+    size_t Idx(size_t ix, size_t iy, size_t iz);                                  ///< Index of cell (ix,iy,iz) in the flat arrays, x runs fastest
     void   Initialize(size_t k, iVec3_t idx, double Rho, Vec3_t & Vel);           ///< Initialize each cell with a given density and velocity
     double Feq(size_t k, double Rho, Vec3_t & Vel);                               ///< The equilibrium function
     void Solve(double Tf, double dtOut, ptDFun_t ptSetup=NULL, ptDFun_t ptReport=NULL,
@@ -157,6 +190,14 @@ public:
     //Writing Methods
     void WriteXDMF         (char const * FileKey);                                ///< Write the domain data in xdmf file
 
+    //Methods running the kernels of lbm.cl on the host, with the same cell major buffers
+    void UpLoadHost   ();                                                         ///< Pack the domain into the host kernel buffers
+    void DnLoadHost   ();                                                         ///< Unpack density and velocity from the host kernel buffers
+    void ApplyForceHost();                                                        ///< Apply forces with the host kernels
+    void CollideHost  ();                                                         ///< Apply collision operator with the host kernels
+    void StreamHost   ();                                                         ///< Apply streaming operator with the host kernels
+    size_t NeighHost  (size_t ic, size_t k);                                      ///< Neighbour of cell ic along direction k, as computed in lbm.cl
+
     //Methods for OpenCL
     #ifdef USE_OCL
     void UpLoadDevice ();                                                         ///< Upload the buffers into the coprocessor device
@@ -172,12 +213,12 @@ public:
     #endif
 
     //Data
-    double ***** F;                           ///< The array containing the individual functions with the order of the lattice, the x,y,z coordinates and the order of the function.
-    double ***** Ftemp;                       ///< A similar array to hold provitional data
-    bool   ****  IsSolid;                     ///< An array of bools with an identifier to see if the cell is a solid cell
-    Vec3_t ****  Vel;                         ///< The fluid velocities
-    Vec3_t ****  BForce;                      ///< Body Force for each cell
-    double ****  Rho;                         ///< The fluid densities
+    double **    F;                           ///< The distribution functions of each lattice, function k of cell n is F[il][k*Nstride+n] with n = Idx(ix,iy,iz)
+    double **    Ftemp;                       ///< A similar array to hold provitional data
+    bool   **    IsSolid;                     ///< An array of bools with an identifier to see if the cell is a solid cell
+    Vec3_t **    Vel;                         ///< The fluid velocities
+    Vec3_t **    BForce;                      ///< Body Force for each cell
+    double **    Rho;                         ///< The fluid densities
     double *     Tau;                         ///< The characteristic time of the lattice
     double *     G;                           ///< The attractive constant for multiphase simulations
     double *     Gs;                          ///< The attractive constant for solid phase
@@ -198,6 +239,7 @@ public:
     bool         IsFirstTime;                 ///< Bool variable checking if it is the first time function Setup is called
     iVec3_t      Ndim;                        ///< Lattice Dimensions
     size_t       Ncells;                      ///< Number of cells
+    size_t       Nstride;                     ///< Length of each direction block of F (Ncells padded to the cache line)
     size_t       Nproc;                       ///< Number of processors for openmp
     size_t       idx_out;                     ///< The discrete time step for output
     String       FileKey;                     ///< File Key for output files
@@ -206,6 +248,18 @@ public:
     double       Time;                        ///< Simulation time variable
     size_t       Nl;                          ///< Number of lattices (fluids)
     double       Sc;                          ///< Smagorinsky constant
+    bool         Tiled;                       ///< Fuse collide, stream and moments sweeping the lattice in cache sized tiles (single component only)
+    iVec3_t      Tile;                        ///< Tile dimensions for the Tiled mode, z (y in 2D) is swept as a wavefront inside each tile
+
+    //Buffers for the kernels of lbm.cl, function k of cell n is hF[il][n*Nneigh+k]
+    bool           CLHost;                    ///< Run the kernels of lbm.cl on the host with OpenMP instead of the native path (or the device)
+    lbm_aux        hAux;                      ///< Generic lbm information shared with the kernels
+    double      ** hF;                        ///< Host buffer with the distribution functions
+    double      ** hFtemp;                    ///< Host buffer with the distribution functions temporal
+    bool        ** hIsSolid;                  ///< Host buffer with the solid bool information
+    lbm_double3 ** hBForce;                   ///< Host buffer with the body forces
+    lbm_double3 ** hVel;                      ///< Host buffer with the cell velocities
+    double      ** hRho;                      ///< Host buffer with the cell densities
 
     //Array for pair calculation
     size_t       NCellPairs;                  ///< Number of cell pairs
@@ -285,7 +339,12 @@ inline Domain::Domain(LBMethod TheMethod, Array<double> nu, iVec3_t TheNdim, dou
     Nl          = nu.Size();
     Ndim        = TheNdim;
     Ncells      = Ndim(0)*Ndim(1)*Ndim(2);
+    Nstride     = ((Ncells+7)/8)*8;
     IsFirstTime = true;
+    Tiled       = false;
+    CLHost      = false;
+    hF          = NULL;
+    Tile        = Ndim(0),std::min(Ndim(1),(size_t)16),Ndim(2);
 
 
     Tau = new double [Nl];
@@ -295,12 +354,12 @@ inline Domain::Domain(LBMethod TheMethod, Array<double> nu, iVec3_t TheNdim, dou
     Psi    = new double [Nl];
     Gmix= 0.0;
 
-    F       = new double **** [Nl];
-    Ftemp   = new double **** [Nl];
-    Vel     = new Vec3_t ***  [Nl];
-    BForce  = new Vec3_t ***  [Nl];
-    Rho     = new double ***  [Nl];
-    IsSolid = new bool   ***  [Nl];
+    F       = new double * [Nl];
+    Ftemp   = new double * [Nl];
+    Vel     = new Vec3_t * [Nl];
+    BForce  = new Vec3_t * [Nl];
+    Rho     = new double * [Nl];
+    IsSolid = new bool   * [Nl];
 
     for (size_t i=0;i<Nl;i++)
     {
@@ -309,41 +368,12 @@ inline Domain::Domain(LBMethod TheMethod, Array<double> nu, iVec3_t TheNdim, dou
         Gs      [i]    = 0.0;
         Rhoref  [i]    = 200.0;
         Psi     [i]    = 4.0;
-        F       [i]    = new double *** [Ndim(0)];
-        Ftemp   [i]    = new double *** [Ndim(0)];
-        Vel     [i]    = new Vec3_t **  [Ndim(0)];
-        BForce  [i]    = new Vec3_t **  [Ndim(0)];
-        Rho     [i]    = new double **  [Ndim(0)];
-        IsSolid [i]    = new bool   **  [Ndim(0)];
-        for (size_t nx=0;nx<Ndim(0);nx++)
-        {
-            F       [i][nx]    = new double ** [Ndim(1)];
-            Ftemp   [i][nx]    = new double ** [Ndim(1)];
-            Vel     [i][nx]    = new Vec3_t *  [Ndim(1)];
-            BForce  [i][nx]    = new Vec3_t *  [Ndim(1)];
-            Rho     [i][nx]    = new double *  [Ndim(1)];
-            IsSolid [i][nx]    = new bool   *  [Ndim(1)];
-            for (size_t ny=0;ny<Ndim(1);ny++)
-            {
-                F       [i][nx][ny]    = new double * [Ndim(2)];
-                Ftemp   [i][nx][ny]    = new double * [Ndim(2)];
-                Vel     [i][nx][ny]    = new Vec3_t   [Ndim(2)];
-                BForce  [i][nx][ny]    = new Vec3_t   [Ndim(2)];
-                Rho     [i][nx][ny]    = new double   [Ndim(2)];
-                IsSolid [i][nx][ny]    = new bool     [Ndim(2)];
-                for (size_t nz=0;nz<Ndim(2);nz++)
-                {
-                    F    [i][nx][ny][nz]    = new double [Nneigh];
-                    Ftemp[i][nx][ny][nz]    = new double [Nneigh];
-                    IsSolid[i][nx][ny][nz]  = false;
-                    for (size_t nn=0;nn<Nneigh;nn++)
-                    {
-                        F    [i][nx][ny][nz][nn] = 0.0;
-                        Ftemp[i][nx][ny][nz][nn] = 0.0;
-                    }
-                }
-            }
-        }
+        F       [i]    = NewBlock<double>(Nneigh*Nstride,0.0);
+        Ftemp   [i]    = NewBlock<double>(Nneigh*Nstride,0.0);
+        Vel     [i]    = NewBlock<Vec3_t>(Ncells,OrthoSys::O);
+        BForce  [i]    = NewBlock<Vec3_t>(Ncells,OrthoSys::O);
+        Rho     [i]    = NewBlock<double>(Ncells,0.0);
+        IsSolid [i]    = NewBlock<bool>  (Ncells,false);
     }
 
 
@@ -384,7 +414,12 @@ inline Domain::Domain(LBMethod TheMethod, double Thenu, iVec3_t TheNdim, double
     Nl          = 1;
     Ndim        = TheNdim;
     Ncells      = Ndim(0)*Ndim(1)*Ndim(2);
+    Nstride     = ((Ncells+7)/8)*8;
     IsFirstTime = true;
+    Tiled       = false;
+    CLHost      = false;
+    hF          = NULL;
+    Tile        = Ndim(0),std::min(Ndim(1),(size_t)16),Ndim(2);
 
     if (TheMethod==D2Q5)
     {
@@ -436,12 +471,12 @@ inline Domain::Domain(LBMethod TheMethod, double Thenu, iVec3_t TheNdim, double
     Psi    = new double [Nl];
     Gmix   = 0.0;
 
-    F       = new double **** [Nl];
-    Ftemp   = new double **** [Nl];
-    Vel     = new Vec3_t ***  [Nl];
-    BForce  = new Vec3_t ***  [Nl];
-    Rho     = new double ***  [Nl];
-    IsSolid = new bool   ***  [Nl];
+    F       = new double * [Nl];
+    Ftemp   = new double * [Nl];
+    Vel     = new Vec3_t * [Nl];
+    BForce  = new Vec3_t * [Nl];
+    Rho     = new double * [Nl];
+    IsSolid = new bool   * [Nl];
 
     for (size_t i=0;i<Nl;i++)
     {
@@ -450,41 +485,12 @@ inline Domain::Domain(LBMethod TheMethod, double Thenu, iVec3_t TheNdim, double
         Gs      [i]    = 0.0;
         Rhoref  [i]    = 200.0;
         Psi     [i]    = 4.0;
-        F       [i]    = new double *** [Ndim(0)];
-        Ftemp   [i]    = new double *** [Ndim(0)];
-        Vel     [i]    = new Vec3_t **  [Ndim(0)];
-        BForce  [i]    = new Vec3_t **  [Ndim(0)];
-        Rho     [i]    = new double **  [Ndim(0)];
-        IsSolid [i]    = new bool   **  [Ndim(0)];
-        for (size_t nx=0;nx<Ndim(0);nx++)
-        {
-            F       [i][nx]    = new double ** [Ndim(1)];
-            Ftemp   [i][nx]    = new double ** [Ndim(1)];
-            Vel     [i][nx]    = new Vec3_t *  [Ndim(1)];
-            BForce  [i][nx]    = new Vec3_t *  [Ndim(1)];
-            Rho     [i][nx]    = new double *  [Ndim(1)];
-            IsSolid [i][nx]    = new bool   *  [Ndim(1)];
-            for (size_t ny=0;ny<Ndim(1);ny++)
-            {
-                F       [i][nx][ny]    = new double * [Ndim(2)];
-                Ftemp   [i][nx][ny]    = new double * [Ndim(2)];
-                Vel     [i][nx][ny]    = new Vec3_t   [Ndim(2)];
-                BForce  [i][nx][ny]    = new Vec3_t   [Ndim(2)];
-                Rho     [i][nx][ny]    = new double   [Ndim(2)];
-                IsSolid [i][nx][ny]    = new bool     [Ndim(2)];
-                for (size_t nz=0;nz<Ndim(2);nz++)
-                {
-                    F    [i][nx][ny][nz]    = new double [Nneigh];
-                    Ftemp[i][nx][ny][nz]    = new double [Nneigh];
-                    IsSolid[i][nx][ny][nz]  = false;
-                    for (size_t nn=0;nn<Nneigh;nn++)
-                    {
-                        F    [i][nx][ny][nz][nn] = 0.0;
-                        Ftemp[i][nx][ny][nz][nn] = 0.0;
-                    }
-                }
-            }
-        }
+        F       [i]    = NewBlock<double>(Nneigh*Nstride,0.0);
+        Ftemp   [i]    = NewBlock<double>(Nneigh*Nstride,0.0);
+        Vel     [i]    = NewBlock<Vec3_t>(Ncells,OrthoSys::O);
+        BForce  [i]    = NewBlock<Vec3_t>(Ncells,OrthoSys::O);
+        Rho     [i]    = NewBlock<double>(Ncells,0.0);
+        IsSolid [i]    = NewBlock<bool>  (Ncells,false);
     }
 
 
@@ -535,9 +541,10 @@ inline void Domain::WriteXDMF(char const * FileKey)
             for (size_t li=0;li<Step;li++)
             for (size_t mi=0;mi<Step;mi++)
             {
-                rho    += Rho    [j][n+ni][l+li][m+mi];
-                gamma  += IsSolid[j][n+ni][l+li][m+mi] ? 1.0: 0.0;
-                vel    += Vel    [j][n+ni][l+li][m+mi];
+                size_t nc = Idx(n+ni,l+li,m+mi);
+                rho    += Rho    [j][nc];
+                gamma  += IsSolid[j][nc] ? 1.0: 0.0;
+                vel    += Vel    [j][nc];
             }
             rho  /= Step*Step*Step;
             gamma/= Step*Step*Step;
@@ -673,6 +680,11 @@ inline void Domain::WriteXDMF(char const * FileKey)
 
 }
 
+inline size_t Domain::Idx(size_t ix, size_t iy, size_t iz)
+{
+    return ix + Ndim(0)*(iy + Ndim(1)*iz);
+}
+
 inline double Domain::Feq(size_t k, double Rho, Vec3_t & V)
 {
     double VdotC = dot(V,C[k]);
@@ -682,26 +694,24 @@ inline double Domain::Feq(size_t k, double Rho, Vec3_t & V)
 
 inline void Domain::Initialize(size_t il, iVec3_t idx, double TheRho, Vec3_t & TheVel)
 {
-    size_t ix = idx(0);
-    size_t iy = idx(1);
-    size_t iz = idx(2);
+    size_t n = Idx(idx(0),idx(1),idx(2));
 
-    BForce[il][ix][iy][iz] = OrthoSys::O;
+    BForce[il][n] = OrthoSys::O;
 
     for (size_t k=0;k<Nneigh;k++)
     {
-        F[il][ix][iy][iz][k] = Feq(k,TheRho,TheVel);
+        F[il][k*Nstride+n] = Feq(k,TheRho,TheVel);
     }
 
-    if (!IsSolid[il][ix][iy][iz])
+    if (!IsSolid[il][n])
     {
-        Vel[il][ix][iy][iz] = TheVel;
-        Rho[il][ix][iy][iz] = TheRho;
+        Vel[il][n] = TheVel;
+        Rho[il][n] = TheRho;
     }
     else
     {
-        Vel[il][ix][iy][iz] = OrthoSys::O;
-        Rho[il][ix][iy][iz] = 0.0;
+        Vel[il][n] = OrthoSys::O;
+        Rho[il][n] = 0.0;
     }
 }
 
@@ -712,28 +722,20 @@ inline void Domain::ApplyForcesSC()
     #endif
     for (size_t n=0;n<NCellPairs;n++)
     {
-        iVec3_t idxc,idxn;
-        size_t k = CellPairs[n](2);
-        idx2Pt(CellPairs[n](0),idxc,Ndim);
-        idx2Pt(CellPairs[n](1),idxn,Ndim);
-
-        size_t ixc = idxc(0);
-        size_t iyc = idxc(1);
-        size_t izc = idxc(2);
-        size_t ixn = idxn(0);
-        size_t iyn = idxn(1);
-        size_t izn = idxn(2);
+        size_t nc = CellPairs[n](0);
+        size_t nb = CellPairs[n](1);
+        size_t k  = CellPairs[n](2);
 
         double psic = 0.0;
         double psin = 0.0;
 
-        IsSolid[0][ixc][iyc][izc] ? psic = 0.0 : psic = Psi[0]*exp(-Rhoref[0]/Rho[0][ixc][iyc][izc]);
-        IsSolid[0][ixn][iyn][izn] ? psin = 0.0 : psin = Psi[0]*exp(-Rhoref[0]/Rho[0][ixn][iyn][izn]);
+        IsSolid[0][nc] ? psic = 0.0 : psic = Psi[0]*exp(-Rhoref[0]/Rho[0][nc]);
+        IsSolid[0][nb] ? psin = 0.0 : psin = Psi[0]*exp(-Rhoref[0]/Rho[0][nb]);
 
         Vec3_t bforce = -G[0]*W[k]*C[k]*psic*psin;
 
-        BForce[0][ixc][iyc][izc] += bforce;
-        BForce[0][ixn][iyn][izn] -= bforce;
+        BForce[0][nc] += bforce;
+        BForce[0][nb] -= bforce;
     }
 }
 
@@ -744,40 +746,32 @@ inline void Domain::ApplyForcesMP()
     #endif
     for (size_t n=0;n<NCellPairs;n++)
     {
-        iVec3_t idxc,idxn;
-        size_t k = CellPairs[n](2);
-        idx2Pt(CellPairs[n](0),idxc,Ndim);
-        idx2Pt(CellPairs[n](1),idxn,Ndim);
-
-        size_t ixc = idxc(0);
-        size_t iyc = idxc(1);
-        size_t izc = idxc(2);
-        size_t ixn = idxn(0);
-        size_t iyn = idxn(1);
-        size_t izn = idxn(2);
+        size_t nc = CellPairs[n](0);
+        size_t nb = CellPairs[n](1);
+        size_t k  = CellPairs[n](2);
 
         double psic = 0.0;
         double psin = 0.0;
 
         double Gt   = Gmix;
 
-        IsSolid[0][ixc][iyc][izc] ? psic = 1.0, Gt = Gs[1] : psic = Rho[0][ixc][iyc][izc];
-        IsSolid[1][ixn][iyn][izn] ? psin = 1.0, Gt = Gs[0] : psin = Rho[1][ixn][iyn][izn];
+        IsSolid[0][nc] ? psic = 1.0, Gt = Gs[1] : psic = Rho[0][nc];
+        IsSolid[1][nb] ? psin = 1.0, Gt = Gs[0] : psin = Rho[1][nb];
 
         Vec3_t bforce = -Gt*W[k]*C[k]*psic*psin;
 
-        BForce[0][ixc][iyc][izc] += bforce;
-        BForce[1][ixn][iyn][izn] -= bforce;
+        BForce[0][nc] += bforce;
+        BForce[1][nb] -= bforce;
 
         Gt          = Gmix;
 
-        IsSolid[1][ixc][iyc][izc] ? psic = 1.0, Gt = Gs[0] : psic = Rho[1][ixc][iyc][izc];
-        IsSolid[0][ixn][iyn][izn] ? psin = 1.0, Gt = Gs[1] : psin = Rho[0][ixn][iyn][izn];
+        IsSolid[1][nc] ? psic = 1.0, Gt = Gs[0] : psic = Rho[1][nc];
+        IsSolid[0][nb] ? psin = 1.0, Gt = Gs[1] : psin = Rho[0][nb];
 
         bforce      = -Gt*W[k]*C[k]*psic*psin;
 
-        BForce[1][ixc][iyc][izc] += bforce;
-        BForce[0][ixn][iyn][izn] -= bforce;
+        BForce[1][nc] += bforce;
+        BForce[0][nb] -= bforce;
     }
 }
 
@@ -788,161 +782,202 @@ inline void Domain::ApplyForcesSCMP()
     #endif
     for (size_t n=0;n<NCellPairs;n++)
     {
-        iVec3_t idxc,idxn;
-        size_t k = CellPairs[n](2);
-        idx2Pt(CellPairs[n](0),idxc,Ndim);
-        idx2Pt(CellPairs[n](1),idxn,Ndim);
-
-        size_t ixc = idxc(0);
-        size_t iyc = idxc(1);
-        size_t izc = idxc(2);
-        size_t ixn = idxn(0);
-        size_t iyn = idxn(1);
-        size_t izn = idxn(2);
+        size_t nc = CellPairs[n](0);
+        size_t nb = CellPairs[n](1);
+        size_t k  = CellPairs[n](2);
 
         double psic = 0.0;
         double psin = 0.0;
 
-        IsSolid[0][ixc][iyc][izc] ? psic = 0.0 : psic = Psi[0]*exp(-Rhoref[0]/Rho[0][ixc][iyc][izc]);
-        IsSolid[0][ixn][iyn][izn] ? psin = 0.0 : psin = Psi[0]*exp(-Rhoref[0]/Rho[0][ixn][iyn][izn]);
+        IsSolid[0][nc] ? psic = 0.0 : psic = Psi[0]*exp(-Rhoref[0]/Rho[0][nc]);
+        IsSolid[0][nb] ? psin = 0.0 : psin = Psi[0]*exp(-Rhoref[0]/Rho[0][nb]);
 
         Vec3_t bforce = -G[0]*W[k]*C[k]*psic*psin;
 
-        BForce[0][ixc][iyc][izc] += bforce;
-        BForce[0][ixn][iyn][izn] -= bforce;
+        BForce[0][nc] += bforce;
+        BForce[0][nb] -= bforce;
 
-        IsSolid[1][ixc][iyc][izc] ? psic = 0.0 : psic = Psi[1]*exp(-Rhoref[1]/Rho[1][ixc][iyc][izc]);
-        IsSolid[1][ixn][iyn][izn] ? psin = 0.0 : psin = Psi[1]*exp(-Rhoref[1]/Rho[1][ixn][iyn][izn]);
+        IsSolid[1][nc] ? psic = 0.0 : psic = Psi[1]*exp(-Rhoref[1]/Rho[1][nc]);
+        IsSolid[1][nb] ? psin = 0.0 : psin = Psi[1]*exp(-Rhoref[1]/Rho[1][nb]);
 
         bforce        = -G[1]*W[k]*C[k]*psic*psin;
 
-        BForce[1][ixc][iyc][izc] += bforce;
-        BForce[1][ixn][iyn][izn] -= bforce;
+        BForce[1][nc] += bforce;
+        BForce[1][nb] -= bforce;
 
         double Gt   = Gmix;
 
-        IsSolid[0][ixc][iyc][izc] ? psic = 1.0, Gt = Gs[1] : psic = Rho[0][ixc][iyc][izc];
-        IsSolid[1][ixn][iyn][izn] ? psin = 1.0, Gt = Gs[0] : psin = Rho[1][ixn][iyn][izn];
+        IsSolid[0][nc] ? psic = 1.0, Gt = Gs[1] : psic = Rho[0][nc];
+        IsSolid[1][nb] ? psin = 1.0, Gt = Gs[0] : psin = Rho[1][nb];
 
         bforce      = -Gt*W[k]*C[k]*psic*psin;
 
-        BForce[0][ixc][iyc][izc] += bforce;
-        BForce[1][ixn][iyn][izn] -= bforce;
+        BForce[0][nc] += bforce;
+        BForce[1][nb] -= bforce;
 
         Gt          = Gmix;
 
-        IsSolid[1][ixc][iyc][izc] ? psic = 1.0, Gt = Gs[0] : psic = Rho[1][ixc][iyc][izc];
-        IsSolid[0][ixn][iyn][izn] ? psin = 1.0, Gt = Gs[1] : psin = Rho[0][ixn][iyn][izn];
+        IsSolid[1][nc] ? psic = 1.0, Gt = Gs[0] : psic = Rho[1][nc];
+        IsSolid[0][nb] ? psin = 1.0, Gt = Gs[1] : psin = Rho[0][nb];
 
         bforce      = -Gt*W[k]*C[k]*psic*psin;
 
-        BForce[1][ixc][iyc][izc] += bforce;
-        BForce[0][ixn][iyn][izn] -= bforce;
+        BForce[1][nc] += bforce;
+        BForce[0][nb] -= bforce;
     }
 }
 
-inline void Domain::CollideSC()
+inline void Domain::CollideCellSC(size_t n, double const * f, double * Fc)
 {
-    size_t nx = Ndim(0);
-    size_t ny = Ndim(1);
-    size_t nz = Ndim(2);
-
-    #ifdef USE_OMP
-    #pragma omp parallel for schedule(static) num_threads(Nproc)
-    #endif
-    for (size_t ix=0;ix<nx;ix++)
-    for (size_t iy=0;iy<ny;iy++)
-    for (size_t iz=0;iz<nz;iz++)
+    if (!IsSolid[0][n])
     {
-        if (!IsSolid[0][ix][iy][iz])
+        double NonEq[Nneigh];
+        double Q = 0.0;
+        double tau = Tau[0];
+        double rho = Rho[0][n];
+        Vec3_t vel = Vel[0][n]+dt*tau*BForce[0][n]/rho;
+        double VdotV = dot(vel,vel);
+        for (size_t k=0;k<Nneigh;k++)
         {
-            double NonEq[Nneigh];
-            double Q = 0.0;
-            double tau = Tau[0];
-            double rho = Rho[0][ix][iy][iz];
-            Vec3_t vel = Vel[0][ix][iy][iz]+dt*tau*BForce[0][ix][iy][iz]/rho;
-            double VdotV = dot(vel,vel);
-            for (size_t k=0;k<Nneigh;k++)
-            {
-                double VdotC = dot(vel,C[k]);
-                double Feq   = W[k]*rho*(1.0 + 3.0*VdotC/Cs + 4.5*VdotC*VdotC/(Cs*Cs) - 1.5*VdotV/(Cs*Cs));
-                NonEq[k] = F[0][ix][iy][iz][k] - Feq;
-                Q +=  NonEq[k]*NonEq[k]*EEk[k];
-            }
-            Q = sqrt(2.0*Q);
-            tau = 0.5*(tau+sqrt(tau*tau + 6.0*Q*Sc/rho));
+            double VdotC = dot(vel,C[k]);
+            double Feq   = W[k]*rho*(1.0 + 3.0*VdotC/Cs + 4.5*VdotC*VdotC/(Cs*Cs) - 1.5*VdotV/(Cs*Cs));
+            NonEq[k] = f[k] - Feq;
+            Q +=  NonEq[k]*NonEq[k]*EEk[k];
+        }
+        Q = sqrt(2.0*Q);
+        tau = 0.5*(tau+sqrt(tau*tau + 6.0*Q*Sc/rho));
 
-            bool valid = true;
-            double alpha = 1.0;
-            while (valid)
+        bool valid = true;
+        double alpha = 1.0;
+        while (valid)
+        {
+            valid = false;
+            for (size_t k=0;k<Nneigh;k++)
             {
-                valid = false;
-                for (size_t k=0;k<Nneigh;k++)
+                Fc[k] = f[k] - alpha*NonEq[k]/tau;
+                if (Fc[k]<-1.0e-12)
                 {
-                    Ftemp[0][ix][iy][iz][k] = F[0][ix][iy][iz][k] - alpha*NonEq[k]/tau;
-                    if (Ftemp[0][ix][iy][iz][k]<-1.0e-12)
-                    {
-                        //std::cout << Ftemp[0][ix][iy][iz][k] << std::endl;
-                        double temp =  tau*F[0][ix][iy][iz][k]/NonEq[k];
-                        if (temp<alpha) alpha = temp;
-                        valid = true;
-                    }
-                    if (std::isnan(Ftemp[0][ix][iy][iz][k]))
-                    {
-                        std::cout << "CollideSC: Nan found, resetting" << std::endl;
-                        std::cout << " " << alpha << " " << iVec3_t(ix,iy,iz) << " " << k << " " << std::endl;
-                        throw new Fatal("Domain::CollideSC: Distribution funcitons gave nan value, check parameters");
-                    }
+                    double temp =  tau*f[k]/NonEq[k];
+                    if (temp<alpha) alpha = temp;
+                    valid = true;
+                }
+                if (std::isnan(Fc[k]))
+                {
+                    iVec3_t iv;
+                    idx2Pt(n,iv,Ndim);
+                    std::cout << "CollideSC: Nan found, resetting" << std::endl;
+                    std::cout << " " << alpha << " " << iv << " " << k << " " << std::endl;
+                    throw new Fatal("Domain::CollideSC: Distribution funcitons gave nan value, check parameters");
                 }
             }
         }
-        else
+    }
+    else
+    {
+        for (size_t k=0;k<Nneigh;k++)
         {
-            for (size_t k=0;k<Nneigh;k++)
-            {
-                Ftemp[0][ix][iy][iz][k] = F[0][ix][iy][iz][Op[k]];
-            }
+            Fc[k] = f[Op[k]];
+        }
+    }
+}
+
+inline void Domain::CollideRowSC(size_t n0, size_t Nb, double * Fo)
+{
+    double Fi[Nb*Nneigh];
+    for (size_t k=0;k<Nneigh;k++)
+    {
+        double const * Fk = F[0]+k*Nstride+n0;
+        for (size_t j=0;j<Nb;j++) Fi[j*Nneigh+k] = Fk[j];
+    }
+    for (size_t j=0;j<Nb;j++)
+    {
+        CollideCellSC(n0+j,Fi+j*Nneigh,Fo+j*Nneigh);
+    }
+}
+
+inline void Domain::MomentsSC(size_t n0, size_t Nb, double const * Fn)
+{
+    double rho[Nb];
+    double vx [Nb];
+    double vy [Nb];
+    double vz [Nb];
+    for (size_t j=0;j<Nb;j++)
+    {
+        rho[j] = 0.0;
+        vx [j] = 0.0;
+        vy [j] = 0.0;
+        vz [j] = 0.0;
+    }
+    for (size_t k=0;k<Nneigh;k++)
+    {
+        double const * Fk = Fn+k*Nstride+n0;
+        double cx = C[k](0);
+        double cy = C[k](1);
+        double cz = C[k](2);
+        for (size_t j=0;j<Nb;j++)
+        {
+            rho[j] += Fk[j];
+            vx [j] += Fk[j]*cx;
+            vy [j] += Fk[j]*cy;
+            vz [j] += Fk[j]*cz;
+        }
+    }
+    for (size_t j=0;j<Nb;j++)
+    {
+        size_t n = n0+j;
+        BForce[0][n] = OrthoSys::O;
+        if (IsSolid[0][n])
+        {
+            Vel[0][n] = OrthoSys::O;
+            Rho[0][n] = 0.0;
+            continue;
         }
+        double q  = Cs/rho[j];
+        Rho[0][n] = rho[j];
+        Vel[0][n] = vx[j]*q,vy[j]*q,vz[j]*q;
     }
+}
+
+inline void Domain::CollideSC()
+{
+    size_t Nblk = (Ncells+BLOCKSIZE-1)/BLOCKSIZE;
 
-    double ***** tmp = F;
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t b=0;b<Nblk;b++)
+    {
+        size_t n0 = b*BLOCKSIZE;
+        size_t Nb = std::min(BLOCKSIZE,Ncells-n0);
+        double Fo[Nb*Nneigh];
+        CollideRowSC(n0,Nb,Fo);
+        for (size_t k=0;k<Nneigh;k++)
+        {
+            double * Fk = Ftemp[0]+k*Nstride+n0;
+            for (size_t j=0;j<Nb;j++) Fk[j] = Fo[j*Nneigh+k];
+        }
+    }
+
+    double ** tmp = F;
     F = Ftemp;
     Ftemp = tmp;
 }
 
 inline void Domain::CollideMRT()
 {
-    size_t nx = Ndim(0);
-    size_t ny = Ndim(1);
-    size_t nz = Ndim(2);
-
     #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     #endif
-    for (size_t ix=0;ix<nx;ix++)
-    for (size_t iy=0;iy<ny;iy++)
-    for (size_t iz=0;iz<nz;iz++)
+    for (size_t nc=0;nc<Ncells;nc++)
     {
-        if (!IsSolid[0][ix][iy][iz])
+        if (!IsSolid[0][nc])
         {
-            //double NonEq[Nneigh];
-            //double Q = 0.0;
-            //double tau = Tau[0];
-            double rho = Rho[0][ix][iy][iz];
-            Vec3_t vel = Vel[0][ix][iy][iz]+dt*BForce[0][ix][iy][iz]/rho;
-            //double VdotV = dot(vel,vel);
-            //for (size_t k=0;k<Nneigh;k++)
-            //{
-                //double VdotC = dot(vel,C[k]);
-                //double Feq   = W[k]*rho*(1.0 + 3.0*VdotC/Cs + 4.5*VdotC*VdotC/(Cs*Cs) - 1.5*VdotV/(Cs*Cs));
-                //NonEq[k] = F[0][ix][iy][iz][k] - Feq;
-                //Q +=  NonEq[k]*NonEq[k]*EEk[k];
-            //}
-            //Q = sqrt(2.0*Q);
-            //tau = 0.5*(tau+sqrt(tau*tau + 6.0*Q*Sc/rho));
-            double *f = F[0][ix][iy][iz];
-            double *ft= Ftemp[0][ix][iy][iz];
+            double rho = Rho[0][nc];
+            Vec3_t vel = Vel[0][nc]+dt*BForce[0][nc]/rho;
+            double f   [Nneigh];
+            double ft  [Nneigh];
             double fneq[Nneigh];
+            for (size_t k=0;k<Nneigh;k++) f[k] = F[0][k*Nstride+nc];
             int n=Nneigh,m=1;
             double a = 1.0,b = 0.0;
             dgemv_("N",&n,&n,&a,M.data,&n,f,&m,&b,ft,&m);
@@ -974,20 +1009,13 @@ inline void Domain::CollideMRT()
                 valid = false;
                 for (size_t k=0;k<Nneigh;k++)
                 {
-                    Ftemp[0][ix][iy][iz][k] = F[0][ix][iy][iz][k] - alpha*fneq[k];
-                    if (Ftemp[0][ix][iy][iz][k]<-1.0e-12)
+                    Ftemp[0][k*Nstride+nc] = f[k] - alpha*fneq[k];
+                    if (Ftemp[0][k*Nstride+nc]<-1.0e-12)
                     {
-                        //std::cout << Ftemp[0][ix][iy][iz][k] << std::endl;
                         valid = true;
-                        double temp =  F[0][ix][iy][iz][k]/fneq[k];
+                        double temp =  f[k]/fneq[k];
                         if (temp<alphat) alphat = temp;
                     }
-                    //if (std::isnan(Ftemp[0][ix][iy][iz][k]))
-                    //{
-                        //std::cout << "CollideSC: Nan found, resetting" << std::endl;
-                        //std::cout << " " << alpha << " " << iVec3_t(ix,iy,iz) << " " << k << " " << std::endl;
-                        //throw new Fatal("Domain::CollideSC: Distribution funcitons gave nan value, check parameters");
-                    //}
                 }
             }
         }
@@ -995,44 +1023,38 @@ inline void Domain::CollideMRT()
         {
             for (size_t k=0;k<Nneigh;k++)
             {
-                Ftemp[0][ix][iy][iz][k] = F[0][ix][iy][iz][Op[k]];
+                Ftemp[0][k*Nstride+nc] = F[0][Op[k]*Nstride+nc];
             }
         }
     }
 
-    double ***** tmp = F;
+    double ** tmp = F;
     F = Ftemp;
     Ftemp = tmp;
 }
 
 inline void Domain::CollideMP ()
 {
-    size_t nx = Ndim(0);
-    size_t ny = Ndim(1);
-    size_t nz = Ndim(2);
-
     #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     #endif
-    for (size_t ix=0;ix<nx;ix++)
-    for (size_t iy=0;iy<ny;iy++)
-    for (size_t iz=0;iz<nz;iz++)
+    for (size_t n=0;n<Ncells;n++)
     {
         Vec3_t Vmix = OrthoSys::O;
         double den  = 0.0;
         for (size_t il=0;il<Nl;il++)
         {
-            Vmix += Rho[il][ix][iy][iz]*Vel[il][ix][iy][iz]/Tau[il];
-            den  += Rho[il][ix][iy][iz]/Tau[il];
+            Vmix += Rho[il][n]*Vel[il][n]/Tau[il];
+            den  += Rho[il][n]/Tau[il];
         }
         Vmix /= den;
 
         for (size_t il=0;il<Nl;il++)
         {
-            if (!IsSolid[il][ix][iy][iz])
+            if (!IsSolid[il][n])
             {
-                double rho = Rho[il][ix][iy][iz];
-                Vec3_t vel = Vmix + dt*Tau[il]*BForce[il][ix][iy][iz]/rho;
+                double rho = Rho[il][n];
+                Vec3_t vel = Vmix + dt*Tau[il]*BForce[il][n]/rho;
                 double VdotV = dot(vel,vel);
                 bool valid = true;
                 double alpha = 1.0;
@@ -1041,20 +1063,22 @@ inline void Domain::CollideMP ()
                     valid = false;
                     for (size_t k=0;k<Nneigh;k++)
                     {
+                        double f     = F[il][k*Nstride+n];
                         double VdotC = dot(vel,C[k]);
                         double Feq   = W[k]*rho*(1.0 + 3.0*VdotC/Cs + 4.5*VdotC*VdotC/(Cs*Cs) - 1.5*VdotV/(Cs*Cs));
-                        Ftemp[il][ix][iy][iz][k] = F[il][ix][iy][iz][k] - alpha*(F[il][ix][iy][iz][k] - Feq)/Tau[il];
-                        if (Ftemp[il][ix][iy][iz][k]<-1.0e-12)
+                        Ftemp[il][k*Nstride+n] = f - alpha*(f - Feq)/Tau[il];
+                        if (Ftemp[il][k*Nstride+n]<-1.0e-12)
                         {
-                            //std::cout << Ftemp[0][ix][iy][iz][k] << std::endl;
-                            double temp =  Tau[il]*F[il][ix][iy][iz][k]/(F[il][ix][iy][iz][k] - Feq);
+                            double temp =  Tau[il]*f/(f - Feq);
                             if (temp<alpha) alpha = temp;
                             valid = true;
                         }
-                        if (std::isnan(Ftemp[il][ix][iy][iz][k]))
+                        if (std::isnan(Ftemp[il][k*Nstride+n]))
                         {
+                            iVec3_t iv;
+                            idx2Pt(n,iv,Ndim);
                             std::cout << "CollideMP: Nan found, resetting" << std::endl;
-                            std::cout << " " << alpha << " " << iVec3_t(ix,iy,iz) << " " << k << " " << std::endl;
+                            std::cout << " " << alpha << " " << iv << " " << k << " " << std::endl;
                             throw new Fatal("Domain::CollideMP: Distribution funcitons gave nan value, check parameters");
                         }
                     }
@@ -1064,115 +1088,518 @@ inline void Domain::CollideMP ()
             {
                 for (size_t k=0;k<Nneigh;k++)
                 {
-                    Ftemp[il][ix][iy][iz][k] = F[il][ix][iy][iz][Op[k]];
+                    Ftemp[il][k*Nstride+n] = F[il][Op[k]*Nstride+n];
                 }
             }
         }
     }
 
-    double ***** tmp = F;
+    double ** tmp = F;
     F = Ftemp;
     Ftemp = tmp;
 }
 
-inline void Domain::StreamSC()
+inline void Domain::StreamLattice(size_t il)
 {
     size_t nx = Ndim(0);
     size_t ny = Ndim(1);
     size_t nz = Ndim(2);
 
+    // Every x row of direction k lands on a single row of Ftemp, rotated by C[k](0) cells
     #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     #endif
-    for (size_t ix=0;ix<nx;ix++)
-    for (size_t iy=0;iy<ny;iy++)
-    for (size_t iz=0;iz<nz;iz++)
+    for (size_t m=0;m<Nneigh*ny*nz;m++)
     {
-        for (size_t k=0;k<Nneigh;k++)
+        size_t k   = m/(ny*nz);
+        size_t iy  = m%ny;
+        size_t iz  = (m/ny)%nz;
+        size_t niy = (size_t)((int)iy + (int)C[k](1) + (int)ny)%ny;
+        size_t niz = (size_t)((int)iz + (int)C[k](2) + (int)nz)%nz;
+        size_t s   = (size_t)((int)C[k](0) + (int)nx)%nx;
+        double const * src = F    [il] + k*Nstride + Idx(0,iy ,iz );
+        double       * dst = Ftemp[il] + k*Nstride + Idx(0,niy,niz);
+        std::copy(src     ,src+nx-s,dst+s);
+        std::copy(src+nx-s,src+nx  ,dst  );
+    }
+}
+
+inline void Domain::StreamSC()
+{
+    StreamLattice(0);
+
+    double ** tmp = F;
+    F = Ftemp;
+    Ftemp = tmp;
+
+    size_t Nblk = (Ncells+BLOCKSIZE-1)/BLOCKSIZE;
+
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t b=0;b<Nblk;b++)
+    {
+        size_t n0 = b*BLOCKSIZE;
+        MomentsSC(n0,std::min(BLOCKSIZE,Ncells-n0),F[0]);
+    }
+}
+
+inline void Domain::CollideStreamSC()
+{
+    // Each tile is swept plane by plane along the wavefront axis A, z or y for 2D lattices, so a plane
+    // is a set of contiguous x rows. Once plane i has been collided and pushed, plane i-1 holds every
+    // population coming from inside the tile, so its moments are computed while it is still in cache.
+    // Only cells on the tile faces, which also receive from the neighbouring tiles, are left for the
+    // second sweep. The other axes wrap onto themselves when a single tile covers them.
+    size_t A = Ndim(2)>1 ? 2 : 1;
+    size_t Q = 3-A;
+    size_t N[3],B[3],T[3];
+    for (size_t j=0;j<3;j++)
+    {
+        N[j] = Ndim(j);
+        B[j] = std::max(std::min((size_t)Tile(j),N[j]),(size_t)1);
+        T[j] = (N[j]+B[j]-1)/B[j];
+    }
+
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t t=0;t<T[0]*T[1]*T[2];t++)
+    {
+        size_t lo[3],hi[3],in[3],ie[3];
+        size_t it[3] = {t%T[0],(t/T[0])%T[1],t/(T[0]*T[1])};
+        for (size_t j=0;j<3;j++)
+        {
+            lo[j] = it[j]*B[j];
+            hi[j] = std::min(lo[j]+B[j],N[j]);
+            in[j] = B[j]==N[j] ? lo[j] : lo[j]+1;
+            ie[j] = B[j]==N[j] ? hi[j] : hi[j]-1;
+        }
+        size_t i[3];
+        for (i[A]=lo[A];i[A]<hi[A];i[A]++)
+        {
+            for (i[Q]=lo[Q];i[Q]<hi[Q];i[Q]++)
+            for (i[0]=lo[0];i[0]<hi[0];i[0]+=BLOCKSIZE)
+            {
+                size_t Nb = std::min(BLOCKSIZE,hi[0]-i[0]);
+                double Fo[Nb*Nneigh];
+                CollideRowSC(Idx(i[0],i[1],i[2]),Nb,Fo);
+                for (size_t k=0;k<Nneigh;k++)
+                {
+                    size_t niy = (size_t)((int)i[1] + (int)C[k](1) + (int)N[1])%N[1];
+                    size_t niz = (size_t)((int)i[2] + (int)C[k](2) + (int)N[2])%N[2];
+                    size_t nix = (size_t)((int)i[0] + (int)C[k](0) + (int)N[0])%N[0];
+                    double * Fk = Ftemp[0]+k*Nstride+Idx(0,niy,niz);
+                    for (size_t j=0;j<Nb;j++)
+                    {
+                        Fk[nix] = Fo[j*Nneigh+k];
+                        if (++nix==N[0]) nix = 0;
+                    }
+                }
+            }
+            if (i[A]<lo[A]+2||in[0]>=ie[0]) continue;
+            size_t j[3];
+            j[A] = i[A]-1;
+            for (j[Q]=in[Q];j[Q]<ie[Q];j[Q]++)
+            {
+                MomentsSC(Idx(in[0],j[1],j[2]),ie[0]-in[0],Ftemp[0]);
+            }
+        }
+    }
+
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t r=0;r<N[1]*N[2];r++)
+    {
+        size_t iv[3] = {0,r%N[1],r/N[1]};
+        size_t n0    = Idx(0,iv[1],iv[2]);
+        bool   face  = false;
+        for (size_t j=1;j<3;j++)
+        {
+            if (j!=A&&B[j]==N[j]) continue;
+            size_t m = iv[j]%B[j];
+            face = face||m==0||m==B[j]-1||iv[j]==N[j]-1;
+        }
+        if (face)
         {
-            size_t nix = (size_t)((int)ix + (int)C[k](0) + (int)Ndim(0))%Ndim(0);
-            size_t niy = (size_t)((int)iy + (int)C[k](1) + (int)Ndim(1))%Ndim(1);
-            size_t niz = (size_t)((int)iz + (int)C[k](2) + (int)Ndim(2))%Ndim(2);
-            Ftemp[0][nix][niy][niz][k] = F[0][ix][iy][iz][k];
+            MomentsSC(n0,N[0],Ftemp[0]);
+            continue;
+        }
+        if (B[0]==N[0]) continue;
+        for (size_t ix=0;ix<N[0];ix++)
+        {
+            size_t m = ix%B[0];
+            if (m==0||m==B[0]-1||ix==N[0]-1) MomentsSC(n0+ix,1,Ftemp[0]);
         }
     }
 
-    double ***** tmp = F;
+    double ** tmp = F;
+    F = Ftemp;
+    Ftemp = tmp;
+}
+
+inline void Domain::StreamMP()
+{
+    for (size_t il=0;il<Nl;il++)
+    {
+        StreamLattice(il);
+    }
+
+    double ** tmp = F;
     F = Ftemp;
     Ftemp = tmp;
 
     #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     #endif
-    for (size_t ix=0;ix<nx;ix++)
-    for (size_t iy=0;iy<ny;iy++)
-    for (size_t iz=0;iz<nz;iz++)
+    for (size_t n=0;n<Ncells;n++)
     {
-        BForce[0][ix][iy][iz] = OrthoSys::O;
-        Vel   [0][ix][iy][iz] = OrthoSys::O;
-        Rho   [0][ix][iy][iz] = 0.0;
-        if (!IsSolid[0][ix][iy][iz])
+        for (size_t il=0;il<Nl;il++)
         {
-            for (size_t k=0;k<Nneigh;k++)
+            BForce[il][n] = OrthoSys::O;
+            Vel   [il][n] = OrthoSys::O;
+            Rho   [il][n] = 0.0;
+            if (!IsSolid[il][n])
             {
-                Rho[0][ix][iy][iz] +=  F[0][ix][iy][iz][k];
-                Vel[0][ix][iy][iz] +=  F[0][ix][iy][iz][k]*C[k];
+                for (size_t k=0;k<Nneigh;k++)
+                {
+                    Rho[il][n] +=  F[il][k*Nstride+n];
+                    Vel[il][n] +=  F[il][k*Nstride+n]*C[k];
+                }
+                Vel[il][n] *= Cs*Rho[il][n];
             }
-            Vel[0][ix][iy][iz] *= Cs/Rho[0][ix][iy][iz];
         }
     }
 }
 
-inline void Domain::StreamMP()
+inline void Domain::UpLoadHost()
 {
-    size_t nx = Ndim(0);
-    size_t ny = Ndim(1);
-    size_t nz = Ndim(2);
+    if (hF==NULL)
+    {
+        hF         = new double      * [Nl];
+        hFtemp     = new double      * [Nl];
+        hIsSolid   = new bool        * [Nl];
+        hBForce    = new lbm_double3 * [Nl];
+        hVel       = new lbm_double3 * [Nl];
+        hRho       = new double      * [Nl];
+        lbm_double3 zero = {{0.0,0.0,0.0,0.0}};
+        for (size_t il=0;il<Nl;il++)
+        {
+            hF       [il] = NewBlock<double>     (Ncells*Nneigh,0.0 );
+            hFtemp   [il] = NewBlock<double>     (Ncells*Nneigh,0.0 );
+            hIsSolid [il] = NewBlock<bool>       (Ncells       ,false);
+            hBForce  [il] = NewBlock<lbm_double3>(Ncells       ,zero);
+            hVel     [il] = NewBlock<lbm_double3>(Ncells       ,zero);
+            hRho     [il] = NewBlock<double>     (Ncells       ,0.0 );
+        }
+    }
+
+    hAux.Nx        = Ndim(0);
+    hAux.Ny        = Ndim(1);
+    hAux.Nz        = Ndim(2);
+    hAux.Nneigh    = Nneigh;
+    hAux.NCPairs   = NCellPairs;
+    hAux.Nl        = Nl;
+    hAux.Gmix      = Gmix;
+    hAux.Cs        = Cs;
+    hAux.Sc        = Sc;
+
+    for (size_t nn=0;nn<Nneigh;nn++)
+    {
+       hAux.C  [nn].s[0] = C  [nn](0); 
+       hAux.C  [nn].s[1] = C  [nn](1); 
+       hAux.C  [nn].s[2] = C  [nn](2); 
+       hAux.EEk[nn]      = EEk[nn]   ; 
+       hAux.W  [nn]      = W  [nn]   ;
+       hAux.Op [nn]      = Op [nn]   ;
+    }
 
     for (size_t il=0;il<Nl;il++)
     {
+        hAux.Tau     [il]    = Tau     [il];
+        hAux.G       [il]    = G       [il];
+        hAux.Gs      [il]    = Gs      [il];
+        hAux.Rhoref  [il]    = Rhoref  [il];
+        hAux.Psi     [il]    = Psi     [il];
+
         #ifdef USE_OMP
         #pragma omp parallel for schedule(static) num_threads(Nproc)
         #endif
-        for (size_t ix=0;ix<nx;ix++)
-        for (size_t iy=0;iy<ny;iy++)
-        for (size_t iz=0;iz<nz;iz++)
+        for (size_t n=0;n<Ncells;n++)
         {
-            for (size_t k=0;k<Nneigh;k++)
+            hIsSolid[il][n]      = IsSolid  [il][n];
+            hRho    [il][n]      = Rho      [il][n];
+            hVel    [il][n].s[0] = Vel      [il][n][0];
+            hVel    [il][n].s[1] = Vel      [il][n][1];
+            hVel    [il][n].s[2] = Vel      [il][n][2];
+            hBForce [il][n].s[0] = BForce   [il][n][0];
+            hBForce [il][n].s[1] = BForce   [il][n][1];
+            hBForce [il][n].s[2] = BForce   [il][n][2];
+            for (size_t nn=0;nn<Nneigh;nn++)
             {
-                size_t nix = (size_t)((int)ix + (int)C[k](0) + (int)Ndim(0))%Ndim(0);
-                size_t niy = (size_t)((int)iy + (int)C[k](1) + (int)Ndim(1))%Ndim(1);
-                size_t niz = (size_t)((int)iz + (int)C[k](2) + (int)Ndim(2))%Ndim(2);
-                Ftemp[il][nix][niy][niz][k] = F[il][ix][iy][iz][k];
+                hF    [il][n*Nneigh+nn] = F    [il][nn*Nstride+n];
+                hFtemp[il][n*Nneigh+nn] = Ftemp[il][nn*Nstride+n];
             }
         }
     }
+}
 
-    double ***** tmp = F;
-    F = Ftemp;
-    Ftemp = tmp;
+inline void Domain::DnLoadHost()
+{
+    for (size_t il=0;il<Nl;il++)
+    {
+        #ifdef USE_OMP
+        #pragma omp parallel for schedule(static) num_threads(Nproc)
+        #endif
+        for (size_t n=0;n<Ncells;n++)
+        {
+            Rho[il][n]    =  hRho[il][n]     ;
+            Vel[il][n][0] =  hVel[il][n].s[0];
+            Vel[il][n][1] =  hVel[il][n].s[1];
+            Vel[il][n][2] =  hVel[il][n].s[2];
+        }
+    }
+}
+
+inline size_t Domain::NeighHost(size_t ic, size_t k)
+{
+    size_t Nx  = hAux.Nx;
+    size_t Ny  = hAux.Ny;
+    size_t Nz  = hAux.Nz;
+    size_t icx = ic%Nx;
+    size_t icy = (ic/Nx)%Ny;
+    size_t icz = ic/(Nx*Ny);
+    size_t inx = (size_t)((long)icx + (long)hAux.C[k].s[0] + (long)Nx)%Nx;
+    size_t iny = (size_t)((long)icy + (long)hAux.C[k].s[1] + (long)Ny)%Ny;
+    size_t inz = (size_t)((long)icz + (long)hAux.C[k].s[2] + (long)Nz)%Nz;
+    return inx + iny*Nx + inz*Nx*Ny;
+}
+
+inline void Domain::ApplyForceHost()
+{
+    lbm_aux const & a = hAux;
+    if (Nl==1)
+    {
+        // Nothing to add when there is no cohesion at all
+        if (fabs(a.G[0])<1.0e-12&&fabs(a.Gs[0])<1.0e-12) return;
+
+        bool   const * IsSolid = hIsSolid[0];
+        double const * Rho     = hRho    [0];
+        lbm_double3  * BForce  = hBForce [0];
+
+        #ifdef USE_OMP
+        #pragma omp parallel for schedule(static) num_threads(Nproc)
+        #endif
+        for (size_t ic=0;ic<Ncells;ic++)
+        for (size_t k=1;k<a.Nneigh;k++)
+        {
+            size_t in   = NeighHost(ic,k);
+            double psic = 1.0;
+            double psin = 1.0;
+            double G    = a.G[0];
+            if (!IsSolid[ic]) psic = a.Psi[0]*exp(-a.Rhoref[0]/Rho[ic]);
+            if (!IsSolid[in]) psin = a.Psi[0]*exp(-a.Rhoref[0]/Rho[in]);
+            else              G    = a.Gs[0];
+
+            double s = -G*a.W[k]*psic*psin;
+            for (size_t d=0;d<3;d++) BForce[ic].s[d] += s*a.C[k].s[d];
+        }
+        return;
+    }
+
+    bool   const * IsSolid0 = hIsSolid[0];
+    bool   const * IsSolid1 = hIsSolid[1];
+    double const * Rho0     = hRho    [0];
+    double const * Rho1     = hRho    [1];
+    lbm_double3  * BForce0  = hBForce [0];
+    lbm_double3  * BForce1  = hBForce [1];
+    bool           SCMP     = (fabs(a.G[0])>1.0e-12)||(fabs(a.G[1])>1.0e-12);
+
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+    for (size_t ic=0;ic<Ncells;ic++)
+    for (size_t k=1;k<a.Nneigh;k++)
+    {
+        size_t in   = NeighHost(ic,k);
+        double psic = 0.0;
+        double psin = 0.0;
+        double G    = 0.0;
+        double s    = 0.0;
+
+        if (SCMP)
+        {
+            psic = 0.0;
+            psin = 0.0;
+            G    = a.G[0];
+            if (!IsSolid0[ic]) psic = a.Psi[0]*exp(-a.Rhoref[0]/Rho0[ic]);
+            if (!IsSolid0[in]) psin = a.Psi[0]*exp(-a.Rhoref[0]/Rho0[in]);
+            else               G    = a.Gs[0];
+            s = -G*a.W[k]*psic*psin;
+            for (size_t d=0;d<3;d++) BForce0[ic].s[d] += s*a.C[k].s[d];
+
+            psic = 0.0;
+            psin = 0.0;
+            G    = a.G[1];
+            if (!IsSolid1[ic]) psic = a.Psi[1]*exp(-a.Rhoref[1]/Rho1[ic]);
+            if (!IsSolid1[in]) psin = a.Psi[1]*exp(-a.Rhoref[1]/Rho1[in]);
+            else               G    = a.Gs[1];
+            s = -G*a.W[k]*psic*psin;
+            for (size_t d=0;d<3;d++) BForce1[ic].s[d] += s*a.C[k].s[d];
+        }
+
+        psic = 1.0;
+        psin = 1.0;
+        G    = a.Gmix;
+        if (!IsSolid0[ic]) psic = Rho0[ic];
+        if (!IsSolid1[in]) psin = Rho1[in];
+        else               G    = a.Gs[0];
+        s = -G*a.W[k]*psic*psin;
+        for (size_t d=0;d<3;d++) BForce0[ic].s[d] += s*a.C[k].s[d];
+
+        psic = 1.0;
+        psin = 1.0;
+        G    = a.Gmix;
+        if (!IsSolid1[ic]) psic = Rho1[ic];
+        if (!IsSolid0[in]) psin = Rho0[in];
+        else               G    = a.Gs[1];
+        s = -G*a.W[k]*psic*psin;
+        for (size_t d=0;d<3;d++) BForce1[ic].s[d] += s*a.C[k].s[d];
+    }
+}
+
+inline void Domain::CollideHost()
+{
+    lbm_aux const & a = hAux;
+    size_t const    N = a.Nneigh;
+    double const    Cs = a.Cs;
 
     #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     #endif
-    for (size_t ix=0;ix<nx;ix++)
-    for (size_t iy=0;iy<ny;iy++)
-    for (size_t iz=0;iz<nz;iz++)
+    for (size_t ic=0;ic<Ncells;ic++)
     {
+        // Vmix is only used by the multicomponent kernel
+        double Vmix[3] = {0.0,0.0,0.0};
+        if (Nl>1)
+        {
+            double den = hRho[0][ic]/a.Tau[0] + hRho[1][ic]/a.Tau[1];
+            for (size_t d=0;d<3;d++)
+            {
+                Vmix[d] = (hRho[0][ic]*hVel[0][ic].s[d]/a.Tau[0] + hRho[1][ic]*hVel[1][ic].s[d]/a.Tau[1])/den;
+            }
+        }
+
         for (size_t il=0;il<Nl;il++)
         {
-            BForce[il][ix][iy][iz] = OrthoSys::O;
-            Vel   [il][ix][iy][iz] = OrthoSys::O;
-            Rho   [il][ix][iy][iz] = 0.0;
-            if (!IsSolid[il][ix][iy][iz])
+            double * F     = hF    [il]+ic*N;
+            double * Ftemp = hFtemp[il]+ic*N;
+            if (!hIsSolid[il][ic])
             {
-                for (size_t k=0;k<Nneigh;k++)
+                double rho = hRho[il][ic];
+                double tau = a.Tau[il];
+                double vel[3];
+                for (size_t d=0;d<3;d++)
                 {
-                    Rho[il][ix][iy][iz] +=  F[il][ix][iy][iz][k];
-                    Vel[il][ix][iy][iz] +=  F[il][ix][iy][iz][k]*C[k];
+                    double v0 = Nl==1 ? hVel[il][ic].s[d] : Vmix[d];
+                    vel[d] = v0 + a.Tau[il]*hBForce[il][ic].s[d]/rho;
                 }
-                Vel[il][ix][iy][iz] *= Cs*Rho[il][ix][iy][iz];
+                double VdotV = vel[0]*vel[0] + vel[1]*vel[1] + vel[2]*vel[2];
+                double NonEq[27];
+                double Q = 0.0;
+                for (size_t k=0;k<N;k++)
+                {
+                    double VdotC = vel[0]*a.C[k].s[0] + vel[1]*a.C[k].s[1] + vel[2]*a.C[k].s[2];
+                    double Feq   = a.W[k]*rho*(1.0 + 3.0*VdotC/Cs + 4.5*VdotC*VdotC/(Cs*Cs) - 1.5*VdotV/(Cs*Cs));
+                    NonEq[k]     = F[k] - Feq;
+                    Q           += NonEq[k]*NonEq[k]*a.EEk[k];
+                }
+                // Only the single component kernel uses the Smagorinsky model
+                if (Nl==1)
+                {
+                    Q   = sqrt(2.0*Q);
+                    tau = 0.5*(tau+sqrt(tau*tau + 6.0*Q*a.Sc/rho));
+                }
+
+                bool valid = true;
+                double alpha = 1.0;
+                while (valid)
+                {
+                    valid = false;
+                    for (size_t k=0;k<N;k++)
+                    {
+                        Ftemp[k] = F[k] - alpha*(NonEq[k]/tau);
+                        if (Ftemp[k]<-1.0e-12)
+                        {
+                            double temp = tau*F[k]/(NonEq[k]);
+                            if (temp<alpha) alpha = temp;
+                            valid = true;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                for (size_t k=0;k<N;k++)
+                {
+                    Ftemp[k] = F[a.Op[k]];
+                }
+            }
+        }
+        for (size_t il=0;il<Nl;il++)
+        for (size_t k=0;k<N;k++)
+        {
+            hF[il][ic*N + k] = hFtemp[il][ic*N + k];
+        }
+    }
+}
+
+inline void Domain::StreamHost()
+{
+    lbm_aux const & a = hAux;
+    size_t const    N = a.Nneigh;
+    for (size_t il=0;il<Nl;il++)
+    {
+        double * F     = hF    [il];
+        double * Ftemp = hFtemp[il];
+
+        // Stream1: the rest population stays in Ftemp from the collision
+        #ifdef USE_OMP
+        #pragma omp parallel for schedule(static) num_threads(Nproc)
+        #endif
+        for (size_t ic=0;ic<Ncells;ic++)
+        for (size_t k=1;k<N;k++)
+        {
+            Ftemp[NeighHost(ic,k)*N + k] = F[ic*N + k];
+        }
+
+        // Stream2
+        #ifdef USE_OMP
+        #pragma omp parallel for schedule(static) num_threads(Nproc)
+        #endif
+        for (size_t ic=0;ic<Ncells;ic++)
+        {
+            double rho    = 0.0;
+            double vel[3] = {0.0,0.0,0.0};
+            for (size_t k=0;k<N;k++)
+            {
+                F[ic*N + k] = Ftemp[ic*N + k];
+            }
+            hBForce[il][ic].s[0] = 0.0;
+            hBForce[il][ic].s[1] = 0.0;
+            hBForce[il][ic].s[2] = 0.0;
+            if (!hIsSolid[il][ic])
+            {
+                for (size_t k=0;k<N;k++)
+                {
+                    rho += F[ic*N + k];
+                    for (size_t d=0;d<3;d++) vel[d] += F[ic*N + k]*a.C[k].s[d];
+                }
+                for (size_t d=0;d<3;d++) vel[d] /= rho;
             }
+            hRho[il][ic] = rho;
+            for (size_t d=0;d<3;d++) hVel[il][ic].s[d] = vel[d];
         }
     }
 }
@@ -1180,6 +1607,8 @@ inline void Domain::StreamMP()
 #ifdef USE_OCL
 inline void Domain::UpLoadDevice()
 {
+    // The packed host buffers have exactly the layout of the device buffers
+    UpLoadHost();
 
     bF         = new cl::Buffer [Nl];
     bFtemp     = new cl::Buffer [Nl];
@@ -1190,36 +1619,8 @@ inline void Domain::UpLoadDevice()
     
     blbmaux    = cl::Buffer(CL_Context,CL_MEM_READ_WRITE,sizeof(lbm_aux   )              );
 
-    lbm_aux lbmaux[1];
-
-    lbmaux[0].Nx = Ndim(0);
-    lbmaux[0].Ny = Ndim(1);
-    lbmaux[0].Nz = Ndim(2);
-    lbmaux[0].Nneigh    = Nneigh;
-    lbmaux[0].NCPairs   = NCellPairs;
-    lbmaux[0].Nl        = Nl;
-    lbmaux[0].Gmix      = Gmix;
-    lbmaux[0].Cs        = Cs;
-    lbmaux[0].Sc        = Sc;
-
-    for (size_t nn=0;nn<Nneigh;nn++)
-    {
-       lbmaux[0].C  [nn].s[0] = C  [nn](0); 
-       lbmaux[0].C  [nn].s[1] = C  [nn](1); 
-       lbmaux[0].C  [nn].s[2] = C  [nn](2); 
-       lbmaux[0].EEk[nn]      = EEk[nn]   ; 
-       lbmaux[0].W  [nn]      = W  [nn]   ;
-       lbmaux[0].Op [nn]      = Op [nn]   ;
-    }
-
     for (size_t il=0;il<Nl;il++)
     {
-        lbmaux[0].Tau     [il]    = Tau     [il];
-        lbmaux[0].G       [il]    = G       [il];
-        lbmaux[0].Gs      [il]    = Gs      [il];
-        lbmaux[0].Rhoref  [il]    = Rhoref  [il];
-        lbmaux[0].Psi     [il]    = Psi     [il];
-
         bF       [il]  = cl::Buffer(CL_Context,CL_MEM_READ_WRITE,sizeof(double    )*Ncells*Nneigh);            
         bFtemp   [il]  = cl::Buffer(CL_Context,CL_MEM_READ_WRITE,sizeof(double    )*Ncells*Nneigh); 
         bIsSolid [il]  = cl::Buffer(CL_Context,CL_MEM_READ_WRITE,sizeof(bool      )*Ncells       );
@@ -1227,60 +1628,14 @@ inline void Domain::UpLoadDevice()
         bVel     [il]  = cl::Buffer(CL_Context,CL_MEM_READ_WRITE,sizeof(cl_double3)*Ncells       ); 
         bRho     [il]  = cl::Buffer(CL_Context,CL_MEM_READ_WRITE,sizeof(double    )*Ncells       ); 
 
-
-        bool       *IsSolidCL;
-        double     *FCL,*FtempCL,*RhoCL;
-        cl_double3 *VelCL,*BForceCL;
-        FCL        = new double    [Ncells*Nneigh];
-        FtempCL    = new double    [Ncells*Nneigh];
-        IsSolidCL  = new bool      [Ncells       ];
-        RhoCL      = new double    [Ncells       ];
-        VelCL      = new cl_double3[Ncells       ];
-        BForceCL   = new cl_double3[Ncells       ];
-    
-        size_t Nn = 0;
-        size_t Nm = 0;
-        for (size_t nz=0;nz<Ndim(2);nz++)
-        {
-            for (size_t ny=0;ny<Ndim(1);ny++)
-            {
-                for (size_t nx=0;nx<Ndim(0);nx++)
-                {
-                    IsSolidCL[Nm]      = IsSolid  [il][nx][ny][nz];
-                    RhoCL    [Nm]      = Rho      [il][nx][ny][nz];
-                    VelCL    [Nm].s[0] = Vel      [il][nx][ny][nz][0];
-                    VelCL    [Nm].s[1] = Vel      [il][nx][ny][nz][1];
-                    VelCL    [Nm].s[2] = Vel      [il][nx][ny][nz][2];
-                    BForceCL [Nm].s[0] = BForce   [il][nx][ny][nz][0];
-                    BForceCL [Nm].s[1] = BForce   [il][nx][ny][nz][1];
-                    BForceCL [Nm].s[2] = BForce   [il][nx][ny][nz][2];
-                    Nm++;
-                    for (size_t nn=0;nn<Nneigh;nn++)
-                    {
-                        FCL    [Nn] = F    [il][nx][ny][nz][nn];
-                        FtempCL[Nn] = Ftemp[il][nx][ny][nz][nn];
-                        Nn++;
-                    }
-                }
-            }
-        }
-
-        CL_Queue.enqueueWriteBuffer(bF      [il],CL_TRUE,0,sizeof(double    )*Ncells*Nneigh,FCL       );  
-        CL_Queue.enqueueWriteBuffer(bFtemp  [il],CL_TRUE,0,sizeof(double    )*Ncells*Nneigh,FtempCL   );  
-        CL_Queue.enqueueWriteBuffer(bIsSolid[il],CL_TRUE,0,sizeof(bool      )*Ncells       ,IsSolidCL );  
-        CL_Queue.enqueueWriteBuffer(bBForce [il],CL_TRUE,0,sizeof(cl_double3)*Ncells       ,BForceCL  );  
-        CL_Queue.enqueueWriteBuffer(bVel    [il],CL_TRUE,0,sizeof(cl_double3)*Ncells       ,VelCL     );  
-        CL_Queue.enqueueWriteBuffer(bRho    [il],CL_TRUE,0,sizeof(double    )*Ncells       ,RhoCL     );  
-        
-
-        delete [] FCL       ;
-        delete [] FtempCL   ;
-        delete [] IsSolidCL ;
-        delete [] RhoCL     ;
-        delete [] VelCL     ;
-        delete [] BForceCL  ;
+        CL_Queue.enqueueWriteBuffer(bF      [il],CL_TRUE,0,sizeof(double    )*Ncells*Nneigh,hF      [il]);  
+        CL_Queue.enqueueWriteBuffer(bFtemp  [il],CL_TRUE,0,sizeof(double    )*Ncells*Nneigh,hFtemp  [il]);  
+        CL_Queue.enqueueWriteBuffer(bIsSolid[il],CL_TRUE,0,sizeof(bool      )*Ncells       ,hIsSolid[il]);  
+        CL_Queue.enqueueWriteBuffer(bBForce [il],CL_TRUE,0,sizeof(cl_double3)*Ncells       ,hBForce [il]);  
+        CL_Queue.enqueueWriteBuffer(bVel    [il],CL_TRUE,0,sizeof(cl_double3)*Ncells       ,hVel    [il]);  
+        CL_Queue.enqueueWriteBuffer(bRho    [il],CL_TRUE,0,sizeof(double    )*Ncells       ,hRho    [il]);  
     }
-    CL_Queue.enqueueWriteBuffer(blbmaux  ,CL_TRUE,0,sizeof(lbm_aux   )              ,lbmaux    );  
+    CL_Queue.enqueueWriteBuffer(blbmaux  ,CL_TRUE,0,sizeof(lbm_aux   )              ,&hAux     );  
 
     cl::Kernel kernel = cl::Kernel(CL_Program,"CheckUpLoad");
     kernel.setArg(0,blbmaux );
@@ -1292,32 +1647,10 @@ inline void Domain::DnLoadDevice()
 {
     for (size_t il=0;il<Nl;il++)
     {
-        double     * RhoCL;
-        cl_double3 * VelCL;
-        RhoCL      = new double    [Ncells];
-        VelCL      = new cl_double3[Ncells];
-
-        CL_Queue.enqueueReadBuffer(bRho[il],CL_TRUE,0,sizeof(double    )*Ncells,RhoCL);
-        CL_Queue.enqueueReadBuffer(bVel[il],CL_TRUE,0,sizeof(cl_double3)*Ncells,VelCL);
-
-        size_t Nm = 0;
-        for (size_t nz=0;nz<Ndim(2);nz++)
-        {
-            for (size_t ny=0;ny<Ndim(1);ny++)
-            {
-                for (size_t nx=0;nx<Ndim(0);nx++)
-                {
-                    Rho[il][nx][ny][nz]    =  RhoCL[Nm]     ;
-                    Vel[il][nx][ny][nz][0] =  VelCL[Nm].s[0];
-                    Vel[il][nx][ny][nz][1] =  VelCL[Nm].s[1];
-                    Vel[il][nx][ny][nz][2] =  VelCL[Nm].s[2];
-                    Nm++;
-                }
-            }
-        }
-        delete [] RhoCL     ;
-        delete [] VelCL     ;
+        CL_Queue.enqueueReadBuffer(bRho[il],CL_TRUE,0,sizeof(double    )*Ncells,hRho[il]);
+        CL_Queue.enqueueReadBuffer(bVel[il],CL_TRUE,0,sizeof(cl_double3)*Ncells,hVel[il]);
     }
+    DnLoadHost();
 }
 
 inline void Domain::ApplyForceCL()
@@ -1426,6 +1759,8 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
                           char const * TheFileKey, bool RenderVideo, size_t TheNproc)
 {
     #ifdef USE_OCL 
+    if (!CLHost)
+    {
     std::vector<cl::Platform> all_platforms;
     cl::Platform::get(&all_platforms);
     if (all_platforms.size()==0)
@@ -1465,6 +1800,7 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
     CL_Queue   = cl::CommandQueue(CL_Context,CL_Device);
 
     N_Groups   = CL_Device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+    }
     #endif
 
 
@@ -1479,11 +1815,18 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
     {
     printf("%s  Tau of Lattice %zd                 =  %g%s\n"       ,TERM_CLR2, i, Tau[i]                             , TERM_RST);
     }
+    if (CLHost)
+    {
+    printf("%s  Using the OpenCL kernels on host =  %zd threads%s\n", TERM_CLR2, Nproc                                 , TERM_RST);
+    }
     #ifdef USE_OCL
+    else
+    {
     //printf("%s  Using GPU:                       =  %c%s\n"     ,TERM_CLR2, Default_Device.getInfo<CL_DEVICE_NAME>(), TERM_RST);
     std::cout 
         << TERM_CLR2 
         << "  Using GPU:                       =  " << CL_Device.getInfo<CL_DEVICE_NAME>() << TERM_RST << std::endl;
+    }
     #endif
    
     {
@@ -1520,8 +1863,9 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
     }
 
     //std::cout << "1" << std::endl;
+    if (CLHost) UpLoadHost();
     #ifdef USE_OCL
-    UpLoadDevice();
+    else UpLoadDevice();
     #endif
     
     //std::cout << "2" << std::endl;
@@ -1533,8 +1877,9 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
         if (Time >= tout)
         {
             //std::cout << "3" << std::endl;
+            if (CLHost) DnLoadHost();
             #ifdef USE_OCL
-            DnLoadDevice();
+            else DnLoadDevice();
             #endif
             //std::cout << "4" << std::endl;
             if (TheFileKey!=NULL)
@@ -1556,17 +1901,30 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
         }
 
         //The LBM dynamics
+        if (CLHost)
+        {
+            ApplyForceHost();
+            CollideHost();
+            StreamHost();
+        }
         #ifdef USE_OCL
-        ApplyForceCL();
-        CollideCL();
-        StreamCL();
+        else
+        {
+            ApplyForceCL();
+            CollideCL();
+            StreamCL();
+        }
         #else
-        if (Nl==1)
+        else if (Nl==1)
         {
             if (fabs(G[0])>1.0e-12) ApplyForcesSC();
-            CollideSC();
-            //CollideMRT();
-            StreamSC();
+            if (Tiled) CollideStreamSC();
+            else
+            {
+                CollideSC();
+                //CollideMRT();
+                StreamSC();
+            }
         }
         else
         {
@@ -1582,6 +1940,7 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
     }
 }
 
+const size_t Domain::BLOCKSIZE;
 const double Domain::WEIGHTSD2Q5   [ 5] = { 2./6., 1./6., 1./6., 1./6., 1./6 };
 const double Domain::WEIGHTSD2Q9   [ 9] = { 4./9., 1./9., 1./9., 1./9., 1./9., 1./36., 1./36., 1./36., 1./36. };
 const double Domain::WEIGHTSD3Q15  [15] = { 2./9., 1./9., 1./9., 1./9., 1./9.,  1./9.,  1./9., 1./72., 1./72. , 1./72., 1./72., 1./72., 1./72., 1./72., 1./72.};
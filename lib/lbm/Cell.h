@@ -68,10 +68,6 @@ public:
     void         Initialize(double Rho, Vec3_t const & V);         ///< Initialize cell with a given velocity and density
     void         BounceBack();                                     ///< Apply the bounceback rule to this cell
 
-#ifdef USE_OMP
-    omp_lock_t      lck;             ///< to protect variables in multithreading
-#endif
-
     // Data
     //LBMethod     Method;   ///< Is 2D, 3D and how many velocities it has
     bool         IsSolid;  ///< It is a solid node
@@ -101,7 +97,6 @@ public:
     double        * F;     ///< Distribution functions
     double        * Ftemp; ///< Temporary distribution functions
     double        * Omeis; ///< Array of collision operators
-    size_t        * Neighs;///< Array of neighbors indexes
 };
 
 inline Cell::Cell(size_t TheID, LBMethod TheMethod, iVec3_t TheIndexes, iVec3_t TheNdim, double TheCs, double TheTau)
@@ -150,30 +145,10 @@ inline Cell::Cell(size_t TheID, LBMethod TheMethod, iVec3_t TheIndexes, iVec3_t
     //Omeis .Resize(Nneigh);
     F      = new double [Nneigh];
     Ftemp  = new double [Nneigh];
-    Neighs = new size_t [Nneigh];
     Omeis  = new double [Nneigh];
     BForcef = 0.0,0.0,0.0;
 
-    //Set neighbors
-    for (size_t k=0;k<Nneigh;k++)
-    {
-        //iVec3_t nindex = Index + C[k];
-        blitz::TinyVector<int,3>   nindex;
-        nindex[0] = static_cast<int>(Index[0])+ C[k][0];
-        nindex[1] = static_cast<int>(Index[1])+ C[k][1];
-        nindex[2] = static_cast<int>(Index[2])+ C[k][2];
-        if (nindex[0]==                          -1) nindex[0] = TheNdim[0]-1;
-        if (nindex[0]==static_cast<int>(TheNdim[0])) nindex[0] = 0;
-        if (nindex[1]==                          -1) nindex[1] = TheNdim[1]-1;
-        if (nindex[1]==static_cast<int>(TheNdim[1])) nindex[1] = 0;
-        if (nindex[2]==                          -1) nindex[2] = TheNdim[2]-1;
-        if (nindex[2]==static_cast<int>(TheNdim[2])) nindex[2] = 0;
-
-        Neighs[k] =  nindex[0] + nindex[1]*TheNdim[0] + nindex[2]*TheNdim[0]*TheNdim[1];
-    }
-#ifdef USE_OMP
-    omp_init_lock(&lck);
-#endif
+    // Neighbours are not stored, see Lattice::Neigh and Lattice::Offset
 }
 
 inline double Cell::Density()
@@ -268,6 +243,70 @@ const Vec3_t Cell::LVELOCD3Q19 [19] =
     { 1, 0,-1}, {-1, 0, 1}, { 0, 1, 1}, { 0,-1,-1}, { 0, 1,-1}, { 0,-1, 1}
 };
 
+// Velocity sets known at compile time (same tables as above) for the templated collision kernels
+template<LBMethod M> struct VelSet;
+
+template<> struct VelSet<D2Q5>
+{
+    static constexpr size_t Q = 5;
+    static constexpr double W [ 5] = { 2./6., 1./6., 1./6., 1./6., 1./6.};
+    static constexpr int    CX[ 5] = { 0, 1, 0,-1, 0};
+    static constexpr int    CY[ 5] = { 0, 0, 1, 0,-1};
+    static constexpr int    CZ[ 5] = { 0, 0, 0, 0, 0};
+    static constexpr size_t OP[ 5] = { 0, 3, 4, 1, 2};
+};
+
+template<> struct VelSet<D2Q9>
+{
+    static constexpr size_t Q = 9;
+    static constexpr double W [ 9] = { 4./9., 1./9., 1./9., 1./9., 1./9., 1./36., 1./36., 1./36., 1./36.};
+    static constexpr int    CX[ 9] = { 0, 1, 0,-1, 0, 1,-1,-1, 1};
+    static constexpr int    CY[ 9] = { 0, 0, 1, 0,-1, 1, 1,-1,-1};
+    static constexpr int    CZ[ 9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    static constexpr size_t OP[ 9] = { 0, 3, 4, 1, 2, 7, 8, 5, 6};
+};
+
+template<> struct VelSet<D3Q15>
+{
+    static constexpr size_t Q = 15;
+    static constexpr double W [15] = { 2./9., 1./9., 1./9., 1./9., 1./9.,  1./9.,  1./9., 1./72., 1./72. , 1./72., 1./72., 1./72., 1./72., 1./72., 1./72.};
+    static constexpr int    CX[15] = { 0, 1,-1, 0, 0, 0, 0, 1,-1, 1,-1, 1,-1, 1,-1};
+    static constexpr int    CY[15] = { 0, 0, 0, 1,-1, 0, 0, 1,-1, 1,-1,-1, 1,-1, 1};
+    static constexpr int    CZ[15] = { 0, 0, 0, 0, 0, 1,-1, 1,-1,-1, 1, 1,-1,-1, 1};
+    static constexpr size_t OP[15] = { 0, 2, 1, 4, 3, 6, 5, 8, 7, 10, 9, 12, 11, 14, 13};
+};
+
+template<> struct VelSet<D3Q19>
+{
+    static constexpr size_t Q = 19;
+    static constexpr double W [19] = { 1./3., 1./18., 1./18., 1./18., 1./18., 1./18., 1./18., 1./36., 1./36., 1./36., 1./36., 1./36., 1./36., 1./36., 1./36., 1./36., 1./36., 1./36., 1./36.};
+    static constexpr int    CX[19] = { 0, 1,-1, 0, 0, 0, 0, 1,-1, 1,-1, 1,-1, 1,-1, 0, 0, 0, 0};
+    static constexpr int    CY[19] = { 0, 0, 0, 1,-1, 0, 0, 1,-1,-1, 1, 0, 0, 0, 0, 1,-1, 1,-1};
+    static constexpr int    CZ[19] = { 0, 0, 0, 0, 0, 1,-1, 0, 0, 0, 0, 1,-1,-1, 1, 1,-1,-1, 1};
+    static constexpr size_t OP[19] = { 0, 2, 1, 4, 3, 6, 5, 8, 7, 10, 9, 12, 11, 14, 13, 16, 15, 18, 17};
+};
+
+constexpr double VelSet<D2Q5 >::W [ 5];
+constexpr int    VelSet<D2Q5 >::CX[ 5];
+constexpr int    VelSet<D2Q5 >::CY[ 5];
+constexpr int    VelSet<D2Q5 >::CZ[ 5];
+constexpr size_t VelSet<D2Q5 >::OP[ 5];
+constexpr double VelSet<D2Q9 >::W [ 9];
+constexpr int    VelSet<D2Q9 >::CX[ 9];
+constexpr int    VelSet<D2Q9 >::CY[ 9];
+constexpr int    VelSet<D2Q9 >::CZ[ 9];
+constexpr size_t VelSet<D2Q9 >::OP[ 9];
+constexpr double VelSet<D3Q15>::W [15];
+constexpr int    VelSet<D3Q15>::CX[15];
+constexpr int    VelSet<D3Q15>::CY[15];
+constexpr int    VelSet<D3Q15>::CZ[15];
+constexpr size_t VelSet<D3Q15>::OP[15];
+constexpr double VelSet<D3Q19>::W [19];
+constexpr int    VelSet<D3Q19>::CX[19];
+constexpr int    VelSet<D3Q19>::CY[19];
+constexpr int    VelSet<D3Q19>::CZ[19];
+constexpr size_t VelSet<D3Q19>::OP[19];
+
 /*TODO: Go back to the previous version since this is not nice
  *      Changes made for g++ 4.3.2 */
 //Vec3_t Cell::LVELOCD2Q9  [ 9]; ///< Local velocities (D2Q9) 
@@ -54,6 +54,13 @@ struct ParticleCellPair
     Array<size_t> IGeo;   ///< Array of index of the geometric feature
 };
 
+enum HydroMode  ///< Hydrodynamic forces on the DEM substeps between two LBM steps (dtdem < dt)
+{
+    HydroImprint,  ///< Imprint the particles into the lattice again at every substep
+    HydroHold,     ///< Keep the forces of the last LBM step
+    HydroLinear    ///< Interpolate linearly between the forces of the last two LBM steps (lags one LBM step behind)
+};
+
 struct MtData;
 
 class Domain
@@ -118,21 +125,39 @@ public:
     void WriteFrac         (char const * FileKey);  ///< Save a xdmf file for fracture visualization
     void WriteXDMF         (char const * FileKey);  ///< Write the domain data in xdmf file
     void WriteXDMF_D       (char const * FileKey);  ///< Write the domain data in xdmf file with double precision
+#ifdef USE_MPI
+    void WriteXDMF_MPI     (char const * FileKey);  ///< Write the slab of each rank in its own h5 file and the xmf file gathering them
+#endif
     void Load              (char const * FileKey);  ///< Load particle data from Mechsys DEM
 #endif
     void UpdateLinkedCells ();                                                                                  ///< Update the linked cells
 
     void Initialize       (double dt=0.0);                                                                                              ///< Set the particles to a initial state and asign the possible insteractions
     void ApplyForce       (size_t n = 0, size_t Np = 1, bool MC=false);                                                                 ///< Apply the interaction forces
+    Vec3_t PairForce      (size_t ind1, size_t ind2, size_t vec, size_t j, size_t k, bool MC=false);                                    ///< Force on cell ind1 of lattice j from its neighbour ind2 (direction vec) of lattice k
     void CollideMRT       (size_t n = 0, size_t Np = 1);                                                                                ///< Apply the collision operator with DEM particles in the case of single component fluid
     void CollideSC        (size_t n = 0, size_t Np = 1);                                                                                ///< Apply the collision operator with DEM particles in the case of single component fluid
     void CollideMC        (size_t n = 0, size_t Np = 1);                                                                                ///< Apply the collision operator with DEM particles in the case of multiple component fluid
     void CollideNoPar     (size_t n = 0, size_t Np = 1);                                                                                ///< Apply the collision operator for the case of no DEM particles
+    void CollideSoA       (size_t n = 0, size_t Np = 1);                                                                                ///< Apply the single component collision operator over the packed lattice storage
+    template<class VS>
+    void CollideVS        (size_t n = 0, size_t Np = 1);                                                                                ///< CollideSoA specialized on the velocity set VS (see VelSet) and vectorized over cells
+    void CollideAA        (size_t n = 0, size_t Np = 1);                                                                                ///< Fused in-place stream and collision over a single packed buffer (AA pattern)
     void ImprintLatticeSC (size_t n = 0, size_t Np = 1);                                                                                ///< Imprint the DEM particles into the lattices when there is a single fluid component
     void ImprintLatticeMC (size_t n = 0, size_t Np = 1);                                                                                ///< Imprint the DEM particles into the lattices when there are multiple fluids
+    void StoreHydro       ();                                                                                                           ///< Record the hydrodynamic forces of an LBM step as F-Ff and T-Tf of the particles and disks
+    void ApplyHydro       (double s);                                                                                                   ///< Set F and T of the particles and disks to Ff and Tf plus the recorded hydrodynamic forces, s=0 those of the LBM step before and s=1 the last ones
+    double OverlapLength  (DEM::Particle * Pa, Vec3_t const & C, size_t const * IGeo, size_t Ngeo);                                     ///< Length (out of 12dx) of the edges of the cell centered at C covered by Pa, IGeo are the features of Pa next to the cell
+    void BuildStencils    ();                                                                                                           ///< Gather the particle cell pairs into the contiguous stencil of each particle
+    void BuildOverlapTable();                                                                                                           ///< Tabulate the mean overlap lengths for the radii of the particles (disks) when FastOverlap is set
+    bool StencilReuse     (size_t ip);                                                                                                  ///< The overlap lengths of particle ip can be reused (it moved less than ImprintTol*dx since they were evaluated)
+    void ClearImprint     (size_t Np = 1);                                                                                              ///< Clear the lattice before the imprint, only the cells left by the particles that moved when IncImprint is set
+#ifdef USE_MPI
+    void ReduceForces     ();                                                                                                           ///< Add up the hydrodynamic forces that each rank imprinted on the particles from its own slab
+#endif
     void Solve(double Tf, double dtOut, ptDFun_t ptSetup=NULL, ptDFun_t ptReport=NULL,
     char const * FileKey=NULL, bool RenderVideo=true, size_t Nproc=1);                                                                ///< Solve the Domain dynamics
-    void ResetContacts();                                                                                                             ///< Reset contacts for verlet method DEM
+    void ResetContacts(bool CellPairs=true);                                                                                          ///< Reset contacts for verlet method DEM, and the particle cell pairs if CellPairs
     void ResetDisplacements();                                                                                                        ///< Reset the displacements for the verlet method DEM
     double  MaxDisplacement();                                                                                                        ///< Give the maximun displacement of DEM particles
 
@@ -140,7 +165,7 @@ public:
     Array<pair<size_t, size_t> >                ListPosPairs;         ///< List of all possible particles pairs
 #elif USE_OMP
     Array<pair<size_t, size_t> >                ListPosPairs;         ///< List of all possible particles pairs
-    Array<pair<size_t, size_t> >                List2DPairs;          ///< List of all possible particles pairs in 2D
+    Array<pair<size_t, size_t> >                List2DPairs;          ///< List of all possible disk pairs in 2D
     iVec3_t                                     LCellDim;             ///< Dimensions of the linked cell array
     Array<Array <size_t> >                      LinkedCell;           ///< Linked Cell array for optimization.
     Vec3_t                                      LCxmin;               ///< Bounding box low   limit for the linked cell array
@@ -154,8 +179,13 @@ public:
     bool                                              PrtPer;         ///< Print percolation parameter when applicable
     bool                                            Finished;         ///< Has the simulation finished
     bool                                              Dilate;         ///< True if eroded particles should be dilated for visualization
+    bool                                                 SoA;         ///< Pack the lattice into structure of arrays storage while solving
+    bool                                           AAPattern;         ///< Stream and collide in place over a single packed buffer (implies SoA)
+    bool                                              Sparse;         ///< Pack only the fluid nodes and the solid nodes next to them (implies SoA), the other cells are NULL while solving
     Array<size_t>                                    FreePar;         ///< Particles that are free
     Array<size_t>                                  NoFreePar;         ///< Particles that are not free
+    Array<size_t>                                   FreeDisk;         ///< Disks in the linked cells, the free ones and the fixed ones not larger than them
+    Array<size_t>                                 NoFreeDisk;         ///< Fixed disks larger than the free ones, paired with all the disks in the linked cells
     String                                           FileKey;         ///< File Key for output files
     Array <Lattice>                                      Lat;         ///< Fluid Lattices
     Array <DEM::Particle *>                        Particles;         ///< Array of Particles
@@ -164,9 +194,30 @@ public:
     Array <LBM::DiskPair   *>                      DiskPairs;         ///< Array of interactons for 2D calculation
     Array <DEM::CInteracton *>                  CInteractons;         ///< Array of valid  collision interactons
     Array <DEM::BInteracton *>                  BInteractons;         ///< Cohesion interactons
-    Array <iVec3_t>                                CellPairs;         ///< Pairs of cells
     Array <ParticleCellPair>                    ParCellPairs;         ///< Pairs of cells and particles
-    set<pair<DEM::Particle *, DEM::Particle *> > Listofpairs;         ///< List of pair of particles associated per interacton for memory optimization
+    Array <size_t>                              StencilStart;         ///< First entry of the stencil of each particle (one more than particles, 3D single component imprint)
+    Array <size_t>                               StencilCell;         ///< Cell of each stencil entry, the entries of a particle are contiguous
+    Array <double>                                StencilLen;         ///< Overlap length of each stencil entry at the last geometric evaluation
+    Array <size_t>                           StencilGeoStart;         ///< First geometric feature of each stencil entry in StencilGeo (one more than entries)
+    Array <size_t>                                StencilGeo;         ///< Features of the particle next to each stencil entry
+    Array <int>                                 StencilValid;         ///< The overlap lengths of the particle have been evaluated since the stencils were built
+    Array <Vec3_t>                                  StencilX;         ///< Position of each particle at the last geometric evaluation
+    Array <Quaternion_t>                            StencilQ;         ///< Orientation of each particle at the last geometric evaluation
+    double                                        ImprintTol;         ///< Overlap lengths are reused while the particle surface moved less than ImprintTol*dx (0 evaluates them every step)
+    bool                                         FastOverlap;         ///< Take the overlap lengths of the partially covered cells from OvTable instead of SphereCube (DiskSquare). The table is a mean over directions, accurate for the sums over a particle but not for a single cell
+    bool                                          IncImprint;         ///< Keep the solid fractions between imprints and clear only the stencils of the particles that moved (3D single component)
+    bool                                           FullClear;         ///< The stencils were rebuilt and the next imprint has to clear the whole lattice
+    DEM::OverlapTable                                OvTable;         ///< Direction averaged overlap lengths, built by Solve when FastOverlap is set
+    HydroMode                                          Hydro;         ///< Hydrodynamic forces on the DEM substeps between two LBM steps
+    bool                                           LazyPairs;         ///< Rebuild the particle cell pairs only when the particles moved more than Alpha since they were built
+    size_t                                              Nsub;         ///< DEM substeps per LBM step (dt/dtdem)
+    Array <Vec3_t>                                      Fhyd;         ///< Hydrodynamic force of each particle then each disk at the last LBM step
+    Array <Vec3_t>                                      Thyd;         ///< Hydrodynamic torque of each particle then each disk at the last LBM step
+    Array <Vec3_t>                                     Fhyd0;         ///< Hydrodynamic force at the LBM step before
+    Array <Vec3_t>                                     Thyd0;         ///< Hydrodynamic torque at the LBM step before
+    Array <Vec3_t>                                     PairX;         ///< Position of each particle then each disk when the particle cell pairs were built
+    Array <Quaternion_t>                               PairQ;         ///< Orientation of each particle when the particle cell pairs were built
+    Util::PairSet                                Listofpairs;         ///< Index pairs of the particles that already have an interacton
     set<pair<LBM::Disk *, LBM::Disk *> >     ListofDiskPairs;         ///< List of pair of disks associated per interacton for memory optimization
     double                                              Time;         ///< Time of the simulation
     double                                                dt;         ///< Timestep
@@ -230,6 +281,16 @@ inline Domain::Domain(LBMethod Method, Array<double> nu, iVec3_t Ndim, double dx
     PrtVec = true;
     PrtDou = false;
     RotPar = true;
+    SoA    = false;
+    AAPattern = false;
+    Sparse    = false;
+    ImprintTol = 0.0;
+    FastOverlap = false;
+    IncImprint  = false;
+    FullClear   = true;
+    Hydro     = HydroImprint;
+    LazyPairs = false;
+    Nsub      = 1;
     Fconv  = 1.0;
 
 
@@ -265,6 +326,16 @@ inline Domain::Domain(LBMethod Method, double nu, iVec3_t Ndim, double dx, doubl
     PrtVec = true;
     PrtDou = false;
     RotPar = true;
+    SoA    = false;
+    AAPattern = false;
+    Sparse    = false;
+    ImprintTol = 0.0;
+    FastOverlap = false;
+    IncImprint  = false;
+    FullClear   = true;
+    Hydro     = HydroImprint;
+    LazyPairs = false;
+    Nsub      = 1;
     Fconv  = 1.0;
 
     EEk.Resize(Lat[0].Cells[0]->Nneigh);
@@ -727,6 +798,13 @@ inline void Domain::WriteFrac (char const * FileKey)
 
 inline void Domain::WriteXDMF(char const * FileKey)
 {
+#ifdef USE_MPI
+    if (Lat[0].Nranks>1)
+    {
+        WriteXDMF_MPI(FileKey);
+        return;
+    }
+#endif
     String fn(FileKey);
     fn.append(".h5");
     hid_t     file_id;
@@ -756,11 +834,19 @@ inline void Domain::WriteXDMF(char const * FileKey)
             for (size_t li=0;li<Step;li++)
             for (size_t mi=0;mi<Step;mi++)
             {
-                rho  += Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Rho;
-                gamma+= std::max(Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Gamma,(double) Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->IsSolid);
-                per  += Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Pf;
-                vel  += Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Vel;
-                vel  += dt*0.5*Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->BForce;
+                Cell * c = Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi));
+                if (c==NULL)
+                {
+                    // Solid interior of a sparse lattice
+                    gamma += 1.0;
+                    per   += 1.0;
+                    continue;
+                }
+                rho  += c->Rho;
+                gamma+= std::max(c->Gamma,(double) c->IsSolid);
+                per  += c->Pf;
+                vel  += c->Vel;
+                vel  += dt*0.5*c->BForce;
             }
             rho  /= Step*Step*Step;
             gamma/= Step*Step*Step;
@@ -1221,8 +1307,262 @@ inline void Domain::WriteXDMF(char const * FileKey)
     of.close();
 }
 
+#ifdef USE_MPI
+inline void Domain::WriteXDMF_MPI(char const * FileKey)
+{
+    // Every rank writes the planes it owns into its own h5 file and rank 0 writes an xmf file gathering
+    // all the slabs in a spatial collection, so the output of each time step is still a single xmf file
+    Lattice & L  = Lat[0];
+    size_t    Ax = L.Axis;
+    iVec3_t   St(Step,Step,L.Ndim(2)>1 ? Step : 1);
+    for (size_t r=0;r<L.Nranks;r++)
+    {
+        if ((r*L.Ndim(Ax)/L.Nranks)%Step!=0) throw new Fatal("Domain::WriteXDMF_MPI: the slab of rank %zd does not start at a multiple of Step = %zd",r,Step);
+    }
+    if (L.Ndim(Ax)%Step!=0) throw new Fatal("Domain::WriteXDMF_MPI: the %zd planes of the lattice are not a multiple of Step = %zd",size_t(L.Ndim(Ax)),Step);
+
+    String fn;
+    fn.Printf("%s_r%04zd.h5",FileKey,L.Rank);
+    hid_t     file_id;
+    file_id = H5Fcreate(fn.CStr(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    iVec3_t Lo(0,0,0);
+    iVec3_t Hi = L.Ndim;
+    Lo(Ax) = L.Org+1;
+    Hi(Ax) = L.Org+L.Ldim(Ax)-1;
+    size_t  Nx = (Hi(0)-Lo(0))/St(0);
+    size_t  Ny = (Hi(1)-Lo(1))/St(1);
+    size_t  Nz = (Hi(2)-Lo(2))/St(2);
+    double  Nb = St(0)*St(1)*St(2);
+    for (size_t j=0;j<Lat.Size();j++)
+    {
+        // Creating data sets
+        float * Density   = new float[  Nx*Ny*Nz];
+        float * Gamma     = new float[  Nx*Ny*Nz];
+        float * Per       = new float[  Nx*Ny*Nz];
+        float * Vvec      = new float[3*Nx*Ny*Nz];
+
+        size_t i=0;
+        for (size_t m=Lo(2);m<size_t(Hi(2));m+=St(2))
+        for (size_t l=Lo(1);l<size_t(Hi(1));l+=St(1))
+        for (size_t n=Lo(0);n<size_t(Hi(0));n+=St(0))
+        {
+            double rho    = 0.0;
+            double gamma  = 0.0;
+            double per    = 0.0;
+            Vec3_t vel    = OrthoSys::O;
+
+            for (size_t ni=0;ni<size_t(St(0));ni++)
+            for (size_t li=0;li<size_t(St(1));li++)
+            for (size_t mi=0;mi<size_t(St(2));mi++)
+            {
+                Cell * c = Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi));
+                if (c==NULL)
+                {
+                    // Solid interior of a sparse lattice
+                    gamma += 1.0;
+                    per   += 1.0;
+                    continue;
+                }
+                rho  += c->Rho;
+                gamma+= std::max(c->Gamma,(double) c->IsSolid);
+                per  += c->Pf;
+                vel  += c->Vel;
+                vel  += dt*0.5*c->BForce;
+            }
+            rho  /= Nb;
+            gamma/= Nb;
+            per  /= Nb;
+            vel  /= Nb;
+            Gamma   [i]  = gamma;
+            Per     [i]  = per;
+            Density [i]  = (float) rho   *(1.0-Gamma[i]);
+            Vvec[3*i  ]  = (float) vel(0)*(1.0-Gamma[i]);
+            Vvec[3*i+1]  = (float) vel(1)*(1.0-Gamma[i]);
+            Vvec[3*i+2]  = (float) vel(2)*(1.0-Gamma[i]);
+            i++;
+        }
+
+        //Write the data
+        hsize_t dims[1];
+        dims[0] = Nx*Ny*Nz;
+        String dsname;
+        dsname.Printf("Density_%d",j);
+        H5LTmake_dataset_float(file_id,dsname.CStr(),1,dims,Density );
+        if (j==0)
+        {
+            dsname.Printf("Gamma");
+            H5LTmake_dataset_float(file_id,dsname.CStr(),1,dims,Gamma   );
+            if (PrtPer)
+            {
+                dsname.Printf("Per");
+                H5LTmake_dataset_float(file_id,dsname.CStr(),1,dims,Per );
+            }
+        }
+        if (PrtVec)
+        {
+            dims[0] = 3*Nx*Ny*Nz;
+            dsname.Printf("Velocity_%d",j);
+            H5LTmake_dataset_float(file_id,dsname.CStr(),1,dims,Vvec    );
+        }
+
+        delete [] Density ;
+        delete [] Gamma   ;
+        delete [] Per     ;
+        delete [] Vvec    ;
+    }
+
+    // The particles are the same in every rank, only rank 0 writes their centres
+    if (L.Rank==0&&Particles.Size()>0)
+    {
+        float * Radius = new float[  Particles.Size()];
+        float * Posvec = new float[3*Particles.Size()];
+        float * Velvec = new float[3*Particles.Size()];
+        float * Forvec = new float[3*Particles.Size()];
+        int   * Tags   = new int  [  Particles.Size()];
+        for (size_t i=0;i<Particles.Size();i++)
+        {
+            Particles[i]->Verts.Size()==1 ? Radius[i] = float(Particles[i]->Dmax) : Radius[i] = 0.0;
+            for (size_t d=0;d<3;d++)
+            {
+                Posvec[3*i+d] = (float) Particles[i]->x(d);
+                Velvec[3*i+d] = (float) Particles[i]->v(d);
+                Forvec[3*i+d] = (float) Particles[i]->F(d);
+            }
+            Tags  [i]     = (int)   Particles[i]->Tag;
+        }
+        hsize_t dims[1];
+        dims[0] = 3*Particles.Size();
+        H5LTmake_dataset_float(file_id,"Position" ,1,dims,Posvec);
+        H5LTmake_dataset_float(file_id,"PVelocity",1,dims,Velvec);
+        H5LTmake_dataset_float(file_id,"PForce"   ,1,dims,Forvec);
+        dims[0] = Particles.Size();
+        H5LTmake_dataset_float(file_id,"Radius"   ,1,dims,Radius);
+        H5LTmake_dataset_int  (file_id,"PTag"     ,1,dims,Tags  );
+        delete [] Radius;
+        delete [] Posvec;
+        delete [] Velvec;
+        delete [] Forvec;
+        delete [] Tags  ;
+    }
+
+    //Closing the file
+    H5Fflush(file_id,H5F_SCOPE_GLOBAL);
+    H5Fclose(file_id);
+    if (L.Rank!=0) return;
+
+    // Writing xmf file, the CoRectMesh origins and dimensions go from the slowest to the fastest axis
+    bool   Is3D = L.Ndim(2)>1;
+    std::ostringstream oss;
+    oss << "<?xml version=\"1.0\" ?>\n";
+    oss << "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n";
+    oss << "<Xdmf Version=\"2.0\">\n";
+    oss << " <Domain>\n";
+    oss << "   <Grid Name=\"LBM_Mesh\" GridType=\"Collection\" CollectionType=\"Spatial\">\n";
+    for (size_t r=0;r<L.Nranks;r++)
+    {
+        size_t lo = r*L.Ndim(Ax)/L.Nranks;
+        size_t hi = (r+1)*L.Ndim(Ax)/L.Nranks;
+        iVec3_t N(L.Ndim(0)/St(0),L.Ndim(1)/St(1),L.Ndim(2)/St(2));
+        N(Ax) = (hi-lo)/St(Ax);
+        std::ostringstream dim;
+        if (Is3D) dim << N(2) << " " << N(1) << " " << N(0);
+        else      dim << N(1) << " " << N(0);
+        String rfn;
+        rfn.Printf("%s_r%04zd.h5",FileKey,r);
+    oss << "   <Grid Name=\"LBM_Slab_" << r << "\" GridType=\"Uniform\">\n";
+    oss << "     <Topology TopologyType=\"" << (Is3D ? "3D" : "2D") << "CoRectMesh\" Dimensions=\"" << dim.str() << "\"/>\n";
+    oss << "     <Geometry GeometryType=\"" << (Is3D ? "ORIGIN_DXDYDZ" : "ORIGIN_DXDY") << "\">\n";
+    oss << "       <DataItem Format=\"XML\" NumberType=\"Float\" Dimensions=\"" << (Is3D ? 3 : 2) << "\"> " << lo*L.dx << (Is3D ? " 0.0 0.0\n" : " 0.0\n");
+    oss << "       </DataItem>\n";
+    oss << "       <DataItem Format=\"XML\" NumberType=\"Float\" Dimensions=\"" << (Is3D ? 3 : 2) << "\"> ";
+        for (size_t d=0;d<(Is3D ? 3 : 2);d++) oss << Step*L.dx << " ";
+    oss << "\n";
+    oss << "       </DataItem>\n";
+    oss << "     </Geometry>\n";
+        for (size_t j=0;j<Lat.Size();j++)
+        {
+    oss << "     <Attribute Name=\"Density_" << j << "\" AttributeType=\"Scalar\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << dim.str() << "\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/Density_" << j << "\n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+        if (PrtVec)
+        {
+    oss << "     <Attribute Name=\"Velocity_" << j << "\" AttributeType=\"Vector\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << dim.str() << " 3\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/Velocity_" << j << "\n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+        }
+        }
+        if (PrtPer)
+        {
+    oss << "     <Attribute Name=\"Per\" AttributeType=\"Scalar\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << dim.str() << "\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/Per\n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+        }
+    oss << "     <Attribute Name=\"Gamma\" AttributeType=\"Scalar\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << dim.str() << "\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/Gamma\n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+    oss << "   </Grid>\n";
+    }
+    oss << "   </Grid>\n";
+    if (Particles.Size()>0)
+    {
+        String rfn;
+        rfn.Printf("%s_r%04zd.h5",FileKey,size_t(0));
+    oss << "   <Grid Name=\"DEM_Center\" GridType=\"Uniform\">\n";
+    oss << "     <Topology TopologyType=\"Polyvertex\" NumberOfElements=\"" << Particles.Size() << "\"/>\n";
+    oss << "     <Geometry GeometryType=\"XYZ\">\n";
+    oss << "       <DataItem Format=\"HDF\" NumberType=\"Float\" Precision=\"4\" Dimensions=\"" << Particles.Size() << " 3\" >\n";
+    oss << "        " << rfn.CStr() <<":/Position \n";
+    oss << "       </DataItem>\n";
+    oss << "     </Geometry>\n";
+    oss << "     <Attribute Name=\"Radius\" AttributeType=\"Scalar\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << Particles.Size() << "\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/Radius \n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+    oss << "     <Attribute Name=\"Tag\" AttributeType=\"Scalar\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << Particles.Size() << "\" NumberType=\"Int\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/PTag \n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+    oss << "     <Attribute Name=\"Velocity\" AttributeType=\"Vector\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << Particles.Size() << " 3\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/PVelocity\n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+    oss << "     <Attribute Name=\"Force\" AttributeType=\"Vector\" Center=\"Node\">\n";
+    oss << "       <DataItem Dimensions=\"" << Particles.Size() << " 3\" NumberType=\"Float\" Precision=\"4\" Format=\"HDF\">\n";
+    oss << "        " << rfn.CStr() <<":/PForce\n";
+    oss << "       </DataItem>\n";
+    oss << "     </Attribute>\n";
+    oss << "   </Grid>\n";
+    }
+    oss << " </Domain>\n";
+    oss << "</Xdmf>\n";
+    fn = FileKey;
+    fn.append(".xmf");
+    std::ofstream of(fn.CStr(), std::ios::out);
+    of << oss.str();
+    of.close();
+}
+#endif
+
 inline void Domain::WriteXDMF_D(char const * FileKey)
 {
+#ifdef USE_MPI
+    if (Lat[0].Nranks>1)
+    {
+        WriteXDMF_MPI(FileKey);
+        return;
+    }
+#endif
     String fn(FileKey);
     fn.append(".h5");
     hid_t     file_id;
@@ -1252,11 +1592,19 @@ inline void Domain::WriteXDMF_D(char const * FileKey)
             for (size_t li=0;li<Step;li++)
             for (size_t mi=0;mi<Step;mi++)
             {
-                rho  += Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Rho;
-                gamma+= std::max(Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Gamma,(double) Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->IsSolid);
-                per  += Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Pf;
-                vel  += Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->Vel;
-                vel  += dt*0.5*Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi))->BForce;
+                Cell * c = Lat[j].GetCell(iVec3_t(n+ni,l+li,m+mi));
+                if (c==NULL)
+                {
+                    // Solid interior of a sparse lattice
+                    gamma += 1.0;
+                    per   += 1.0;
+                    continue;
+                }
+                rho  += c->Rho;
+                gamma+= std::max(c->Gamma,(double) c->IsSolid);
+                per  += c->Pf;
+                vel  += c->Vel;
+                vel  += dt*0.5*c->BForce;
             }
             rho  /= Step*Step*Step;
             gamma/= Step*Step*Step;
@@ -1864,163 +2212,83 @@ inline void Domain::Load (char const * FileKey)
 
 #endif
 
-inline void Domain::ApplyForce(size_t n, size_t Np, bool MC)
+inline Vec3_t Domain::PairForce(size_t ind1, size_t ind2, size_t vec, size_t j, size_t k, bool MC)
 {
-    size_t Ni = CellPairs.Size()/Np;
-    size_t In = n*Ni;
-    size_t Fn;
-    n == Np-1 ? Fn = CellPairs.Size() : Fn = (n+1)*Ni;
+    Cell * c  = Lat[j].Cells[ind1];
+    Cell * nb = Lat[k].Cells[ind2];
+    double rho    = Lat[j].GetRho(ind1);
+    double nb_rho = Lat[k].GetRho(ind2);
+    bool   csolid = c ->IsSolid||fabs(Lat[j].GetGamma(ind1)-1.0)<1.0e-12;
+    bool  nbsolid = nb->IsSolid||fabs(Lat[k].GetGamma(ind2)-1.0)<1.0e-12;
+    double psi,nb_psi,G;
 
     if (MC)
     {
-#ifdef USE_OMP
-        In = 0;
-        Fn = CellPairs.Size();
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-#endif
-        for (size_t i=In;i<Fn;i++)
-        {
-            size_t ind1 = CellPairs[i](0);
-            size_t ind2 = CellPairs[i](1);
-            size_t vec  = CellPairs[i](2);
-            Cell * c = Lat[0].Cells[ind1];
-            Cell *nb = Lat[1].Cells[ind2];
-            double nb_psi,psi,G=Gmix/(dt*dt);
-            bool check = false;
-            if (c->IsSolid||fabs(c->Gamma-1.0)<1.0e-12)
-            //if (c->IsSolid||c->Gamma>1.0e-12)
-            {
-                psi    = 1.0;
-                G      = Lat[1].Gs*c->Gs;
-                check  = true;
-            }
-            else psi   = c ->Rho;
-            if (nb->IsSolid||fabs(nb->Gamma-1.0)<1.0e-12)
-            //if (nb->IsSolid||nb->Gamma>1.0e-12)
-            {
-                nb_psi = 1.0;
-                G      = Lat[0].Gs*nb->Gs;
-                // this is to ignore forces where both are solid nodes
-                if (check) G = 0.0;
-            }
-            else nb_psi = nb->Rho;
-            Vec3_t  BF = -G*psi*nb_psi*c->W[vec]*c->C[vec];
-
-#ifdef USE_OMP
-            omp_set_lock        (&c->lck);
-#endif
-            c ->BForce += BF;
-#ifdef USE_OMP
-            omp_unset_lock      (&c ->lck);
-            omp_set_lock        (&nb->lck);
-#endif
-            nb->BForce -= BF;
-#ifdef USE_OMP
-            omp_unset_lock      (&nb->lck);
-#endif
-
-            c  = Lat[1].Cells[ind1];
-            nb = Lat[0].Cells[ind2];
-            G  = Gmix/(dt*dt);
-            check = false;
-            if (c->IsSolid||fabs(c->Gamma-1.0)<1.0e-12)
-            //if (c->IsSolid||c->Gamma>1.0e-12)
-            {
-                psi    = 1.0;
-                G      = Lat[0].Gs;
-                check  = true;
-            }
-            else psi   = c ->Rho;
-            if (nb->IsSolid||fabs(nb->Gamma-1.0)<1.0e-12)
-            //if (nb->IsSolid||nb->Gamma>1.0e-12)
-            {
-                nb_psi = 1.0;
-                G      = Lat[1].Gs;
-                if (check) G = 0.0;
-            }
-            else nb_psi = nb->Rho;
-            BF = -G*psi*nb_psi*c->W[vec]*c->C[vec];
-
-#ifdef USE_OMP
-            omp_set_lock        (&c->lck);
-#endif
-            c ->BForce += BF;
-#ifdef USE_OMP
-            omp_unset_lock      (&c ->lck);
-            omp_set_lock        (&nb->lck);
-#endif
-            nb->BForce -= BF;
-#ifdef USE_OMP
-            omp_unset_lock      (&nb->lck);
-#endif
+        if (j==k) return OrthoSys::O;
+        G = Gmix/(dt*dt);
+        if (csolid)
+        {
+            psi    = 1.0;
+            j==0 ? G = Lat[1].Gs*c->Gs : G = Lat[0].Gs;
+        }
+        else psi   = rho;
+        if (nbsolid)
+        {
+            nb_psi = 1.0;
+            j==0 ? G = Lat[0].Gs*nb->Gs : G = Lat[1].Gs;
+            // this is to ignore forces where both are solid nodes
+            if (csolid) G = 0.0;
         }
+        else nb_psi = nb_rho;
+        return -G*psi*nb_psi*Lat[0].W[vec]*Lat[0].C[vec];
     }
-    else
+
+    bool solid = csolid;
+    if (solid) psi = 1.0;
+    else fabs(Lat[j].G)>1.0e-12 ? psi = Lat[j].Psi(rho) : psi = rho;
+    // a solid neighbour in any of the lattices up to k also counts as a solid pair
+    for (size_t m=0;m<=k;m++)
     {
+        if (Lat[m].Cells[ind2]->IsSolid||fabs(Lat[m].GetGamma(ind2)-1.0)<1.0e-12) solid = true;
+    }
+    if (nbsolid) nb_psi = 1.0;
+    else fabs(Lat[j].G)>1.0e-12 ? nb_psi = Lat[k].Psi(nb_rho) : nb_psi = nb_rho;
+    solid ? G = Lat[j].Gs*2.0*ReducedValue(nb->Gs,c->Gs) : G = Lat[j].G; 
+    if (j==k)      return -G*psi*nb_psi*Lat[0].W[vec]*Lat[0].C[vec];
+    else if(!solid) return -Gmix*rho*nb_rho*Lat[0].W[vec]*Lat[0].C[vec];
+    return OrthoSys::O;
+}
+
+inline void Domain::ApplyForce(size_t n, size_t Np, bool MC)
+{
+    // Every cell gathers the forces of all the links it belongs to so each thread only writes the
+    // cells it owns and no locks are needed. The force of a link is evaluated by both of its cells,
+    // always with the lower ID as the first cell of the pair. Links between two solid cells are
+    // ignored, so a sparse lattice only needs its packed nodes visited.
+    Lattice & L = Lat[0];
+    size_t Nc = L.SoA ? L.Npack : L.Ncells;
+    size_t Ni = Nc/Np;
+    size_t In = n*Ni;
+    size_t Fn;
+    n == Np-1 ? Fn = Nc : Fn = (n+1)*Ni;
 #ifdef USE_OMP
-        In = 0;
-        Fn = CellPairs.Size();
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
+    In = 0;
+    Fn = Nc;
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
 #endif
-        for (size_t i=In;i<Fn;i++)
+    for (size_t p=In;p<Fn;p++)
+    {
+        size_t i = L.CellOf(p);
+        bool solid = L.Cells[i]->IsSolid;
+        for (size_t d=1;d<L.Nneigh;d++)
         {
-            size_t ind1 = CellPairs[i](0);
-            size_t ind2 = CellPairs[i](1);
-            size_t vec  = CellPairs[i](2);
+            size_t nb = L.Neigh(i,d);
+            if (nb==i||(solid&&(!L.Stored(nb)||L.Cells[nb]->IsSolid))) continue;
             for (size_t j=0;j<Lat.Size();j++)
+            for (size_t k=0;k<Lat.Size();k++)
             {
-                bool solid = false;
-                Cell * c = Lat[j].Cells[ind1];
-                double psi;
-                if (c->IsSolid||fabs(c->Gamma-1.0)<1.0e-12)
-                //if (c->IsSolid||c->Gamma>0.0)
-                {
-                    psi   = 1.0;
-                    solid = true;
-                }
-                else fabs(Lat[j].G)>1.0e-12 ? psi = Lat[j].Psi(c->Rho) : psi = c->Rho;
-                for (size_t k=0;k<Lat.Size();k++)
-                {
-                    Cell * nb = Lat[k].Cells[ind2];
-                    double nb_psi;
-                    if (nb->IsSolid||fabs(nb->Gamma-1.0)<1.0e-12)
-                    //if (nb->IsSolid||nb->Gamma>0.0)
-                    {
-                        nb_psi = 1.0;
-                        solid  = true;
-                    }
-                    else fabs(Lat[j].G)>1.0e-12 ? nb_psi = Lat[k].Psi(nb->Rho) : nb_psi = nb->Rho;
-                    double G;
-                    solid ? G = Lat[j].Gs*2.0*ReducedValue(nb->Gs,c->Gs) : G = Lat[j].G; 
-                    Vec3_t BF(OrthoSys::O);
-                    if (j==k)
-                    {
-                        BF += -G*psi*nb_psi*c->W[vec]*c->C[vec];
-                    }
-                    else if(!solid)
-                    {
-                        BF += -Gmix*c->Rho*nb->Rho*c->W[vec]*c->C[vec];
-                    }
-#ifdef USE_THREAD
-                    pthread_mutex_lock  (&c ->lck);
-#elif USE_OMP
-                    omp_set_lock        (&c ->lck);
-#endif
-                    c ->BForce += BF;
-#ifdef USE_THREAD
-                    pthread_mutex_unlock(&c ->lck);
-                    pthread_mutex_lock  (&nb->lck);
-#elif USE_OMP
-                    omp_unset_lock      (&c ->lck);
-                    omp_set_lock        (&nb->lck);
-#endif
-                    nb->BForce -= BF;
-#ifdef USE_THREAD
-                    pthread_mutex_unlock(&nb->lck);
-#elif USE_OMP
-                    omp_unset_lock      (&nb->lck);
-#endif
-                }
+                if (nb>i) Lat[j].GetBForce(i) += PairForce(i,nb,d,j,k,MC);
+                else      Lat[k].GetBForce(i) -= PairForce(nb,i,L.Op[d],j,k,MC);
             }
         }
     }
@@ -2449,41 +2717,265 @@ void Domain::CollideNoPar (size_t n, size_t Np)
     }   
 }
 
-void Domain::ImprintLatticeSC (size_t n,size_t Np)
+void Domain::CollideSoA (size_t n, size_t Np)
 {
-    
-	size_t Ni = ParCellPairs.Size()/Np;
+    switch (Lat[0].Nneigh)
+    {
+        case  5: CollideVS<VelSet<D2Q5 > >(n,Np); break;
+        case  9: CollideVS<VelSet<D2Q9 > >(n,Np); break;
+        case 15: CollideVS<VelSet<D3Q15> >(n,Np); break;
+        case 19: CollideVS<VelSet<D3Q19> >(n,Np); break;
+        default: throw new Fatal("Domain::CollideSoA: No velocity set with %zd directions",Lat[0].Nneigh);
+    }
+}
+
+template<class VS>
+inline void Domain::CollideVS (size_t n, size_t Np)
+{
+    // The velocity set is a template parameter so the direction loops have a fixed length and the
+    // weights and velocities are constants. Cells are processed in blocks of Nb with the direction
+    // loops outside and the cell loops inside, the latter being branch free (the positivity limiter
+    // and the bounce back of solid cells are selects) so each SIMD lane handles one cell.
+    const size_t Q  = VS::Q;
+    const size_t Nb = 32;
+    Lattice & L  = Lat[0];
+    size_t    Ns = L.Nstride;
+    double    T0 = L.Tau;
+    double  Smag = Sc;
+    double    Dt = dt;
+    double   iCs = 1.0/L.Cs;
+    double  iCs2 = 1.0/(L.Cs*L.Cs);
+    double       * F       = L.F;
+    double const * Omeis   = L.Omeis;
+    double const * Rho     = L.Rho;
+    double const * Gamma   = L.Gamma;
+    double const * Pf      = L.Pf;
+    bool   const * IsSolid = L.IsSolid;
+    Vec3_t const * Vel     = L.Vel;
+    Vec3_t const * BForce  = L.BForce;
+    size_t Nnan = 0;
+    size_t Nblk = (L.Npack+Nb-1)/Nb;
+	size_t Ni = Nblk/Np;
     size_t In = n*Ni;
     size_t Fn;
-    n == Np-1 ? Fn = ParCellPairs.Size() : Fn = (n+1)*Ni;
-    //std::cout << "Im proccess = " << n << std::endl;
-    // 2D imprint
-    if (Lat[0].Ndim(2)==1)
+    n == Np-1 ? Fn = Nblk : Fn = (n+1)*Ni;
+#ifdef USE_OMP
+    In = 0;
+    Fn = Nblk;
+    #pragma omp parallel for schedule(static) num_threads(Nproc) reduction(+:Nnan)
+#endif
+    for (size_t ib=In;ib<Fn;ib++)
     {
-    #ifdef USE_OMP
-        In = 0;
-        Fn = ParCellPairs.Size();
-        #pragma omp parallel for schedule(static) num_threads(Nproc)
-    #endif
-        for (size_t i = In;i<Fn;i++)
+        size_t i0 = ib*Nb;
+        size_t Nl = std::min(Nb,L.Npack-i0);
+        double Fl[Q][Nb],NonEq[Q][Nb],Ome[Q][Nb];
+        double rho[Nb],irh[Nb],dvx[Nb],dvy[Nb],dvz[Nb],Qs[Nb],iTau[Nb],Bn[Nb],alpha[Nb];
+        for (size_t k=0;k<Q;k++)
         {
-            LBM::Disk      * Pa   = Disks[ParCellPairs[i].IPar];
-            Cell           * cell = Lat[0].Cells[ParCellPairs[i].ICell];
-            double x              = Lat[0].dx*(cell->Index(0));
-            double y              = Lat[0].dx*(cell->Index(1));
-            double z              = Lat[0].dx*(cell->Index(2));
-            Vec3_t  C(x,y,z);
-            double len = DEM::DiskSquare(Pa->X,C,Pa->R,Lat[0].dx);
-            if (fabs(len)<1.0e-12) continue;
-            double Tau = Lat[0].Tau;
-            cell = Lat[0].Cells[ParCellPairs[i].ICell];
-            double gamma  = len/(4.0*Lat[0].dx);
-            cell->Gamma   = std::min(gamma+cell->Gamma,1.0);
-            Vec3_t B      = C - Pa->X;
-            Vec3_t tmp;
-            Rotation(Pa->W,Pa->Q,tmp);
-            Vec3_t VelP   = Pa->V + cross(tmp,B);
-            double rho = cell->Rho;
+            #pragma omp simd
+            for (size_t l=0;l<Nl;l++) Fl[k][l] = F[k*Ns+i0+l];
+        }
+
+        //Calculate Smagorinsky LES model (solid cells produce garbage here that is discarded below)
+        #pragma omp simd
+        for (size_t l=0;l<Nl;l++)
+        {
+            size_t i = i0+l;
+            rho[l] = Rho[i];
+            irh[l] = 1.0/rho[l];
+            dvx[l] = Vel[i](0) + BForce[i](0)*Dt*irh[l];
+            dvy[l] = Vel[i](1) + BForce[i](1)*Dt*irh[l];
+            dvz[l] = Vel[i](2) + BForce[i](2)*Dt*irh[l];
+            Qs [l] = 0.0;
+        }
+        for (size_t k=0;k<Q;k++)
+        {
+            const double Cn = (abs(VS::CX[k]) + abs(VS::CY[k]) + abs(VS::CZ[k]))*(abs(VS::CX[k]) + abs(VS::CY[k]) + abs(VS::CZ[k]));
+            #pragma omp simd
+            for (size_t l=0;l<Nl;l++)
+            {
+                double VdotV = dvx[l]*dvx[l] + dvy[l]*dvy[l] + dvz[l]*dvz[l];
+                double VdotC = dvx[l]*VS::CX[k] + dvy[l]*VS::CY[k] + dvz[l]*VS::CZ[k];
+                double FDeqn = VS::W[k]*rho[l]*(1.0 + 3.0*VdotC*iCs + 4.5*VdotC*VdotC*iCs2 - 1.5*VdotV*iCs2);
+                NonEq[k][l] = Fl[k][l] - FDeqn;
+                Qs[l] += NonEq[k][l]*NonEq[k][l]*Cn;
+            }
+        }
+        #pragma omp simd
+        for (size_t l=0;l<Nl;l++)
+        {
+            double Tau = 0.5*(T0 + sqrt(T0*T0 + 6.0*sqrt(2.0*Qs[l])*Smag*irh[l]));
+            iTau [l] = 1.0/Tau;
+            Bn   [l] = (Gamma[i0+l]*(T0-0.5))/((1.0-Gamma[i0+l])+(T0-0.5));
+            alpha[l] = 1.0;
+        }
+
+        // Limit the relaxation so no population becomes negative, same as the alpha loop of CollideSC
+        for (size_t k=0;k<Q;k++)
+        {
+            #pragma omp simd
+            for (size_t l=0;l<Nl;l++)
+            {
+                Ome[k][l] = (1.0 - Bn[l])*(NonEq[k][l]*iTau[l] - (1.0 - Pf[i0+l])*(Fl[VS::OP[k]][l] - Fl[k][l] + NonEq[k][l]*iTau[l])) - Bn[l]*Omeis[k*Ns+i0+l];
+                double temp = fabs(Fl[k][l]/Ome[k][l]);
+                alpha[l] = (Fl[k][l] - Ome[k][l]<-1.0e-12 && temp<alpha[l]) ? temp : alpha[l];
+            }
+        }
+        for (size_t k=0;k<Q;k++)
+        {
+            #pragma omp simd reduction(+:Nnan)
+            for (size_t l=0;l<Nl;l++)
+            {
+                double Ft  = Fl[k][l] - alpha[l]*Ome[k][l];
+                bool   nan = Ft!=Ft;
+                bool solid = IsSolid[i0+l];
+                Nnan += (nan && !solid) ? 1 : 0;
+                Ft = nan ? Fl[k][l] : Ft;
+                F[k*Ns+i0+l] = solid ? Fl[VS::OP[k]][l] : fabs(Ft);
+            }
+        }
+    }
+    if (Nnan>0) std::cout << "CollideSoA: " << Nnan << " Nan populations found, resetting" << std::endl;
+}
+
+void Domain::CollideAA (size_t n, size_t Np)
+{
+    // Even steps read and write the slots of the cell itself (swapping directions), odd steps
+    // read from and write to the neighbours, so every cell only touches memory no other cell does
+    Lattice & L  = Lat[0];
+    size_t    Ns = L.Nstride;
+    size_t    Nn = L.Nneigh;
+    double    Cs = L.Cs;
+    bool     Odd = L.Odd;
+	size_t Ni = L.Npack/Np;
+    size_t In = n*Ni;
+    size_t Fn;
+    n == Np-1 ? Fn = L.Npack : Fn = (n+1)*Ni;
+#ifdef USE_OMP
+    In = 0;
+    Fn = L.Npack;
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+#endif
+    for (size_t i=In;i<Fn;i++)
+    {
+        // Bounce back is implicit: solid cells keep their populations where the neighbours expect them
+        if (L.IsSolid[i]) continue;
+        size_t Neighs[27];
+        if (Odd&&L.Sparse)
+        {
+            for (size_t k=0;k<Nn;k++) Neighs[k] = L.Nbr[L.Op[k]*Ns+i];
+        }
+        else if (Odd)
+        {
+            size_t x = i%L.Ndim(0);
+            if (x==0||x+1==L.Ndim(0)||L.EdgeRow(i/L.Ndim(0))) for (size_t k=0;k<Nn;k++) Neighs[k] = L.Neigh(i,k);
+            else                                               for (size_t k=0;k<Nn;k++) Neighs[k] = i + L.Offset[k];
+        }
+        double Fl[27],NonEq[27],Ft[27];
+        double rho = 0.0;
+        Vec3_t vel = OrthoSys::O;
+        for (size_t k=0;k<Nn;k++)
+        {
+            double & f = Odd ? L.F[L.Op[k]*Ns+Neighs[L.Op[k]]] : L.F[k*Ns+i];
+            if (std::isnan(f)) f = 1.0e-12;
+            Fl[k] = f;
+            vel  += f*L.C[k];
+            rho  += f;
+        }
+        if (std::isnan(rho)) throw new Fatal("NaN found in cell %zd",L.CellOf(i));
+        vel *= Cs/rho;
+
+        //Calculate Smagorinsky LES model
+        double Tau = L.Tau;
+        Vec3_t DV  = vel + L.BForce[i]*dt/rho;
+        double VdotV = dot(DV,DV);
+        double Q = 0.0;
+        for (size_t k=0;k<Nn;k++)
+        {
+            double VdotC = dot(DV,L.C[k]);
+            double FDeqn = L.W[k]*rho*(1.0 + 3.0*VdotC/Cs + 4.5*VdotC*VdotC/(Cs*Cs) - 1.5*VdotV/(Cs*Cs));
+            NonEq[k] = Fl[k] - FDeqn;
+            Q += NonEq[k]*NonEq[k]*EEk[k];
+        }
+        Q = sqrt(2.0*Q);
+        Tau = 0.5*(Tau + sqrt(Tau*Tau + 6.0*Q*Sc/rho));
+
+        double Gamma = L.Gamma[i];
+        double Pf    = L.Pf[i];
+        double Bn    = (Gamma*(L.Tau-0.5))/((1.0-Gamma)+(L.Tau-0.5));
+        bool valid  = true;
+        double alphal = 1.0;
+        double alphat = 1.0;
+        size_t num = 0;
+        while (valid)
+        {
+            num++;
+            valid = false;
+            alphal  = alphat;
+            for (size_t k=0;k<Nn;k++)
+            {
+                double Ome = (1.0 - Bn)*(NonEq[k]/Tau - (1.0 - Pf)*(Fl[L.Op[k]] - Fl[k] + NonEq[k]/Tau)) - Bn*L.Omeis[k*Ns+i];
+                Ft[k] = Fl[k] - alphal*Ome;
+                if (Ft[k]<-1.0e-12&&num<2)
+                {
+                    double temp = fabs(Fl[k]/Ome);
+                    if (temp<alphat) alphat = temp;
+                    valid = true;
+                }
+            }
+        }
+        for (size_t k=0;k<Nn;k++)
+        {
+            if (std::isnan(Ft[k]))
+            {
+                std::cout << "CollideAA: Nan found, resetting" << std::endl;
+                std::cout << rho << " " << L.BForce[i] << " " << num << " " << alphat << " " << L.Cells[L.CellOf(i)]->Index << " " << Gamma << " " << k << " " << std::endl;
+                Ft[k] = Fl[k];
+            }
+            if (Odd) L.F[k*Ns+Neighs[k]]  = fabs(Ft[k]);
+            else     L.F[L.Op[k]*Ns+i]    = fabs(Ft[k]);
+        }
+    }
+    L.Odd = !Odd;
+}
+
+void Domain::ImprintLatticeSC (size_t n,size_t Np)
+{
+    
+	size_t Ni = ParCellPairs.Size()/Np;
+    size_t In = n*Ni;
+    size_t Fn;
+    n == Np-1 ? Fn = ParCellPairs.Size() : Fn = (n+1)*Ni;
+    //std::cout << "Im proccess = " << n << std::endl;
+    // 2D imprint
+    if (Lat[0].Ndim(2)==1)
+    {
+    #ifdef USE_OMP
+        In = 0;
+        Fn = ParCellPairs.Size();
+        #pragma omp parallel for schedule(static) num_threads(Nproc)
+    #endif
+        for (size_t i = In;i<Fn;i++)
+        {
+            LBM::Disk      * Pa   = Disks[ParCellPairs[i].IPar];
+            Cell           * cell = Lat[0].Cells[ParCellPairs[i].ICell];
+            double x              = Lat[0].dx*(cell->Index(0));
+            double y              = Lat[0].dx*(cell->Index(1));
+            double z              = Lat[0].dx*(cell->Index(2));
+            Vec3_t  C(x,y,z);
+            double len = FastOverlap ? OvTable.Len(norm(C-Pa->X),Pa->R,Lat[0].dx) : DEM::DiskSquare(Pa->X,C,Pa->R,Lat[0].dx);
+            if (fabs(len)<1.0e-12) continue;
+            double Tau = Lat[0].Tau;
+            cell = Lat[0].Cells[ParCellPairs[i].ICell];
+            size_t ic     = ParCellPairs[i].ICell;
+            if (!Lat[0].Stored(ic)) continue;
+            double gamma  = len/(4.0*Lat[0].dx);
+            Lat[0].GetGamma(ic) = std::min(gamma+Lat[0].GetGamma(ic),1.0);
+            Vec3_t B      = C - Pa->X;
+            Vec3_t tmp;
+            Rotation(Pa->W,Pa->Q,tmp);
+            Vec3_t VelP   = Pa->V + cross(tmp,B);
+            double rho = Lat[0].Density(ic);
             double Bn  = (gamma*(Tau-0.5))/((1.0-gamma)+(Tau-0.5));
             //double Bn  = gamma;
             //double Bn  = floor(gamma);
@@ -2493,9 +2985,9 @@ void Domain::ImprintLatticeSC (size_t n,size_t Np)
             {
                 double Fvpp    = cell->Feq(cell->Op[k],VelP,rho);
                 double Fvp     = cell->Feq(k          ,VelP,rho);
-                double Omega   = cell->F[cell->Op[k]] - Fvpp - (cell->F[k] - Fvp);
+                double Omega   = Lat[0].GetF(ic,cell->Op[k]) - Fvpp - (Lat[0].GetF(ic,k) - Fvp);
 
-                cell->Omeis[k] += gamma*Omega;
+                Lat[0].GetOmeis(ic,k) += gamma*Omega;
                 Flbm += -Fconv*Bn*Omega*cell->Cs*cell->Cs*Lat[0].dx*Lat[0].dx*cell->C[k];
             }
             Vec3_t T,Tt;
@@ -2516,130 +3008,341 @@ void Domain::ImprintLatticeSC (size_t n,size_t Np)
         }
     }
 
-    //3D imprint
+    //3D imprint, particle by particle over the stencils gathered by BuildStencils
     else
     {
+        double dx   = Lat[0].dx;
+        double Tau  = Lat[0].Tau;
+        double Cs   = Lat[0].Cs;
+        size_t Nn   = Lat[0].Nneigh;
+        double Fcte = -Fconv*Cs*Cs*dx*dx;
+        size_t Npar = StencilStart.Size()>0 ? StencilStart.Size()-1 : 0;
+        Ni = Npar/Np;
+        In = n*Ni;
+        n == Np-1 ? Fn = Npar : Fn = (n+1)*Ni;
     #ifdef USE_OMP
         In = 0;
-        Fn = ParCellPairs.Size();
+        Fn = Npar;
         #pragma omp parallel for schedule(static) num_threads(Nproc)
     #endif
-        for (size_t i = In;i<Fn;i++)
+        for (size_t ip=In;ip<Fn;ip++)
         {
-            DEM::Particle  * Pa   = Particles[ParCellPairs[i].IPar];
-            Cell           * cell = Lat[0].Cells[ParCellPairs[i].ICell];
-            double x              = Lat[0].dx*(cell->Index(0));
-            double y              = Lat[0].dx*(cell->Index(1));
-            double z              = Lat[0].dx*(cell->Index(2));
-            Vec3_t  C(x,y,z);
-            Vec3_t  Xtemp,Xs,Xstemp;
-            double len,minl = Pa->Dmax;
-    
-            //std::cout << "1" << std::endl;
-            //if (Pa->IsInsideFaceOnly(C)) len = 12.0*Lat[0].dx;
-            //else if (ParCellPairs[i].IGeo.Size()==0) continue;
-            if (norm(C-Pa->x)>Pa->Dmax) continue;
-            len = 12.0*Lat[0].dx;
-            Vec3_t Nor = OrthoSys::O;
-            //else
-            if (ParCellPairs[i].IGeo.Size()>0) 
+            if (StencilStart[ip]==StencilStart[ip+1]) continue;
+            DEM::Particle * Pa = Particles[ip];
+
+            // The overlap lengths are kept while the surface of the particle moved less than ImprintTol*dx
+            bool reuse = StencilReuse(ip);
+            if (!reuse)
             {
-                if (Pa->Faces.Size()>0)
+                StencilX    [ip] = Pa->x;
+                StencilQ    [ip] = Pa->Q;
+                StencilValid[ip] = 1;
+            }
+
+            Vec3_t wr;
+            Rotation(Pa->w,Pa->Q,wr);
+            Vec3_t Flbm = OrthoSys::O;
+            Vec3_t Tt   = OrthoSys::O;
+            for (size_t e=StencilStart[ip];e<StencilStart[ip+1];e++)
+            {
+                size_t ic   = StencilCell[e];
+                Cell * cell = Lat[0].Cells[ic];
+                Vec3_t C(dx*cell->Index(0),dx*cell->Index(1),dx*cell->Index(2));
+                if (!reuse)
                 {
-                    DEM::Distance(C,*Pa->Faces[ParCellPairs[i].IGeo[0]],Xtemp,Xs);
-                    minl = norm(Xtemp-Xs);
-                    Nor = Pa->Faces[ParCellPairs[i].IGeo[0]]->Nor;
-                    for (size_t j=1;j<ParCellPairs[i].IGeo.Size();j++)
-                    {
-                        DEM::Distance(C,*Pa->Faces[ParCellPairs[i].IGeo[j]],Xtemp,Xstemp);
-                        if (norm(Xtemp-Xstemp) < minl)
-                        {
-                            minl = norm(Xtemp-Xstemp);
-                            Xs   = Xstemp;
-                            Nor = Pa->Faces[ParCellPairs[i].IGeo[j]]->Nor;
-                        }
-                    }
+                    size_t ng = StencilGeoStart[e+1] - StencilGeoStart[e];
+                    StencilLen[e] = OverlapLength(Pa,C,ng>0 ? &StencilGeo[StencilGeoStart[e]] : NULL,ng);
                 }
-                else if (Pa->Edges.Size()>0)
+                double len = StencilLen[e];
+                if (fabs(len)<1.0e-12) continue;
+
+                double gamma  = len/(12.0*dx);
+                Lat[0].GetGamma(ic) = gamma;
+                Vec3_t B      = C - Pa->x;
+                Vec3_t VelP   = Pa->v + cross(wr,B);
+                double rho    = Lat[0].Density(ic);
+                double Bn     = (gamma*(Tau-0.5))/((1.0-gamma)+(Tau-0.5));
+
+                // Feq(Op[k]) - Feq(k) reduces to -6 W[k] rho (VelP.C[k])/Cs since W and C are symmetric
+                Vec3_t Sum = OrthoSys::O;
+                if (!Lat[0].SoA)
                 {
-                    DEM::Distance(C,*Pa->Edges[ParCellPairs[i].IGeo[0]],Xtemp,Xs);
-                    minl = norm(Xtemp-Xs);
-                    for (size_t j=1;j<ParCellPairs[i].IGeo.Size();j++)
+                    for (size_t k=0;k<Nn;k++)
                     {
-                        DEM::Distance(C,*Pa->Edges[ParCellPairs[i].IGeo[j]],Xtemp,Xstemp);
-                        if (norm(Xtemp-Xstemp) < minl)
-                        {
-                            minl = norm(Xtemp-Xstemp);
-                            Xs   = Xstemp;
-                        }
+                        double Omega = cell->F[Lat[0].Op[k]] - cell->F[k] + 6.0*Lat[0].W[k]*rho*dot(VelP,Lat[0].C[k])/Cs;
+                        cell->Omeis[k] = Omega;
+                        Sum += Omega*Lat[0].C[k];
                     }
                 }
-                else if (Pa->Verts.Size()>0)
+                else
                 {
-                    DEM::Distance(C,*Pa->Verts[ParCellPairs[i].IGeo[0]],Xtemp,Xs);
-                    minl = norm(Xtemp-Xs);
-                    for (size_t j=1;j<ParCellPairs[i].IGeo.Size();j++)
+                    for (size_t k=0;k<Nn;k++)
                     {
-                        DEM::Distance(C,*Pa->Verts[ParCellPairs[i].IGeo[j]],Xtemp,Xstemp);
-                        if (norm(Xtemp-Xstemp) < minl)
-                        {
-                            minl = norm(Xtemp-Xstemp);
-                            Xs   = Xstemp;
-                        }
+                        double Omega = Lat[0].GetF(ic,Lat[0].Op[k]) - Lat[0].GetF(ic,k) + 6.0*Lat[0].W[k]*rho*dot(VelP,Lat[0].C[k])/Cs;
+                        Lat[0].GetOmeis(ic,k) = Omega;
+                        Sum += Omega*Lat[0].C[k];
                     }
                 }
-                double dotpro = dot(C-Xs,Nor);
-                if (dotpro>0.0||fabs(dotpro)<0.95*minl||Pa->Faces.Size()<4) 
-                {
-                    len = DEM::SphereCube(Xs,C,Pa->Props.R,Lat[0].dx);
-                }
+                Vec3_t Fc = Fcte*Bn*Sum;
+                Flbm += Fc;
+                Tt   += cross(B,Fc);
             }
-            //std::cout << "2" << std::endl;
-            if (fabs(len)<1.0e-12) continue;
-    
-            double Tau = Lat[0].Tau;
-            cell = Lat[0].Cells[ParCellPairs[i].ICell];
-            double gamma  = len/(12.0*Lat[0].dx);
-            cell->Gamma = gamma;
-            //cell->Gamma   = std::max(gamma,cell->Gamma);
-            //cell->Gamma   = std::min(gamma+cell->Gamma,1.0);
-            //if (fabs(cell->Gamma-1.0)<1.0e-12)
-            //if (fabs(cell->Gamma-1.0)<1.0e-12&&(fabs(Lat[0].G)>1.0e-12||Gmix>1.0e-12)) 
-            Vec3_t B      = C - Pa->x;
-            Vec3_t tmp;
-            Rotation(Pa->w,Pa->Q,tmp);
-            Vec3_t VelP   = Pa->v + cross(tmp,B);
-            double rho = cell->Rho;
-            double Bn  = (gamma*(Tau-0.5))/((1.0-gamma)+(Tau-0.5));
-            //double Bn  = gamma;
-            //double Bn  = floor(gamma);
-            size_t ncells = cell->Nneigh;
-            Vec3_t Flbm = OrthoSys::O;
-            for (size_t k=0;k<ncells;k++)
-            {
-                double Fvpp     = cell->Feq(cell->Op[k],VelP,rho);
-                double Fvp      = cell->Feq(k          ,VelP,rho);
-                double Omega    = cell->F[cell->Op[k]] - Fvpp - (cell->F[k] - Fvp);
-                //cell->Omeis[k] += Omega;
-                //cell->Omeis[k] += gamma*Omega;
-                cell->Omeis[k] = Omega;
-                Flbm += -Fconv*Bn*Omega*cell->Cs*cell->Cs*Lat[0].dx*Lat[0].dx*cell->C[k];
-            }
-            Vec3_t T,Tt;
-            Tt =           cross(B,Flbm);
+
+            // Only this thread touches the particle during the imprint
+            Vec3_t T;
             Quaternion_t q;
             Conjugate    (Pa->Q,q);
             Rotation     (Tt,q,T);
-            //std::cout << "1" << std::endl;
-    #ifdef USE_OMP
-            omp_set_lock      (&Pa->lck);
-    #endif
             Pa->F          += Flbm;
             Pa->T          += T;
-    #ifdef USE_OMP
-            omp_unset_lock    (&Pa->lck);
-    #endif
-            //std::cout << "3" << std::endl;
+        }
+    }
+}
+
+inline double Domain::OverlapLength (DEM::Particle * Pa, Vec3_t const & C, size_t const * IGeo, size_t Ngeo)
+{
+    if (norm(C-Pa->x)>Pa->Dmax) return 0.0;
+    if (Ngeo==0) return 12.0*Lat[0].dx;
+
+    // Closest feature among the ones next to the cell
+    Vec3_t Xtemp,Xs,Xstemp;
+    Vec3_t Nor  = OrthoSys::O;
+    double minl = Pa->Dmax;
+    if (Pa->Faces.Size()>0)
+    {
+        DEM::Distance(C,*Pa->Faces[IGeo[0]],Xtemp,Xs);
+        minl = norm(Xtemp-Xs);
+        Nor  = Pa->Faces[IGeo[0]]->Nor;
+        for (size_t j=1;j<Ngeo;j++)
+        {
+            DEM::Distance(C,*Pa->Faces[IGeo[j]],Xtemp,Xstemp);
+            if (norm(Xtemp-Xstemp) < minl)
+            {
+                minl = norm(Xtemp-Xstemp);
+                Xs   = Xstemp;
+                Nor  = Pa->Faces[IGeo[j]]->Nor;
+            }
+        }
+    }
+    else if (Pa->Edges.Size()>0)
+    {
+        DEM::Distance(C,*Pa->Edges[IGeo[0]],Xtemp,Xs);
+        minl = norm(Xtemp-Xs);
+        for (size_t j=1;j<Ngeo;j++)
+        {
+            DEM::Distance(C,*Pa->Edges[IGeo[j]],Xtemp,Xstemp);
+            if (norm(Xtemp-Xstemp) < minl)
+            {
+                minl = norm(Xtemp-Xstemp);
+                Xs   = Xstemp;
+            }
+        }
+    }
+    else if (Pa->Verts.Size()>0)
+    {
+        DEM::Distance(C,*Pa->Verts[IGeo[0]],Xtemp,Xs);
+        minl = norm(Xtemp-Xs);
+        for (size_t j=1;j<Ngeo;j++)
+        {
+            DEM::Distance(C,*Pa->Verts[IGeo[j]],Xtemp,Xstemp);
+            if (norm(Xtemp-Xstemp) < minl)
+            {
+                minl = norm(Xtemp-Xstemp);
+                Xs   = Xstemp;
+            }
+        }
+    }
+    double dotpro = dot(C-Xs,Nor);
+    if (dotpro>0.0||fabs(dotpro)<0.95*minl||Pa->Faces.Size()<4)
+    {
+        // Cells whose corners are all inside, or all far outside, the sphere around Xs give the same result as SphereCube
+        double d = norm(C-Xs);
+        double h = (0.5*sqrt(3.0)+1.0e-9)*Lat[0].dx;
+        if (d+h<Pa->Props.R)             return 12.0*Lat[0].dx;
+        if (d-h>Pa->Props.R+Lat[0].dx)   return 0.0;
+        // The table gives the mean over the directions from Xs, the particle sums are right but not each cell
+        if (FastOverlap)                 return OvTable.Len(d,Pa->Props.R,Lat[0].dx);
+        Vec3_t Xc(C);
+        return DEM::SphereCube(Xs,Xc,Pa->Props.R,Lat[0].dx);
+    }
+    return 12.0*Lat[0].dx;
+}
+
+inline void Domain::BuildStencils ()
+{
+    // Stable counting sort of the pairs by particle, keeping only the cells with storage
+    size_t Np = Particles.Size();
+    StencilStart.Resize(Np+1);
+    for (size_t i=0;i<=Np;i++) StencilStart[i] = 0;
+    for (size_t i=0;i<ParCellPairs.Size();i++)
+    {
+        if (Lat[0].Stored(ParCellPairs[i].ICell)) StencilStart[ParCellPairs[i].IPar+1]++;
+    }
+    for (size_t i=0;i<Np;i++) StencilStart[i+1] += StencilStart[i];
+
+    size_t Ne = StencilStart[Np];
+    Array<size_t> Pos(Np);
+    Array<size_t> Src(Ne);
+    for (size_t i=0;i<Np;i++) Pos[i] = StencilStart[i];
+    for (size_t i=0;i<ParCellPairs.Size();i++)
+    {
+        if (Lat[0].Stored(ParCellPairs[i].ICell)) Src[Pos[ParCellPairs[i].IPar]++] = i;
+    }
+
+    StencilCell    .Resize(Ne);
+    StencilLen     .Resize(Ne);
+    StencilGeoStart.Resize(Ne+1);
+    StencilGeoStart[0] = 0;
+    for (size_t e=0;e<Ne;e++)
+    {
+        StencilCell[e]       = ParCellPairs[Src[e]].ICell;
+        StencilLen [e]       = 0.0;
+        StencilGeoStart[e+1] = StencilGeoStart[e] + ParCellPairs[Src[e]].IGeo.Size();
+    }
+    StencilGeo.Resize(StencilGeoStart[Ne]);
+    for (size_t e=0;e<Ne;e++)
+    {
+        Array<size_t> const & IGeo = ParCellPairs[Src[e]].IGeo;
+        for (size_t j=0;j<IGeo.Size();j++) StencilGeo[StencilGeoStart[e]+j] = IGeo[j];
+    }
+
+    // The lengths have to be evaluated again before they can be reused
+    StencilValid.Resize(Np);
+    StencilX    .Resize(Np);
+    StencilQ    .Resize(Np);
+    for (size_t i=0;i<Np;i++) StencilValid[i] = 0;
+    FullClear = true;
+}
+
+inline bool Domain::StencilReuse (size_t ip)
+{
+    if (!StencilValid[ip]||ImprintTol<=0.0) return false;
+    DEM::Particle * Pa = Particles[ip];
+    double mov = norm(Pa->x-StencilX[ip]);
+    if (Pa->Verts.Size()>1)
+    {
+        Quaternion_t q,dq;
+        Conjugate         (StencilQ[ip],q);
+        QuaternionProduct (Pa->Q,q,dq);
+        mov += 2.0*Pa->Dmax*sqrt(dq(1)*dq(1)+dq(2)*dq(2)+dq(3)*dq(3));
+    }
+    return mov<ImprintTol*Lat[0].dx;
+}
+
+inline void Domain::ClearImprint (size_t Np)
+{
+    // The 2D and multicomponent imprints add up the contributions of the particles, they start from a clear lattice
+    if (!IncImprint||FullClear||Lat.Size()>1||Lat[0].Ndim(2)==1)
+    {
+        for (size_t j=0;j<Lat.Size();j++) Lat[j].SetZeroGamma(0,Np);
+        FullClear = false;
+        return;
+    }
+
+    Lattice & L = Lat[0];
+    size_t Nc = L.SoA ? L.Npack : L.Ncells;
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Np)
+#endif
+    for (size_t i=0;i<Nc;i++)
+    {
+        if (L.SoA) L.BForce[i] = L.BForcef[i];
+        else       L.Cells[i]->BForce = L.Cells[i]->BForcef;
+    }
+
+    // The cells covered by the particles that moved are cleared before any particle imprints again, the
+    // particles at rest write the same solid fractions and the shared cells end up as after a full clear.
+    // The collision operators are left, they only count where the solid fraction is not zero.
+    size_t Npar = StencilStart.Size()>0 ? StencilStart.Size()-1 : 0;
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Np)
+#endif
+    for (size_t ip=0;ip<Npar;ip++)
+    {
+        if (StencilReuse(ip)) continue;
+        for (size_t e=StencilStart[ip];e<StencilStart[ip+1];e++)
+        {
+            if (fabs(StencilLen[e])<1.0e-12) continue;
+            L.GetGamma(StencilCell[e]) = 0.0;
+        }
+    }
+}
+
+inline void Domain::BuildOverlapTable ()
+{
+    // Radii of the spheres around the particle features (disks in 2D) in units of dx
+    size_t Dim  = (Lat[0].Ndim(2)==1) ? 2 : 3;
+    double dx   = Lat[0].dx;
+    double Rmin = 0.0;
+    double Rmax = 0.0;
+    size_t Nb   = (Dim==2) ? Disks.Size() : Particles.Size();
+    for (size_t i=0;i<Nb;i++)
+    {
+        double R = ((Dim==2) ? Disks[i]->R : Particles[i]->Props.R)/dx;
+        if (i==0||R<Rmin) Rmin = R;
+        if (i==0||R>Rmax) Rmax = R;
+    }
+    if (Nb==0||OvTable.Covers(Dim,Rmin,Rmax)) return;
+    OvTable.Build(Dim,Rmin,Rmax);
+    printf("%s  Overlap table for R/dx in [%g,%g] = %zd x %zd samples%s\n",TERM_CLR2,Rmin,Rmax,OvTable.Ns,OvTable.Nr,TERM_RST);
+}
+
+inline void Domain::StoreHydro ()
+{
+    size_t Np    = Particles.Size();
+    size_t Nd    = Disks.Size();
+    bool   first = Fhyd.Size()!=Np+Nd;
+    if (first)
+    {
+        Fhyd .Resize(Np+Nd);
+        Thyd .Resize(Np+Nd);
+        Fhyd0.Resize(Np+Nd);
+        Thyd0.Resize(Np+Nd);
+    }
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+#endif
+    for (size_t i=0;i<Np+Nd;i++)
+    {
+        Vec3_t F,T;
+        if (i<Np)
+        {
+            F = Particles[i]->F - Particles[i]->Ff;
+            T = Particles[i]->T - Particles[i]->Tf;
+        }
+        else
+        {
+            F = Disks[i-Np]->F - Disks[i-Np]->Ff;
+            T = Disks[i-Np]->T - Disks[i-Np]->Tf;
+        }
+        Fhyd0[i] = first ? F : Fhyd[i];
+        Thyd0[i] = first ? T : Thyd[i];
+        Fhyd [i] = F;
+        Thyd [i] = T;
+    }
+}
+
+inline void Domain::ApplyHydro (double s)
+{
+    size_t Np = Particles.Size();
+    size_t Nd = Disks.Size();
+    if (Fhyd.Size()!=Np+Nd) return;
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+#endif
+    for (size_t i=0;i<Np+Nd;i++)
+    {
+        Vec3_t F = Fhyd0[i] + s*(Fhyd[i]-Fhyd0[i]);
+        Vec3_t T = Thyd0[i] + s*(Thyd[i]-Thyd0[i]);
+        if (i<Np)
+        {
+            Particles[i]->F = Particles[i]->Ff + F;
+            Particles[i]->T = Particles[i]->Tf + T;
+        }
+        else
+        {
+            Disks[i-Np]->F = Disks[i-Np]->Ff + F;
+            Disks[i-Np]->T = Disks[i-Np]->Tf + T;
         }
     }
 }
@@ -2668,7 +3371,7 @@ void Domain::ImprintLatticeMC (size_t n,size_t Np)
             double y              = Lat[0].dx*(cell->Index(1));
             double z              = Lat[0].dx*(cell->Index(2));
             Vec3_t  C(x,y,z);
-            double len = DEM::DiskSquare(Pa->X,C,Pa->R,Lat[0].dx);
+            double len = FastOverlap ? OvTable.Len(norm(C-Pa->X),Pa->R,Lat[0].dx) : DEM::DiskSquare(Pa->X,C,Pa->R,Lat[0].dx);
             if (fabs(len)<1.0e-12) continue;
             for (size_t j=0;j<Lat.Size();j++)
             {
@@ -2693,7 +3396,7 @@ void Domain::ImprintLatticeMC (size_t n,size_t Np)
                     double Omega   = cell->F[cell->Op[k]] - Fvpp - (cell->F[k] - Fvp);
 
                     cell->Omeis[k] += gamma*Omega;
-                    Cell *nb        = Lat[j].Cells[cell->Neighs[k]];
+                    Cell *nb        = Lat[j].Cells[Lat[j].Neigh(cell->ID,k)];
 
                     double Fcontact;
                     (cell->Gammap>0.0)&&(cell->Gammap<1.0) ? Fcontact = Lat[j].Gs*cell->W[k]*cell->Rho*floor(nb->Gammap) : Fcontact = 0.0;
@@ -2794,7 +3497,7 @@ void Domain::ImprintLatticeMC (size_t n,size_t Np)
                 double dotpro = dot(C-Xs,Nor);
                 if (dotpro>0.0||fabs(dotpro)<0.95*minl||Pa->Faces.Size()<4) 
                 {
-                    len = DEM::SphereCube(Xs,C,Pa->Props.R,Lat[0].dx);
+                    len = FastOverlap ? OvTable.Len(norm(C-Xs),Pa->Props.R,Lat[0].dx) : DEM::SphereCube(Xs,C,Pa->Props.R,Lat[0].dx);
                 }
             }
             //std::cout << "2" << std::endl;
@@ -2825,7 +3528,7 @@ void Domain::ImprintLatticeMC (size_t n,size_t Np)
                     double Omega    = cell->F[cell->Op[k]] - Fvpp - (cell->F[k] - Fvp);
                     //cell->Omeis[k] += Omega;
                     cell->Omeis[k] += gamma*Omega;
-                    Cell *nb        = Lat[j].Cells[cell->Neighs[k]];
+                    Cell *nb        = Lat[j].Cells[Lat[j].Neigh(cell->ID,k)];
 
                     double Fcontact;
                     (cell->Gammap>0.0)&&(cell->Gammap<1.0) ? Fcontact = Lat[j].Gs*cell->W[k]*cell->Rho*floor(nb->Gammap) : Fcontact = 0.0;
@@ -2862,16 +3565,38 @@ inline void Domain::ResetDisplacements()
         MTD[i].LLC.Resize(0);
     }
     //std::cout << "1" << std::endl;
+    // The linked cells hold the disks in 2D and the particles in 3D
+    bool D2 = (Lat[0].Ndim(2)==1);
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     for (size_t i=0;i<Particles.Size();i++)
     {
         Particles[i]->ResetDisplacements();
-        if(Particles[i]->IsFree())
+        if(!D2&&Particles[i]->IsFree())
         {
             iVec3_t idx = (Particles[i]->x - LCxmin)/(2.0*Beta*MaxDmax);
             MTD[omp_get_thread_num()].LLC.Push(std::make_pair(idx,i));
         }
     }
+
+    //Only for 2D Disks
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t i=0;i<Disks.Size();i++)
+    {
+        Disks[i]->X0 = Disks[i]->X;
+    }
+    // Fixed disks may lie outside the bounding box of the free ones, they go to the nearest linked cell
+    size_t Nfd = D2 ? FreeDisk.Size() : 0;
+    #pragma omp parallel for schedule(static) num_threads(Nproc)
+    for (size_t n=0;n<Nfd;n++)
+    {
+        size_t i = FreeDisk[n];
+        iVec3_t idx;
+        for (size_t k=0;k<3;k++)
+        {
+            idx(k) = std::min(std::max(floor((Disks[i]->X(k) - LCxmin(k))/(2.0*Beta*MaxDmax)),0.0),double(LCellDim(k)-1));
+        }
+        MTD[omp_get_thread_num()].LLC.Push(std::make_pair(idx,i));
+    }
     //std::cout << "2" << std::endl;
     for (size_t i=0;i<Nproc;i++)
     {
@@ -2882,13 +3607,6 @@ inline void Domain::ResetDisplacements()
             LinkedCell[idx].Push(MTD[i].LLC[j].second);
         }
     }
-
-    //Only for 2D Disks
-    #pragma omp parallel for schedule(static) num_threads(Nproc)
-    for (size_t i=0;i<Disks.Size();i++)
-    {
-        Disks[i]->X0 = Disks[i]->X;
-    }
     //std::cout << "3" << std::endl;
 #else
     for (size_t i=0; i<Particles.Size(); i++)
@@ -2912,17 +3630,22 @@ inline double Domain::MaxDisplacement()
 #ifdef USE_OMP
 inline void Domain::UpdateLinkedCells()
 {
+    // Pairs of disks in 2D (List2DPairs) and of particles in 3D (ListPosPairs)
+    bool D2 = (Lat[0].Ndim(2)==1);
+    Array<size_t> const & Free   = D2 ? FreeDisk   : FreePar;
+    Array<size_t> const & NoFree = D2 ? NoFreeDisk : NoFreePar;
+    Array<pair<size_t, size_t> > & PosPairs = D2 ? List2DPairs : ListPosPairs;
     #pragma omp parallel for schedule(static) num_threads(Nproc)
     for (size_t i=0;i<Nproc;i++)
     {
         MTD[i].LPP.Resize(0);
     }
     #pragma omp parallel for schedule(static) num_threads(Nproc)
-    for (size_t i=0;i<FreePar.Size()  ;i++)
-    for (size_t j=0;j<NoFreePar.Size();j++)
+    for (size_t i=0;i<Free.Size()  ;i++)
+    for (size_t j=0;j<NoFree.Size();j++)
     {
-        size_t i1 = std::min(FreePar[i],NoFreePar[j]);
-        size_t i2 = std::max(FreePar[i],NoFreePar[j]);
+        size_t i1 = std::min(Free[i],NoFree[j]);
+        size_t i2 = std::max(Free[i],NoFree[j]);
         MTD[omp_get_thread_num()].LPP.Push(std::make_pair(i1,i2));
     }
     #pragma omp parallel for schedule(static) num_threads(Nproc)
@@ -2968,20 +3691,20 @@ inline void Domain::UpdateLinkedCells()
     {
         Npp += MTD[i].LPP.Size();
     }
-    ListPosPairs.Resize(Npp);
+    PosPairs.Resize(Npp);
     size_t idx = 0;
     for (size_t i=0;i<Nproc;i++)
     {
         for (size_t j=0;j<MTD[i].LPP.Size();j++)
         {
-            ListPosPairs[idx] = MTD[i].LPP[j];
+            PosPairs[idx] = MTD[i].LPP[j];
             idx++;
         }
     }
 }
 #endif
 
-inline void Domain::ResetContacts()
+inline void Domain::ResetContacts(bool CellPairs)
 {
 #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(Nproc)
@@ -2996,15 +3719,17 @@ inline void Domain::ResetContacts()
     //2D case
     if (Lat[0].Ndim(2)==1)
     {
-        //2D case
+        //2D case, the pairs of the disks are only gathered if CellPairs
+        size_t Nd = CellPairs ? Disks.Size() : 0;
         #pragma omp parallel for schedule(static) num_threads(Nproc)
-	    for (size_t i=0;i<Disks.Size();i++)
+	    for (size_t i=0;i<Nd;i++)
         {
             LBM::Disk * Pa = Disks[i];
             for (size_t n=std::max(0.0,double(Pa->X(0)-Pa->R-2.0*Alpha-Lat[0].dx)/Lat[0].dx);n<=std::min(double(Lat[0].Ndim(0)-1),double(Pa->X(0)+Pa->R+2.0*Alpha+Lat[0].dx)/Lat[0].dx);n++)
             for (size_t m=std::max(0.0,double(Pa->X(1)-Pa->R-2.0*Alpha-Lat[0].dx)/Lat[0].dx);m<=std::min(double(Lat[0].Ndim(1)-1),double(Pa->X(1)+Pa->R+2.0*Alpha+Lat[0].dx)/Lat[0].dx);m++)
             {
                 Cell  * cell = Lat[0].GetCell(iVec3_t(n,m,0));
+                if (cell==NULL||Lat[0].Ghost(cell->ID)) continue;
                 double x     = Lat[0].dx*(cell->Index(0));
                 double y     = Lat[0].dx*(cell->Index(1));
                 double z     = Lat[0].dx*(cell->Index(2));
@@ -3059,14 +3784,21 @@ inline void Domain::ResetContacts()
             bool pj_has_vf = !Particles[j]->IsFree();
             bool close = (DEM::Distance(Particles[i]->x,Particles[j]->x)<=Particles[i]->Dmax+Particles[j]->Dmax+2*Alpha);
             if ((pi_has_vf && pj_has_vf) || !close) continue;
-            std::set<std::pair<DEM::Particle *, DEM::Particle *> >::iterator it = Listofpairs.find(std::make_pair(Particles[i],Particles[j]));
-            if (it != Listofpairs.end())
-            {
-                continue;
-            }
+            if (Listofpairs.Has(i,j)) continue;
             MTD[omp_get_thread_num()].LC.Push(std::make_pair(i,j));
         }
         //std::cout << "2" << std::endl;
+        size_t Nlc = 0;
+        for (size_t i=0;i<Nproc;i++) Nlc += MTD[i].LC.Size();
+        Listofpairs.Reserve(Listofpairs.Size()+Nlc);
+        #pragma omp parallel for schedule(static) num_threads(Nproc)
+        for (size_t i=0;i<Nproc;i++)
+        {
+            for (size_t j=0;j<MTD[i].LC.Size();j++)
+            {
+                Listofpairs.InsertConcurrent(MTD[i].LC[j].first,MTD[i].LC[j].second);
+            }
+        }
         for (size_t i=0;i<Nproc;i++)
         {
             //std::cout << MTD[i].LC.Size() << std::endl;
@@ -3075,7 +3807,6 @@ inline void Domain::ResetContacts()
             //std::cout << MTD[i].LC.Size() << std::endl;
                 size_t n = MTD[i].LC[j].first;
                 size_t m = MTD[i].LC[j].second;
-                Listofpairs.insert(std::make_pair(Particles[n],Particles[m]));
                 if (Particles[n]->Verts.Size()==1 && Particles[m]->Verts.Size()==1)
                 {
                     CInteractons.Push (new DEM::CInteractonSphere(Particles[n],Particles[m]));
@@ -3112,8 +3843,9 @@ inline void Domain::ResetContacts()
         }
 
         //std::cout << "5" << std::endl;
+        size_t Np = CellPairs ? Particles.Size() : 0;
         #pragma omp parallel for schedule(static) num_threads(Nproc)
-	    for (size_t i=0;i<Particles.Size();i++)
+	    for (size_t i=0;i<Np;i++)
         {
             //Cell  * cell = dat.Dom->Lat[0].Cells[i];
             DEM::Particle * Pa = Particles[i];
@@ -3131,6 +3863,7 @@ inline void Domain::ResetContacts()
             {
                 //DEM::Particle * Pa = dat.Dom->Particles[n];
                 Cell  * cell = Lat[0].GetCell(iVec3_t(n,m,l));
+                if (cell==NULL||Lat[0].Ghost(cell->ID)) continue;
                 double x     = Lat[0].dx*(cell->Index(0));
                 double y     = Lat[0].dx*(cell->Index(1));
                 double z     = Lat[0].dx*(cell->Index(2));
@@ -3239,6 +3972,7 @@ inline void Domain::ResetContacts()
     }
     //std::cout << "6" << std::endl;
 
+    if (!CellPairs) return;
     ParCellPairs.Resize(0);
     for (size_t i=0;i<Nproc;i++)
     {
@@ -3247,6 +3981,7 @@ inline void Domain::ResetContacts()
             ParCellPairs.Push(MTD[i].LPC[j]);
         }
     }
+    if (Lat[0].Ndim(2)>1) BuildStencils();
 #else
 	if (Particles.Size()==0) return;
     for (size_t i=0; i<Particles.Size()-1; i++)
@@ -3260,12 +3995,7 @@ inline void Domain::ResetContacts()
             if ((pi_has_vf && pj_has_vf) || !close) continue;
             
             // checking if the interacton exist for that pair of particles
-            set<std::pair<DEM::Particle *, DEM::Particle *> >::iterator it = Listofpairs.find(std::make_pair(Particles[i],Particles[j]));
-            if (it != Listofpairs.end())
-            {
-                continue;
-            }
-            Listofpairs.insert(std::make_pair(Particles[i],Particles[j]));
+            if (!Listofpairs.Insert(i,j)) continue;
             if (Particles[i]->Verts.Size()==1 && Particles[j]->Verts.Size()==1)
             {
                 CInteractons.Push (new DEM::CInteractonSphere(Particles[i],Particles[j]));
@@ -3287,6 +4017,7 @@ inline void Domain::ResetContacts()
         if(BInteractons[i]->UpdateContacts(Alpha)) Interactons.Push(BInteractons[i]);
     }
 
+    if (!CellPairs) return;
     ParCellPairs.Resize(0);
 
     for (size_t i=0; i<Particles.Size(); i++)
@@ -3297,6 +4028,7 @@ inline void Domain::ResetContacts()
         for (size_t l=std::max(0.0,double(Pa->x(2)-Pa->Dmax-2.0*Alpha-Lat[0].dx)/Lat[0].dx);l<=std::min(double(Lat[0].Ndim(2)-1),double(Pa->x(2)+Pa->Dmax+2.0*Alpha+Lat[0].dx)/Lat[0].dx);l++)
         {
             Cell  * cell = Lat[0].GetCell(iVec3_t(n,m,l));
+            if (cell==NULL||Lat[0].Ghost(cell->ID)) continue;
             double x     = Lat[0].dx*(cell->Index(0));
             double y     = Lat[0].dx*(cell->Index(1));
             double z     = Lat[0].dx*(cell->Index(2));
@@ -3347,7 +4079,18 @@ inline void Domain::ResetContacts()
             if (valid) ParCellPairs.Push(NewPCP);
         }
     }
+    BuildStencils();
 #endif
+
+    // Reference positions and orientations to tell when the pairs have to be built again
+    PairX.Resize(Particles.Size()+Disks.Size());
+    PairQ.Resize(Particles.Size());
+    for (size_t i=0;i<Particles.Size();i++)
+    {
+        PairX[i] = Particles[i]->x;
+        PairQ[i] = Particles[i]->Q;
+    }
+    for (size_t i=0;i<Disks.Size();i++) PairX[Particles.Size()+i] = Disks[i]->X;
 }
 
 //Utility methods
@@ -3521,6 +4264,42 @@ inline void Domain::Initialize (double dt)
     }
 }
 
+#ifdef USE_MPI
+inline void Domain::ReduceForces()
+{
+    // The particles live in every rank but each rank only imprints the cells it owns
+    size_t Np = Particles.Size();
+    size_t Nd = Disks.Size();
+    if (Np+Nd==0) return;
+    Array<double> Loc(6*(Np+Nd)), Tot(6*(Np+Nd));
+    for (size_t i=0;i<Np;i++)
+    for (size_t d=0;d<3;d++)
+    {
+        Loc[6*i+d  ] = Particles[i]->F(d) - Particles[i]->Ff(d);
+        Loc[6*i+d+3] = Particles[i]->T(d) - Particles[i]->Tf(d);
+    }
+    for (size_t i=0;i<Nd;i++)
+    for (size_t d=0;d<3;d++)
+    {
+        Loc[6*(Np+i)+d  ] = Disks[i]->F(d) - Disks[i]->Ff(d);
+        Loc[6*(Np+i)+d+3] = Disks[i]->T(d) - Disks[i]->Tf(d);
+    }
+    MPI_Allreduce(Loc.GetPtr(),Tot.GetPtr(),6*(Np+Nd),MPI_DOUBLE,MPI_SUM,MPI_COMM_WORLD);
+    for (size_t i=0;i<Np;i++)
+    for (size_t d=0;d<3;d++)
+    {
+        Particles[i]->F(d) = Particles[i]->Ff(d) + Tot[6*i+d  ];
+        Particles[i]->T(d) = Particles[i]->Tf(d) + Tot[6*i+d+3];
+    }
+    for (size_t i=0;i<Nd;i++)
+    for (size_t d=0;d<3;d++)
+    {
+        Disks[i]->F(d) = Disks[i]->Ff(d) + Tot[6*(Np+i)+d  ];
+        Disks[i]->T(d) = Disks[i]->Tf(d) + Tot[6*(Np+i)+d+3];
+    }
+}
+#endif
+
 inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t ptReport,
                           char const * TheFileKey, bool RenderVideo, size_t TheNproc)
 {
@@ -3532,6 +4311,14 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
 
     if (dtdem<1.0e-12||dtdem>dt) dtdem = dt;
 
+    // Whole number of DEM substeps per LBM step, dtdem is shortened if needed
+    Nsub  = std::max(1.0,ceil(dt/dtdem-1.0e-9));
+    dtdem = dt/Nsub;
+    Fhyd.Resize(0);
+
+    // Mean overlap lengths for the radii of the particles
+    if (FastOverlap) BuildOverlapTable();
+
     // initialize particles
     Initialize (dtdem);
     // calc the total volume of particles (solids)
@@ -3558,6 +4345,19 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
         }
         else NoFreePar.Push(i);
     }
+    // The free disks size the linked cells of the 2D case as the particles do in 3D, the fixed disks
+    // that fit in them are binned as well and only the larger ones are paired with all the others
+    FreeDisk.Resize(0);
+    NoFreeDisk.Resize(0);
+    for (size_t i=0; i<Disks.Size(); i++)
+    {
+        if (Disks[i]->IsFree()&&Disks[i]->R > MaxDmax) MaxDmax = Disks[i]->R;
+    }
+    for (size_t i=0; i<Disks.Size(); i++)
+    {
+        if (Disks[i]->IsFree()||Disks[i]->R <= MaxDmax) FreeDisk.Push(i);
+        else NoFreeDisk.Push(i);
+    }
     for (size_t i=0; i<BInteractons.Size(); i++)
     {
         double pbn = BInteractons[i]->Bn/BInteractons[i]->L0;
@@ -3575,6 +4375,7 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
     printf("%s  Total number of particles        =  %zd%s\n"      ,TERM_CLR2, Particles.Size()                     , TERM_RST);
     printf("%s  Time step                        =  %g%s\n"       ,TERM_CLR2, dt                                   , TERM_RST);
     printf("%s  Time step for DEM                =  %g%s\n"       ,TERM_CLR2, dtdem                                , TERM_RST);
+    printf("%s  DEM substeps per LBM step        =  %zd%s\n"      ,TERM_CLR2, Nsub                                 , TERM_RST);
     printf("%s  Verlet distance                  =  %g%s\n"       ,TERM_CLR2, Alpha                                , TERM_RST);
     for (size_t i=0;i<Lat.Size();i++)
     {
@@ -3599,21 +4400,29 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
 
 
     //std::cout << "1" << std::endl;
-    // Creates pair of cells to speed up body force calculation
+    // Check for partially permeable cells
     for (size_t i=0;i<Lat[0].Ncells;i++)
     {
-        Cell * c = Lat[0].Cells[i];
-        if (fabs(1.0-c->Pf) > 1.0e-8) PrtPer = true;
-        for (size_t j=1;j<c->Nneigh;j++)
-        {
-            Cell * nb = Lat[0].Cells[c->Neighs[j]];
-            if (nb->ID>c->ID) 
-            {
-                if (!c->IsSolid||!nb->IsSolid) CellPairs.Push(iVec3_t(i,nb->ID,j));
-            }
-        }
+        if (fabs(1.0-Lat[0].Cells[i]->Pf) > 1.0e-8) PrtPer = true;
     }
+#ifdef USE_MPI
+    if (Lat[0].Nranks>1)
+    {
+        int per = PrtPer, all;
+        MPI_Allreduce(&per,&all,1,MPI_INT,MPI_LOR,MPI_COMM_WORLD);
+        PrtPer = all;
+    }
+#endif
     //std::cout << "2" << std::endl;
+
+    // Pack the lattices into contiguous blocks
+    if (SoA||AAPattern||Sparse)
+    {
+        if (Lat.Size()>1) throw new Fatal("LBM::Domain: the packed (SoA) storage only supports single component fluids");
+        if (AAPattern&&fabs(Lat[0].G)+fabs(Lat[0].Gs)>1.0e-12) throw new Fatal("LBM::Domain: the AA pattern does not support molecular forces yet");
+        if ((AAPattern||Sparse)&&Lat[0].Nranks>1) throw new Fatal("LBM::Domain: the AA pattern and the sparse storage cannot be used on a lattice split among MPI ranks");
+        Lat[0].Pack(AAPattern,Sparse);
+    }
     
     MTD = new LBM::MtData[Nproc];
     for (size_t i=0;i<Nproc;i++)
@@ -3626,16 +4435,6 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
     }
     //std::cout << "3" << std::endl;
 #ifdef USE_OMP
-    if (Disks.Size()>0)
-    {
-        List2DPairs.Resize(0);
-        for (size_t i=0;i<Disks.Size()-1;i++)
-        for (size_t j=i+1;j<Disks.Size();j++)
-        {
-            List2DPairs.Push(make_pair(i,j));
-        }
-    }
-
     LinkedCell.Resize(0);
     BoundingBox(LCxmin,LCxmax);
     LCellDim = (LCxmax - LCxmin)/(2.0*Beta*MaxDmax) + iVec3_t(1,1,1);
@@ -3651,6 +4450,9 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
 
     //std::cout << "4" << std::endl;
     ImprintLatticeSC(0,Nproc);    
+#ifdef USE_MPI
+    for (size_t i=0;i<Lat.Size();i++) Lat[i].ExchangeGamma();
+#endif
 #else
 
     //Connect particles and lattice
@@ -3664,7 +4466,7 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
 
 #endif
     double tout = Time;
-    double tlbm = Time;
+    size_t isub = 0;
 
     //std::cout << "4" << std::endl;
     while (Time < Tf)
@@ -3675,6 +4477,7 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
         {
             if (TheFileKey!=NULL)
             {
+                for (size_t i=0;i<Lat.Size();i++) Lat[i].SyncCells(Nproc);
                 String fn;
                 fn.Printf    ("%s_%04d", TheFileKey, idx_out);
                 if ( RenderVideo) 
@@ -3698,10 +4501,11 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
         //std::chrono::high_resolution_clock::time_point ti1 = std::chrono::high_resolution_clock::now();
         //Initialize all the particles and cells
         //std::cout << "0" <<std::endl;
-        for (size_t i=0;i<Lat.Size();i++)
-        {
-            Lat[i].SetZeroGamma(0,Nproc);
-        }
+        // The lattice steps on the first of every Nsub DEM substeps, the particles are imprinted again
+        // on the other substeps only if Hydro is HydroImprint
+        bool lbmstep = isub==0;
+        bool imprint = lbmstep||Hydro==HydroImprint;
+        if (imprint) ClearImprint(Nproc);
         #pragma omp parallel for schedule(static) num_threads(Nproc)
         for(size_t i=0;i<Particles.Size();i++)
         {
@@ -3719,7 +4523,7 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
         //std::cout << "1" <<std::endl;
         
         //Imprint the particles into the lattice
-        if (Particles.Size()>0||Disks.Size()>0)
+        if ((Particles.Size()>0||Disks.Size()>0)&&imprint)
         {
             if (Lat.Size()>1||fabs(Lat[0].Gs)>0.0)
             {
@@ -3729,6 +4533,15 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
             {
                 ImprintLatticeSC(0,Nproc);
             }
+#ifdef USE_MPI
+            if (Lat[0].Nranks>1) ReduceForces();
+#endif
+            if (Hydro!=HydroImprint) StoreHydro();
+            if (Hydro==HydroLinear)  ApplyHydro(0.0);
+        }
+        else if (Particles.Size()>0||Disks.Size()>0)
+        {
+            ApplyHydro(Hydro==HydroLinear ? double(isub)/Nsub : 1.0);
         }
 
         //std::chrono::high_resolution_clock::time_point ti2 = std::chrono::high_resolution_clock::now();
@@ -3847,7 +4660,29 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
             UpdateLinkedCells();
 
             //std::cout << "4c" <<std::endl;
-            ResetContacts();
+            // With LazyPairs the particle cell pairs are kept until the particles moved more than Alpha since they were built,
+            // the rotation of a non spherical particle moves its features by up to 2*Dmax*|sin(theta/2)|
+            bool cellpairs = true;
+            if (LazyPairs&&PairX.Size()==Particles.Size()+Disks.Size()&&PairQ.Size()==Particles.Size())
+            {
+                double pdis = 0.0;
+                for (size_t i=0;i<Particles.Size();i++)
+                {
+                    DEM::Particle * Pa = Particles[i];
+                    double mov = norm(Pa->x-PairX[i]);
+                    if (Pa->Verts.Size()>1)
+                    {
+                        Quaternion_t q,dq;
+                        Conjugate         (PairQ[i],q);
+                        QuaternionProduct (Pa->Q,q,dq);
+                        mov += 2.0*Pa->Dmax*sqrt(dq(1)*dq(1)+dq(2)*dq(2)+dq(3)*dq(3));
+                    }
+                    pdis = std::max(pdis,mov);
+                }
+                for (size_t i=0;i<Disks.Size()    ;i++) pdis = std::max(pdis,norm(Disks[i]->X-PairX[Particles.Size()+i]));
+                cellpairs = pdis>Alpha;
+            }
+            ResetContacts(cellpairs);
 
         }
         //std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
@@ -3856,7 +4691,7 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
         //std::cout << "Duration of DEM part " << duration12 << std::endl;
         
         //std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
-        if (Time>=tlbm)
+        if (lbmstep)
         {
             //Apply molecular forces
             if (Lat.Size()>1||(fabs(Lat[0].G)+fabs(Lat[0].Gs)>1.0e-12))
@@ -3866,11 +4701,22 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
                 {
                     if (fabs(Lat[0].G)<1.0e-9&&fabs(Lat[1].G)<1.0e-9) MC = true;
                 }
+#ifdef USE_MPI
+                for (size_t i=0;i<Lat.Size();i++) Lat[i].ExchangeGamma();
+#endif
                 ApplyForce(0,Nproc,MC);
             }
 
             //Apply collision operator
-            if (Particles.Size()>0||Disks.Size()>0)
+            if (Lat[0].AA)
+            {
+                CollideAA(0,Nproc);
+            }
+            else if (Lat[0].SoA)
+            {
+                CollideSoA(0,Nproc);
+            }
+            else if (Particles.Size()>0||Disks.Size()>0)
             {
                 if (Lat.Size()>1)
                 {
@@ -3891,9 +4737,11 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
             //Stream the distribution functions
             for (size_t i=0;i<Lat.Size();i++)
             {
-                Lat[i].Stream(0,Nproc);
+                if (!Lat[i].AA) Lat[i].Stream(0,Nproc);
+#ifdef USE_MPI
+                Lat[i].Exchange();
+#endif
             }
-            tlbm += dt;
         }
         
         //std::chrono::high_resolution_clock::time_point t4 = std::chrono::high_resolution_clock::now();
@@ -3942,9 +4790,11 @@ inline void Domain::Solve(double Tf, double dtOut, ptDFun_t ptSetup, ptDFun_t pt
 #endif
 
         Time += dtdem;
+        isub  = (isub+1)%Nsub;
         //std::cout << Time << " " << tlbm << std::endl;
     }
     // last output
+    for (size_t i=0;i<Lat.Size();i++) Lat[i].Unpack();
     Finished = true;
     if (ptReport!=NULL) (*ptReport) ((*this), UserData);
 
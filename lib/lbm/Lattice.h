@@ -25,6 +25,14 @@
 #include <hdf5_hl.h>
 #endif
 
+// MPI
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+// Std lib
+#include <stdlib.h> // for posix_memalign
+
 // MechSys
 #include <mechsys/lbm/Cell.h>
 #include <mechsys/util/util.h>
@@ -37,7 +45,7 @@ public:
     typedef void (*ptFun_t) (Lattice & Lat, void * UserData);
 
     //Constructors
-    Lattice () {};            //Default
+    Lattice () : Nranks(1), SoA(false), AA(false), Sparse(false) {};   //Default
     Lattice (LBMethod Method, double nu, iVec3_t Ndim, double dx, double dt);
 
     //Methods
@@ -59,6 +67,31 @@ public:
     void WriteXDMF(char const * FileKey);                                           ///< Write the state in a XDMF file
 #endif
     Cell * GetCell(iVec3_t const & v);                                              ///< Get pointer to cell at v
+    size_t Neigh(size_t i, size_t k);                                               ///< Index of the neighbour of cell i along direction k, with periodic wrap
+    bool   EdgeRow(size_t r);                                                       ///< Row r (of Ldim(0) cells) lies on a wrapping face
+    bool   Ghost  (size_t i);                                                       ///< Cell i is a copy of a cell owned by the neighbouring rank
+#ifdef USE_MPI
+    void   Exchange();                                                              ///< Send the populations streamed into the ghost planes to their owners and refresh the ghost planes
+    void   ExchangeGamma();                                                         ///< Copy the solid fractions of the first and last owned planes into the ghost planes of the neighbours
+#endif
+
+    // Structure of arrays storage
+    void     Pack(bool InPlace=false, bool TheSparse=false);                        ///< Move the cell data into contiguous per direction blocks, InPlace keeps a single buffer for the AA pattern, TheSparse stores only the fluid nodes and the solid nodes next to them and releases the other cells until Unpack
+    void     Unpack();                                                              ///< Move the packed data back into the cells and release the blocks
+    void     SyncCells(size_t Np = 1);                                              ///< Copy the packed macroscopic fields into the cells (for output)
+    void     VelDen(size_t n = 0, size_t Np = 1);                                   ///< Recompute density and velocity of every cell from the current populations
+    double   Density  (size_t i);                                                   ///< Density of cell i from the current populations
+    bool     Stored   (size_t i);                                                   ///< Cell i has storage and a Cell object (always true unless the packed storage is sparse)
+    size_t   Packed   (size_t i);                                                   ///< Packed index of cell i (must be stored)
+    size_t   CellOf   (size_t p);                                                   ///< Cell of packed node p
+    size_t   Upstream (size_t p, size_t k);                                         ///< Packed node from which direction k streams into packed node p
+    double & PackedF  (size_t p, size_t k);                                         ///< Distribution function k of packed node p
+    double & GetF     (size_t i, size_t k);                                         ///< Distribution function k of cell i for any storage
+    double & GetOmeis (size_t i, size_t k);                                         ///< Collision operator k of cell i for any storage
+    double & GetRho   (size_t i);                                                   ///< Density of cell i for any storage
+    Vec3_t & GetVel   (size_t i);                                                   ///< Velocity of cell i for any storage
+    double & GetGamma (size_t i);                                                   ///< Solid fraction of cell i for any storage
+    Vec3_t & GetBForce(size_t i);                                                   ///< Body force of cell i for any storage
 
 
      
@@ -71,17 +104,62 @@ public:
     double                                    Gs;               // Interaction strength with solids
     double                                    Nu;               // Real viscosity
     iVec3_t                                   Ndim;             // Integer dimension of the domain
+    iVec3_t                                   Ldim;             // Integer dimension of the cells stored here (Ndim unless the lattice is split)
     double                                    dx;               // grid space
     double                                    dt;               // time step
     double                                    Tau;              // Relaxation time
     double                                    Rhoref;           // Values for th intermolecular force
     double                                    Psiref;           // 
+    LBMethod                                  Method;           // Velocity set of the cells
     //Array<Cell *>                             Cells;            // Array of pointer cells
-    Cell                                   ** Cells;            // Array of pointer cells
+    Cell                                   ** Cells;            // Array of pointer cells (NULL for the cells without storage of a sparse packed lattice)
     //Array<std::pair<Cell *, Cell*> >          CellPairs;        // Array of pairs of cells for interaction
     void *                                    UserData;         // User Data
+    size_t                                    Nneigh;           // Number of discrete velocities
+    double                                    Cs;               // Velocity of the grid
+    size_t const                            * Op;               // Opposite velocities
+    double const                            * W;                // Weights
+    Vec3_t const                            * C;                // Velocity constants
+    long                                      Offset[27];       // Linear index offset to the neighbour along each direction (away from the wrapping faces)
+    bool                                      Wrap[3];          // Axes crossed by some velocity, their faces wrap around periodically
+
+    // Domain decomposition: with MPI the lattice is split into slabs normal to Axis, one per rank, each one
+    // padded with a ghost plane on both sides. Cell::Index is global, GetCell takes global indexes
+    size_t                                    Axis;             // Axis normal to the slabs (the last one with more than one cell)
+    long                                      Org;              // Global index along Axis of the first stored plane
+    size_t                                    Nplane;           // Number of cells in a plane normal to Axis
+    size_t                                    Rank;             // Rank owning this slab
+    size_t                                    Nranks;           // Number of slabs
+
+    // Packed storage, valid only while SoA is true. Direction k of cell i lives at F[k*Nstride+i]
+    bool                                      SoA;              // The cell data is packed
+    bool                                      AA;               // Single in-place buffer streamed with the AA pattern (no Ftemp)
+    bool                                      Odd;              // AA pattern: the populations sit post-collision in the opposite slot of their own cell
+    bool                                      Sparse;           // Only the fluid nodes and the solid nodes next to them are packed
+    size_t                                    Npack;            // Number of packed nodes (Ncells unless Sparse)
+    size_t                                    Nstride;          // Length of each direction block (Npack padded to the cache line)
+    size_t                                  * PackId;           // Sparse: packed index of each cell, Ncells for the cells without storage
+    size_t                                  * CellId;           // Sparse: cell of each packed node
+    size_t                                  * Nbr;              // Sparse: packed node each direction is pulled from (Nbr[k*Nstride+p]), links into the unstored solid point back to the node
+    double                                  * F;                // Distribution functions
+    double                                  * Ftemp;            // Temporary distribution functions
+    double                                  * Omeis;            // Collision operators of the partially saturated cells
+    double                                  * Rho;              // Densities
+    Vec3_t                                  * Vel;              // Velocities
+    double                                  * Gamma;            // Solid/Fluid ratios
+    double                                  * Pf;               // Percolation parameters
+    Vec3_t                                  * BForce;           // Body forces
+    Vec3_t                                  * BForcef;          // Fixed body forces
+    bool                                    * IsSolid;          // Solid nodes
 };
 
+inline double * AllocPacked(size_t N)
+{
+    void * ptr;
+    if (posix_memalign(&ptr,64,N*sizeof(double))!=0) throw new Fatal("Lattice::Pack: cannot allocate %zd doubles for the packed storage",N);
+    return static_cast<double *>(ptr);
+}
+
 inline Lattice::Lattice(LBMethod TheMethod, double Thenu, iVec3_t TheNdim, double Thedx, double Thedt)
 {
     Nu   = Thenu;
@@ -89,23 +167,67 @@ inline Lattice::Lattice(LBMethod TheMethod, double Thenu, iVec3_t TheNdim, doubl
     dx   = Thedx;
     dt   = Thedt;
     Tau  = 3.0*Nu*dt/(dx*dx) + 0.5;
+    Method = TheMethod;
     Rhoref = 200.0;
     Psiref = 4.0;
     G      = 0.0;
     Gs     = 0.0;
+    SoA    = false;
+    AA     = false;
+    Odd    = false;
+    Sparse = false;
+
+    // Split the planes normal to Axis evenly among the ranks
+    Axis   = Ndim(2)>1 ? 2 : 1;
+    Rank   = 0;
+    Nranks = 1;
+#ifdef USE_MPI
+    int init;
+    MPI_Initialized(&init);
+    if (init)
+    {
+        int rank,size;
+        MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+        MPI_Comm_size(MPI_COMM_WORLD,&size);
+        Rank   = rank;
+        Nranks = size;
+    }
+#endif
+    Ldim = Ndim;
+    Org  = 0;
+    if (Nranks>1)
+    {
+        if (Ndim(Axis)<2*Nranks) throw new Fatal("Lattice: %zd planes along axis %zd are too few to be split among %zd ranks",size_t(Ndim(Axis)),Axis,Nranks);
+        Org        = long(Rank*Ndim(Axis)/Nranks) - 1;
+        Ldim(Axis) = (Rank+1)*Ndim(Axis)/Nranks - Rank*Ndim(Axis)/Nranks + 2;
+    }
+    Nplane = Axis==2 ? Ldim(0)*Ldim(1) : Ldim(0);
 
     //Cells.Resize(Ndim[0]*Ndim[1]*Ndim[2]);
-    Cells = new Cell * [Ndim[0]*Ndim[1]*Ndim[2]];
-    Ncells = Ndim[0]*Ndim[1]*Ndim[2];
+    Cells = new Cell * [Ldim[0]*Ldim[1]*Ldim[2]];
+    Ncells = Ldim[0]*Ldim[1]*Ldim[2];
     size_t n = 0;
-    for (size_t k=0;k<Ndim[2];k++)
-    for (size_t j=0;j<Ndim[1];j++)
-    for (size_t i=0;i<Ndim[0];i++)
+    for (size_t k=0;k<Ldim[2];k++)
+    for (size_t j=0;j<Ldim[1];j++)
+    for (size_t i=0;i<Ldim[0];i++)
     {
+        iVec3_t idx(i,j,k);
+        idx(Axis) = (Org + long(idx(Axis)) + long(Ndim(Axis)))%long(Ndim(Axis));
         //Cells[n] =  new Cell(n,TheMethod,iVec3_t(i,j,k),Ndim,dx/dt,Tau);
-        Cells[n] = new Cell(n,TheMethod,iVec3_t(i,j,k),Ndim,dx/dt,Tau);
+        Cells[n] = new Cell(n,TheMethod,idx,Ndim,dx/dt,Tau);
         n++;
     } 
+    Nneigh = Cells[0]->Nneigh;
+    Cs     = Cells[0]->Cs;
+    Op     = Cells[0]->Op;
+    W      = Cells[0]->W;
+    C      = Cells[0]->C;
+    Wrap[0] = Wrap[1] = Wrap[2] = false;
+    for (size_t k=0;k<Nneigh;k++)
+    {
+        Offset[k] = long(C[k](0)) + long(C[k](1))*long(Ldim(0)) + long(C[k](2))*long(Ldim(0)*Ldim(1));
+        for (size_t d=0;d<3;d++) if (fabs(C[k](d))>0.0) Wrap[d] = true;
+    }
     //for (size_t i=0;i<Ndim[0]*Ndim[1]*Ndim[2];i++)
     //{
         //Cell * c = Cells[i];
@@ -124,23 +246,120 @@ inline Lattice::Lattice(LBMethod TheMethod, double Thenu, iVec3_t TheNdim, doubl
 
 inline void Lattice::Stream(size_t n, size_t Np)
 {
-	size_t Ni = Ncells/Np;
+    // Cells are swept row by row: inside the box the neighbour is a constant offset away,
+    // only the first and last cell of a row and the rows on the wrapping faces need Neigh
+    size_t Nx = Ldim(0);
+    size_t Nr = Ldim(1)*Ldim(2);
+	size_t Ni = Nr/Np;
     size_t In = n*Ni;
     size_t Fn;
-    n == Np-1 ? Fn = Ncells : Fn = (n+1)*Ni;
+    n == Np-1 ? Fn = Nr : Fn = (n+1)*Ni;
+    if (AA) throw new Fatal("Lattice::Stream: lattices using the AA pattern are streamed inside Domain::CollideAA");
+    if (SoA&&Sparse)
+    {
+        // Pull through the neighbour map, bounce back on the solid nodes happens in the collision
+        Ni = Npack/Np;
+        In = n*Ni;
+        n == Np-1 ? Fn = Npack : Fn = (n+1)*Ni;
+#ifdef USE_OMP
+        In = 0;
+        Fn = Npack;
+        #pragma omp parallel for schedule(static) num_threads(Np)
+#endif
+        for (size_t p=In;p<Fn;p++)
+        {
+            Ftemp[p] = F[p];
+            for (size_t k=1;k<Nneigh;k++) Ftemp[k*Nstride+p] = F[k*Nstride+Nbr[k*Nstride+p]];
+        }
+    }
+    else if (SoA)
+    {
+#ifdef USE_OMP
+        In = 0;
+        Fn = Nr;
+        #pragma omp parallel for schedule(static) num_threads(Np)
+#endif
+        for (size_t r=In;r<Fn;r++)
+        {
+            size_t i0   = r*Nx;
+            bool   edge = EdgeRow(r);
+            memcpy(Ftemp+i0,F+i0,Nx*sizeof(double));
+            for (size_t k=1;k<Nneigh;k++)
+            {
+                double * Fk = F     + k*Nstride;
+                double * Tk = Ftemp + k*Nstride;
+                if (edge)
+                {
+                    for (size_t x=0;x<Nx;x++) Tk[Neigh(i0+x,k)] = Fk[i0+x];
+                    continue;
+                }
+                Tk[Neigh(i0,k)] = Fk[i0];
+                if (Nx>1) Tk[Neigh(i0+Nx-1,k)] = Fk[i0+Nx-1];
+                double * Dk = Tk + i0 + Offset[k];
+                double * Sk = Fk + i0;
+                for (size_t x=1;x+1<Nx;x++) Dk[x] = Sk[x];
+            }
+        }
+    }
+    if (SoA)
+    {
+        double * Fswap = F;
+        F              = Ftemp;
+        Ftemp          = Fswap;
+
+        Ni = Npack/Np;
+        In = n*Ni;
+        n == Np-1 ? Fn = Npack : Fn = (n+1)*Ni;
+#ifdef USE_OMP
+        In = 0;
+        Fn = Npack;
+        #pragma omp parallel for schedule(static) num_threads(Np)
+#endif
+        for (size_t i=In;i<Fn;i++)
+        {
+            Vel[i] = OrthoSys::O;
+            Rho[i] = 0.0;
+            if (IsSolid[i]) continue;
+            for (size_t k=0;k<Nneigh;k++)
+            {
+                double & f = F[k*Nstride+i];
+                if (std::isnan(f)) f = 1.0e-12;
+                Vel[i] += f*C[k];
+                Rho[i] += f;
+            }
+            if (std::isnan(Rho[i])) throw new Fatal("NaN found in cell %zd",CellOf(i));
+            Vel[i] *= Cs/Rho[i];
+        }
+        return;
+    }
     // Assign temporal distributions
 #ifdef USE_OMP
     In = 0;
-    Fn = Ncells;
+    Fn = Nr;
     #pragma omp parallel for schedule(static) num_threads(Np)
 #endif
-    for (size_t i=In;i<Fn;i++)
-    for (size_t j=1;j<Cells[i]->Nneigh;j++)
+    for (size_t r=In;r<Fn;r++)
     {
-        Cells[Cells[i]->Neighs[j]]->Ftemp[j] = Cells[i]->F[j];
+        size_t i0   = r*Nx;
+        bool   edge = EdgeRow(r);
+        for (size_t x=0;x<Nx;x++)
+        {
+            size_t i = i0 + x;
+            if (edge||x==0||x+1==Nx)
+            {
+                for (size_t j=1;j<Nneigh;j++) Cells[Neigh(i,j)]->Ftemp[j] = Cells[i]->F[j];
+            }
+            else
+            {
+                for (size_t j=1;j<Nneigh;j++) Cells[i+Offset[j]]->Ftemp[j] = Cells[i]->F[j];
+            }
+        }
     }
 
     //Swap the distribution values
+    Ni = Ncells/Np;
+    In = n*Ni;
+    n == Np-1 ? Fn = Ncells : Fn = (n+1)*Ni;
 #ifdef USE_OMP
     In = 0;
     Fn = Ncells;
@@ -174,8 +393,7 @@ inline void Lattice::Stream1(size_t n, size_t Np)
     for (size_t i=In;i<Fn;i++)
     for (size_t j=1;j<Cells[i]->Nneigh;j++)
     {
-        //std::cout << i << " " << j << " " << Cells[i]->Neighs[j] << " " <<  Cells[i]->IsSolid << std::endl;
-        Cells[Cells[i]->Neighs[j]]->Ftemp[j] = Cells[i]->F[j];
+        Cells[Neigh(i,j)]->Ftemp[j] = Cells[i]->F[j];
     }
 }
 
@@ -211,6 +429,7 @@ inline void Lattice::SolidDisk(Vec3_t const & X, double R)
     for (size_t l=std::max(0.0,double(X(2)-R-dx)/dx);l<=std::min(double(Ndim(2)-1),double(X(2)+R+dx)/dx);l++)
     {
         Cell  * cell = GetCell(iVec3_t(n,m,l));
+        if (cell==NULL) continue;
         double x     = dx*cell->Index(0);
         double y     = dx*cell->Index(1);
         double z     = dx*cell->Index(2);
@@ -221,17 +440,24 @@ inline void Lattice::SolidDisk(Vec3_t const & X, double R)
 
 inline void Lattice::SetZeroGamma(size_t n, size_t Np)
 {
-	size_t Ni = Ncells/Np;
+    size_t Nc = SoA ? Npack : Ncells;
+	size_t Ni = Nc/Np;
     size_t In = n*Ni;
     size_t Fn;
-    n == Np-1 ? Fn = Ncells : Fn = (n+1)*Ni;
+    n == Np-1 ? Fn = Nc : Fn = (n+1)*Ni;
 #ifdef USE_OMP
     In = 0;
-    Fn = Ncells;
+    Fn = Nc;
     #pragma omp parallel for schedule(static) num_threads(Np)
 #endif
     for (size_t i=In;i<Fn;i++)
     {
+        if (SoA)
+        {
+            Gamma [i] = 0.0;
+            BForce[i] = BForcef[i];
+            continue;
+        }
         Cells[i]->Gammap = Cells[i]->Gamma;
         Cells[i]->Gamma  = 0.0;
         Cells[i]->BForce = Cells[i]->BForcef;
@@ -241,6 +467,16 @@ inline void Lattice::SetZeroGamma(size_t n, size_t Np)
             Cells[i]->Omeis[j] = 0.0;
         }
     }
+    if (SoA)
+    {
+#ifdef USE_OMP
+        #pragma omp parallel for schedule(static) num_threads(Np)
+#endif
+        for (size_t k=0;k<Nneigh;k++)
+        {
+            memset(Omeis+k*Nstride,0,Npack*sizeof(double));
+        }
+    }
 }
 
 inline double Lattice::Psi(double rho)
@@ -259,8 +495,17 @@ inline double Lattice::SolidFraction()
     double Sf = 0.0;
     for (size_t i=0; i<Ncells; i++)
     {
-        if (Cells[i]->IsSolid||Cells[i]->Gamma>0.0) Sf+=1.0;
+        if (Ghost(i)) continue;
+        if (!Stored(i)||Cells[i]->IsSolid||GetGamma(i)>0.0) Sf+=1.0;
+    }
+#ifdef USE_MPI
+    if (Nranks>1)
+    {
+        double Sfl = Sf;
+        MPI_Allreduce(&Sfl,&Sf,1,MPI_DOUBLE,MPI_SUM,MPI_COMM_WORLD);
+        return Sf/(Ndim(0)*Ndim(1)*Ndim(2));
     }
+#endif
     return Sf/(Ncells);
 }
 
@@ -292,7 +537,7 @@ inline void Lattice::ApplyForce()
         if (fabs(c->Gamma-1.0)<1.0e-12) continue;
         for (size_t j=1;j<c->Nneigh;j++)
         {
-            Cell * nb     = Cells[c->Neighs[j]];
+            Cell * nb     = Cells[Neigh(i,j)];
             double nb_psi = Psi(nb->Rho);
             double C      = G;
             if (nb->Gamma>0.0||nb->IsSolid)
@@ -549,7 +794,398 @@ inline void Lattice::WriteVTK(char const * FileKey)
 
 inline Cell * Lattice::GetCell(iVec3_t const & v)
 {
-    return Cells[v[0] + v[1]*Ndim[0] + v[2]*Ndim[0]*Ndim[1]];
+    if (Nranks==1) return Cells[v[0] + v[1]*Ndim[0] + v[2]*Ndim[0]*Ndim[1]];
+    // Global to local, NULL if the cell is neither owned nor a ghost here
+    iVec3_t l = v;
+    l(Axis) = (long(v(Axis)) - Org + long(Ndim(Axis)))%long(Ndim(Axis));
+    if (l(Axis)>=Ldim(Axis)) return NULL;
+    return Cells[l[0] + l[1]*Ldim[0] + l[2]*Ldim[0]*Ldim[1]];
+}
+
+inline size_t Lattice::Neigh(size_t i, size_t k)
+{
+    long idx[3] = {long(i%Ldim(0)), long((i/Ldim(0))%Ldim(1)), long(i/(Ldim(0)*Ldim(1)))};
+    for (size_t d=0;d<3;d++)
+    {
+        idx[d] += long(C[k](d));
+        if (idx[d]==-1)             idx[d] = Ldim(d)-1;
+        if (idx[d]==long(Ldim(d)))  idx[d] = 0;
+    }
+    return idx[0] + idx[1]*Ldim(0) + idx[2]*Ldim(0)*Ldim(1);
+}
+
+inline bool Lattice::EdgeRow(size_t r)
+{
+    size_t y = r%Ldim(1);
+    size_t z = r/Ldim(1);
+    return (Wrap[1]&&(y==0||y+1==Ldim(1)))||(Wrap[2]&&(z==0||z+1==Ldim(2)));
+}
+
+inline bool Lattice::Ghost(size_t i)
+{
+    return Nranks>1 && (i<Nplane||i>=Ncells-Nplane);
+}
+
+#ifdef USE_MPI
+inline void Lattice::Exchange()
+{
+    // After streaming the populations that left the slab across Axis sit in the ghost planes: they are
+    // sent to the first owned plane of the neighbour they belong to. Then the ghost planes are refreshed
+    // with full copies of the neighbours' boundary planes so the ghosts collide like any other cell
+    if (Nranks<2) return;
+    size_t Lp   = Ldim(Axis);
+    int    Up   = (Rank+1)%Nranks;
+    int    Down = (Rank+Nranks-1)%Nranks;
+    Array<size_t> Kup,Kdown;
+    for (size_t k=1;k<Nneigh;k++)
+    {
+        if (C[k](Axis)>0.0) Kup  .Push(k);
+        if (C[k](Axis)<0.0) Kdown.Push(k);
+    }
+    size_t Nk = Kup.Size()*Nplane;
+    Array<double> Snd(Nk), Rcv(Nk);
+
+    // Upwards: top ghost plane to the first owned plane of the rank above
+    size_t n = 0;
+    for (size_t k=0;k<Kup.Size();k++)
+    for (size_t i=(Lp-1)*Nplane;i<Lp*Nplane;i++) Snd[n++] = GetF(i,Kup[k]);
+    MPI_Sendrecv(Snd.GetPtr(),Nk,MPI_DOUBLE,Up,0,Rcv.GetPtr(),Nk,MPI_DOUBLE,Down,0,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+    n = 0;
+    for (size_t k=0;k<Kup.Size();k++)
+    for (size_t i=Nplane;i<2*Nplane;i++) GetF(i,Kup[k]) = Rcv[n++];
+
+    // Downwards: bottom ghost plane to the last owned plane of the rank below
+    n = 0;
+    for (size_t k=0;k<Kdown.Size();k++)
+    for (size_t i=0;i<Nplane;i++) Snd[n++] = GetF(i,Kdown[k]);
+    MPI_Sendrecv(Snd.GetPtr(),Nk,MPI_DOUBLE,Down,1,Rcv.GetPtr(),Nk,MPI_DOUBLE,Up,1,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+    n = 0;
+    for (size_t k=0;k<Kdown.Size();k++)
+    for (size_t i=(Lp-2)*Nplane;i<(Lp-1)*Nplane;i++) GetF(i,Kdown[k]) = Rcv[n++];
+
+    // The boundary planes are complete now, update their density and velocity
+    size_t Pb[2] = {1,Lp-2};
+    for (size_t b=0;b<2;b++)
+    for (size_t i=Pb[b]*Nplane;i<(Pb[b]+1)*Nplane;i++)
+    {
+        if (!SoA)
+        {
+            Cells[i]->Rho = Cells[i]->VelDen(Cells[i]->Vel);
+            continue;
+        }
+        Vel[i] = OrthoSys::O;
+        Rho[i] = 0.0;
+        if (IsSolid[i]) continue;
+        for (size_t k=0;k<Nneigh;k++)
+        {
+            Vel[i] += F[k*Nstride+i]*C[k];
+            Rho[i] += F[k*Nstride+i];
+        }
+        Vel[i] *= Cs/Rho[i];
+    }
+
+    // Ghost planes: populations, density and velocity of the neighbours' boundary planes
+    size_t Nv = (Nneigh+4)*Nplane;
+    Snd.Resize(Nv);
+    Rcv.Resize(Nv);
+    for (size_t dir=0;dir<2;dir++)
+    {
+        size_t src  = dir==0 ? Lp-2 : 1;         // plane sent
+        size_t dst  = dir==0 ? 0    : Lp-1;      // ghost plane received
+        int    to   = dir==0 ? Up   : Down;
+        int    from = dir==0 ? Down : Up;
+        n = 0;
+        for (size_t i=src*Nplane;i<(src+1)*Nplane;i++)
+        {
+            for (size_t k=0;k<Nneigh;k++) Snd[n++] = GetF(i,k);
+            Snd[n++] = GetRho(i);
+            for (size_t d=0;d<3;d++) Snd[n++] = GetVel(i)(d);
+        }
+        MPI_Sendrecv(Snd.GetPtr(),Nv,MPI_DOUBLE,to,2+dir,Rcv.GetPtr(),Nv,MPI_DOUBLE,from,2+dir,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+        n = 0;
+        for (size_t i=dst*Nplane;i<(dst+1)*Nplane;i++)
+        {
+            for (size_t k=0;k<Nneigh;k++) GetF(i,k) = Rcv[n++];
+            GetRho(i) = Rcv[n++];
+            for (size_t d=0;d<3;d++) GetVel(i)(d) = Rcv[n++];
+        }
+    }
+}
+
+inline void Lattice::ExchangeGamma()
+{
+    if (Nranks<2) return;
+    size_t Lp   = Ldim(Axis);
+    int    Up   = (Rank+1)%Nranks;
+    int    Down = (Rank+Nranks-1)%Nranks;
+    Array<double> Snd(Nplane), Rcv(Nplane);
+    for (size_t dir=0;dir<2;dir++)
+    {
+        size_t src  = dir==0 ? Lp-2 : 1;
+        size_t dst  = dir==0 ? 0    : Lp-1;
+        int    to   = dir==0 ? Up   : Down;
+        int    from = dir==0 ? Down : Up;
+        for (size_t i=0;i<Nplane;i++) Snd[i] = GetGamma(src*Nplane+i);
+        MPI_Sendrecv(Snd.GetPtr(),Nplane,MPI_DOUBLE,to,4+dir,Rcv.GetPtr(),Nplane,MPI_DOUBLE,from,4+dir,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+        for (size_t i=0;i<Nplane;i++) GetGamma(dst*Nplane+i) = Rcv[i];
+    }
+}
+#endif
+
+inline void Lattice::Pack(bool InPlace, bool TheSparse)
+{
+    if (SoA) return;
+    AA      = InPlace;
+    Odd     = false;
+    Sparse  = TheSparse;
+    Npack   = Ncells;
+    if (Sparse)
+    {
+        // Keep the fluid nodes and the solid nodes next to them: the populations bounced back by
+        // the latter are all the fluid ever gets from the solid, the rest of it is never touched
+        PackId = new size_t [Ncells];
+        Npack  = 0;
+        for (size_t i=0;i<Ncells;i++)
+        {
+            bool keep = !Cells[i]->IsSolid;
+            for (size_t k=1;k<Nneigh&&!keep;k++) keep = !Cells[Neigh(i,k)]->IsSolid;
+            PackId[i] = keep ? Npack++ : Ncells;
+        }
+        CellId = new size_t [Npack];
+        for (size_t i=0;i<Ncells;i++)
+        {
+            if (PackId[i]<Ncells) CellId[PackId[i]] = i;
+        }
+    }
+    Nstride = ((Npack + 7)/8)*8;
+    F       = AllocPacked(Nneigh*Nstride);
+    Ftemp   = AA ? NULL : AllocPacked(Nneigh*Nstride);
+    Omeis   = AllocPacked(Nneigh*Nstride);
+    Rho     = new double [Npack];
+    Vel     = new Vec3_t [Npack];
+    Gamma   = new double [Npack];
+    Pf      = new double [Npack];
+    BForce  = new Vec3_t [Npack];
+    BForcef = new Vec3_t [Npack];
+    IsSolid = new bool   [Npack];
+    if (Sparse)
+    {
+        Nbr = new size_t [Nneigh*Nstride];
+        for (size_t p=0;p<Npack;p++)
+        for (size_t k=0;k<Nneigh;k++)
+        {
+            size_t j = PackId[Neigh(CellId[p],Op[k])];
+            Nbr[k*Nstride+p] = j<Ncells ? j : p;
+        }
+    }
+    for (size_t p=0;p<Npack;p++)
+    {
+        Cell * c = Cells[CellOf(p)];
+        for (size_t k=0;k<Nneigh;k++)
+        {
+            F    [k*Nstride+p] = c->F    [k];
+            Omeis[k*Nstride+p] = c->Omeis[k];
+            if (!AA) Ftemp[k*Nstride+p] = c->Ftemp[k];
+        }
+        Rho    [p] = c->Rho;
+        Vel    [p] = c->Vel;
+        Gamma  [p] = c->Gamma;
+        Pf     [p] = c->Pf;
+        BForce [p] = c->BForce;
+        BForcef[p] = c->BForcef;
+        IsSolid[p] = c->IsSolid;
+    }
+    for (size_t i=0;i<Ncells;i++)
+    {
+        Cell * c = Cells[i];
+        delete [] c->F;
+        delete [] c->Ftemp;
+        delete [] c->Omeis;
+        c->F     = NULL;
+        c->Ftemp = NULL;
+        c->Omeis = NULL;
+        // The solid interior keeps no cell either, so the memory does not grow with it
+        if (Sparse&&PackId[i]==Ncells)
+        {
+            delete c;
+            Cells[i] = NULL;
+        }
+    }
+    SoA = true;
+}
+
+inline void Lattice::Unpack()
+{
+    if (!SoA) return;
+    SyncCells();
+    for (size_t i=0;i<Ncells;i++)
+    {
+        if (!Stored(i))
+        {
+            // Nothing inside the solid ever reaches the fluid, so it comes back as a solid cell with empty populations
+            iVec3_t idx(i%Ldim(0),(i/Ldim(0))%Ldim(1),i/(Ldim(0)*Ldim(1)));
+            idx(Axis) = (Org + long(idx(Axis)) + long(Ndim(Axis)))%long(Ndim(Axis));
+            Cell * c = new Cell(i,Method,idx,Ndim,dx/dt,Tau);
+            c->IsSolid = true;
+            c->Rho     = 0.0;
+            c->Vel     = OrthoSys::O;
+            for (size_t k=0;k<Nneigh;k++) c->F[k] = c->Ftemp[k] = c->Omeis[k] = 0.0;
+            Cells[i] = c;
+            continue;
+        }
+        Cell * c = Cells[i];
+        c->F     = new double [Nneigh];
+        c->Ftemp = new double [Nneigh];
+        c->Omeis = new double [Nneigh];
+        size_t p = Packed(i);
+        for (size_t k=0;k<Nneigh;k++)
+        {
+            c->F    [k] = PackedF(p,k);
+            c->Ftemp[k] = AA ? c->F[k] : Ftemp[k*Nstride+p];
+            c->Omeis[k] = Omeis[k*Nstride+p];
+        }
+        c->BForcef = BForcef[p];
+    }
+    free(F);
+    if (!AA) free(Ftemp);
+    free(Omeis);
+    delete [] Rho;
+    delete [] Vel;
+    delete [] Gamma;
+    delete [] Pf;
+    delete [] BForce;
+    delete [] BForcef;
+    delete [] IsSolid;
+    if (Sparse)
+    {
+        delete [] PackId;
+        delete [] CellId;
+        delete [] Nbr;
+    }
+    SoA    = false;
+    AA     = false;
+    Sparse = false;
+}
+
+inline void Lattice::SyncCells(size_t Np)
+{
+    if (!SoA) return;
+    if (AA) VelDen(0,Np);
+    #pragma omp parallel for schedule(static) num_threads(Np)
+    for (size_t p=0;p<Npack;p++)
+    {
+        Cell * c = Cells[CellOf(p)];
+        c->Rho    = Rho   [p];
+        c->Vel    = Vel   [p];
+        c->Gamma  = Gamma [p];
+        c->Pf     = Pf    [p];
+        c->BForce = BForce[p];
+    }
+}
+
+inline void Lattice::VelDen(size_t n, size_t Np)
+{
+    size_t Nc = SoA ? Npack : Ncells;
+	size_t Ni = Nc/Np;
+    size_t In = n*Ni;
+    size_t Fn;
+    n == Np-1 ? Fn = Nc : Fn = (n+1)*Ni;
+#ifdef USE_OMP
+    In = 0;
+    Fn = Nc;
+    #pragma omp parallel for schedule(static) num_threads(Np)
+#endif
+    for (size_t i=In;i<Fn;i++)
+    {
+        if (!SoA)
+        {
+            Cells[i]->Rho = Cells[i]->VelDen(Cells[i]->Vel);
+            continue;
+        }
+        Vel[i] = OrthoSys::O;
+        Rho[i] = 0.0;
+        if (IsSolid[i]) continue;
+        for (size_t k=0;k<Nneigh;k++)
+        {
+            double f = PackedF(i,k);
+            Vel[i] += f*C[k];
+            Rho[i] += f;
+        }
+        Vel[i] *= Cs/Rho[i];
+    }
+}
+
+inline double Lattice::Density(size_t i)
+{
+    if (!AA) return GetRho(i);
+    size_t p = Packed(i);
+    if (IsSolid[p]) return 0.0;
+    double rho = 0.0;
+    for (size_t k=0;k<Nneigh;k++) rho += PackedF(p,k);
+    return rho;
+}
+
+inline bool Lattice::Stored(size_t i)
+{
+    return !(SoA&&Sparse) || PackId[i]<Ncells;
+}
+
+inline size_t Lattice::Packed(size_t i)
+{
+    return Sparse ? PackId[i] : i;
+}
+
+inline size_t Lattice::CellOf(size_t p)
+{
+    return Sparse ? CellId[p] : p;
+}
+
+inline size_t Lattice::Upstream(size_t p, size_t k)
+{
+    if (Sparse) return Nbr[k*Nstride+p];
+    return Neigh(p,Op[k]);
+}
+
+inline double & Lattice::PackedF(size_t p, size_t k)
+{
+    if (AA&&Odd) return F[Op[k]*Nstride+Upstream(p,k)];
+    return F[k*Nstride+p];
+}
+
+inline double & Lattice::GetF(size_t i, size_t k)
+{
+    if (SoA) return PackedF(Packed(i),k);
+    return Cells[i]->F[k];
+}
+
+inline double & Lattice::GetOmeis(size_t i, size_t k)
+{
+    if (SoA) return Omeis[k*Nstride+Packed(i)];
+    return Cells[i]->Omeis[k];
+}
+
+inline double & Lattice::GetRho(size_t i)
+{
+    if (SoA) return Rho[Packed(i)];
+    return Cells[i]->Rho;
+}
+
+inline Vec3_t & Lattice::GetVel(size_t i)
+{
+    if (SoA) return Vel[Packed(i)];
+    return Cells[i]->Vel;
+}
+
+inline double & Lattice::GetGamma(size_t i)
+{
+    if (SoA) return Gamma[Packed(i)];
+    return Cells[i]->Gamma;
+}
+
+inline Vec3_t & Lattice::GetBForce(size_t i)
+{
+    if (SoA) return BForce[Packed(i)];
+    return Cells[i]->BForce;
 }
 
 inline void Lattice::Solve(double Tf, double dtOut, ptFun_t ptSetup, ptFun_t ptReport,
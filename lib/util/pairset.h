@@ -0,0 +1,150 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+#ifndef MECHSYS_PAIRSET_H
+#define MECHSYS_PAIRSET_H
+
+// Std lib
+#include <stdint.h> // for uint64_t
+#include <algorithm>
+#include <vector>
+
+// MechSys
+#include <mechsys/util/fatal.h>
+
+namespace Util
+{
+
+/** Set of ordered index pairs (i,j) stored in an open addressing hash table.
+ *  Both indices must fit in 32 bits. Has and InsertConcurrent may be called from
+ *  several threads at the same time, provided Reserve was called beforehand with
+ *  the final number of pairs. */
+class PairSet
+{
+public:
+    // Constructor
+    PairSet () : _size(0), _mask(0) {}
+
+    // Methods
+    size_t Size             () const { return _size; }                    ///< Number of pairs in the set
+    bool   Has              (size_t i, size_t j) const;                   ///< Check whether the pair (i,j) is in the set
+    bool   Insert           (size_t i, size_t j);                         ///< Insert the pair (i,j), growing the table if needed. Returns false if it was already there
+    bool   InsertConcurrent (size_t i, size_t j);                         ///< Thread safe Insert. It never grows the table, call Reserve first
+    void   Reserve          (size_t N);                                   ///< Make room for N pairs without rehashing
+    void   Clear            ();                                           ///< Remove all pairs and release the table
+
+private:
+    static const uint64_t EMPTY = ~uint64_t(0);
+
+    std::vector<uint64_t> _keys; ///< Slots, EMPTY when free
+    size_t                _size; ///< Number of used slots
+    size_t                _mask; ///< Number of slots minus one (power of two)
+
+    static uint64_t _key  (size_t i, size_t j) { return (uint64_t(i)<<32)|uint64_t(j); }
+    static size_t   _hash (uint64_t K)
+    {
+        // Mixer of splitmix64, the packed indices are far from random
+        K ^= K>>33;
+        K *= 0xff51afd7ed558ccdULL;
+        K ^= K>>33;
+        K *= 0xc4ceb9fe1a85ec53ULL;
+        K ^= K>>33;
+        return size_t(K);
+    }
+    void _rehash (size_t Nslots);
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////// Implementation /////
+
+
+inline bool PairSet::Has (size_t i, size_t j) const
+{
+    if (_size==0) return false;
+    uint64_t k = _key(i,j);
+    for (size_t s=_hash(k)&_mask;;s=(s+1)&_mask)
+    {
+        uint64_t ks = _keys[s];
+        if (ks==k)     return true;
+        if (ks==EMPTY) return false;
+    }
+}
+
+inline bool PairSet::Insert (size_t i, size_t j)
+{
+    if (2*(_size+1)>_keys.size()) _rehash(std::max((size_t)16,2*_keys.size()));
+    uint64_t k = _key(i,j);
+    for (size_t s=_hash(k)&_mask;;s=(s+1)&_mask)
+    {
+        if (_keys[s]==k) return false;
+        if (_keys[s]==EMPTY)
+        {
+            _keys[s] = k;
+            _size++;
+            return true;
+        }
+    }
+}
+
+inline bool PairSet::InsertConcurrent (size_t i, size_t j)
+{
+    if (_keys.size()==0) throw new Fatal("PairSet::InsertConcurrent: Reserve must be called before inserting concurrently");
+    uint64_t k = _key(i,j);
+    for (size_t s=_hash(k)&_mask;;s=(s+1)&_mask)
+    {
+        uint64_t ks = __sync_val_compare_and_swap(&_keys[s],EMPTY,k);
+        if (ks==EMPTY)
+        {
+            __sync_fetch_and_add(&_size,1);
+            return true;
+        }
+        if (ks==k) return false;
+    }
+}
+
+inline void PairSet::Reserve (size_t N)
+{
+    size_t n = 16;
+    while (n<2*N) n *= 2;
+    if (n>_keys.size()) _rehash(n);
+}
+
+inline void PairSet::Clear ()
+{
+    std::vector<uint64_t>().swap(_keys);
+    _size = 0;
+    _mask = 0;
+}
+
+inline void PairSet::_rehash (size_t Nslots)
+{
+    std::vector<uint64_t> old(Nslots,uint64_t(EMPTY));
+    old.swap(_keys);
+    _mask = Nslots-1;
+    for (size_t n=0;n<old.size();n++)
+    {
+        if (old[n]==EMPTY) continue;
+        size_t s = _hash(old[n])&_mask;
+        while (_keys[s]!=EMPTY) s = (s+1)&_mask;
+        _keys[s] = old[n];
+    }
+}
+
+}; // namespace Util
+
+#endif // MECHSYS_PAIRSET_H
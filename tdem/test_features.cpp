@@ -0,0 +1,148 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Feature pair micro-benchmark: contact list updates between pairs of many sided prisms
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+// Prism with Ns lateral faces, circumradius A and height H centred at X
+void AddPrism (DEM::Domain & Dom, int Tag, Vec3_t const & X, size_t Ns, double A, double H, double R, double rho)
+{
+    Array<Vec3_t> V(2*Ns);
+    for (size_t i=0;i<Ns;i++)
+    {
+        double th = 2.0*M_PI*i/Ns;
+        V[i]    = A*cos(th),A*sin(th),-0.5*H;
+        V[Ns+i] = A*cos(th),A*sin(th), 0.5*H;
+    }
+    Array<Array <int> > E(3*Ns);
+    Array<Array <int> > F(Ns+2);
+    F[0].Resize(Ns);
+    F[1].Resize(Ns);
+    for (size_t i=0;i<Ns;i++)
+    {
+        size_t j = (i+1)%Ns;
+        E[i]      .Resize(2); E[i]       = i   , j;
+        E[Ns+i]   .Resize(2); E[Ns+i]    = Ns+i, Ns+j;
+        E[2*Ns+i] .Resize(2); E[2*Ns+i]  = i   , Ns+i;
+        F[0][i]   = Ns-1-i;
+        F[1][i]   = Ns+i;
+        F[2+i].Resize(4);     F[2+i]     = i, j, Ns+j, Ns+i;
+    }
+
+    // random orientation
+    Quaternion_t q;
+    Vec3_t Axis((1.0*rand())/RAND_MAX,(1.0*rand())/RAND_MAX,(1.0*rand())/RAND_MAX);
+    NormalizeRotation (2.0*M_PI*rand()/RAND_MAX,Axis,q);
+    for (size_t i=0;i<V.Size();i++)
+    {
+        Vec3_t t;
+        Rotation (V[i],q,t);
+        V[i] = t+X;
+    }
+    Dom.Particles.Push (new DEM::Particle(Tag,V,E,F,OrthoSys::O,OrthoSys::O,R,rho));
+    Dom.Particles[Dom.Particles.Size()-1]->poly_calc_props(V);
+}
+
+// Contact list of the full feature loop, as built without culling
+template<typename FeatureA_T, typename FeatureB_T>
+void AllPairs (FeatureA_T & A, FeatureB_T & B, double R1, double R2, double alpha, DEM::ListContacts_t & L)
+{
+    L.Resize(0);
+    for (size_t i=0;i<A.Size();i++)
+    for (size_t j=0;j<B.Size();j++)
+    {
+        if (!DEM::Overlap((*A[i]),(*B[j]),R1+alpha,R2+alpha)) continue;
+        if (DEM::Distance((*A[i]),(*B[j]))<=R1+R2+2*alpha) L.Push(std::make_pair((int)i,(int)j));
+    }
+}
+
+void CheckList (DEM::ListContacts_t const & L, DEM::ListContacts_t const & Lref, size_t n, char const * Name)
+{
+    if (L.Size()!=Lref.Size()) throw new Fatal("test_features: pair %zd keeps %zd %s contacts instead of %zd",n,L.Size(),Name,Lref.Size());
+    for (size_t k=0;k<L.Size();k++)
+    {
+        if (!(L[k]==Lref[k])) throw new Fatal("test_features: pair %zd has a different %s contact at position %zd",n,Name,k);
+    }
+}
+
+int main(int argc, char **argv) try
+{
+    size_t Ns    = 24;
+    size_t Np    = 200;
+    size_t Nr    = 20;
+    double alpha = 0.05;
+    if (argc>=2) Ns = atoi(argv[1]);
+    if (argc>=3) Np = atoi(argv[2]);
+    if (argc>=4) Nr = atoi(argv[3]);
+
+    // Np isolated pairs of prisms close enough to have candidate feature contacts
+    DEM::Domain Dom;
+    srand(1);
+    for (size_t n=0;n<Np;n++)
+    {
+        Vec3_t X(10.0*n,0.0,0.0);
+        AddPrism (Dom,-1,X                     ,Ns,1.0,1.0,0.05,3.0);
+        AddPrism (Dom,-1,X+Vec3_t(1.3,0.4,0.2),Ns,1.0,1.0,0.05,3.0);
+    }
+    Dom.Initialize(1.0e-4);
+
+    Array<DEM::CInteracton*> CI(Np);
+    for (size_t n=0;n<Np;n++) CI[n] = new DEM::CInteracton(Dom.Particles[2*n],Dom.Particles[2*n+1]);
+
+    std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+    for (size_t r=0;r<Nr;r++)
+    for (size_t n=0;n<Np;n++) CI[n]->UpdateContacts(alpha);
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    for (size_t r=0;r<Nr;r++)
+    for (size_t n=0;n<Np;n++) CI[n]->CalcForce(1.0e-4);
+    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    double Tu = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/(Nr*Np);
+    double Tf = std::chrono::duration_cast<std::chrono::duration<double> >(t2-t1).count()/(Nr*Np);
+
+    // All feature combinations against the ones kept in the contact lists
+    size_t Nall  = 0;
+    size_t Nkept = 0;
+    for (size_t n=0;n<Np;n++)
+    {
+        DEM::Particle * P1 = CI[n]->P1;
+        DEM::Particle * P2 = CI[n]->P2;
+        Nall  += P1->Edges.Size()*P2->Edges.Size()+P1->Verts.Size()*P2->Faces.Size()+P1->Faces.Size()*P2->Verts.Size();
+        Nkept += CI[n]->Lee.Size()+CI[n]->Lvf.Size()+CI[n]->Lfv.Size();
+
+        // The culled lists must be the ones of the full loop, in the same order
+        DEM::ListContacts_t Lref;
+        AllPairs (P1->Edges,P2->Edges,P1->Props.R,P2->Props.R,alpha,Lref); CheckList (CI[n]->Lee,Lref,n,"edge-edge");
+        AllPairs (P1->Verts,P2->Faces,P1->Props.R,P2->Props.R,alpha,Lref); CheckList (CI[n]->Lvf,Lref,n,"vertex-face");
+        AllPairs (P1->Faces,P2->Verts,P1->Props.R,P2->Props.R,alpha,Lref); CheckList (CI[n]->Lfv,Lref,n,"face-vertex");
+    }
+    if (Nkept==0) throw new Fatal("test_features: no feature pair is in contact, the check is empty");
+
+    printf("\n%s--- Feature pairs of %zd-sided prisms, %zd particle pairs, %zd repetitions ---%s\n",TERM_CLR1,Ns,Np,Nr,TERM_RST);
+    printf("%s  feature pairs per particle pair: all = %zd  in contact lists = %g%s\n",TERM_CLR2,Nall/Np,(1.0*Nkept)/Np,TERM_RST);
+    printf("%s  UpdateContacts = %.4e s  CalcForce = %.4e s  per particle pair%s\n",TERM_CLR2,Tu,Tf,TERM_RST);
+
+    for (size_t n=0;n<Np;n++) delete CI[n];
+}
+MECHSYS_CATCH
@@ -0,0 +1,99 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Periodic images: a triply periodic gas of spheres and cubes solved twice, the second time with every
+// particle shifted through the boundaries. Both runs and the total momentum must agree
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 6;
+    size_t Nt    = 2000;
+    double dt    = 1.0e-4;
+    double Tol   = 1.0e-6;   // tolerance of the velocity difference and of the momentum change
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    double a = 1.2;        // spacing of the particles
+    double L = n*a;        // side of the periodic box
+    Vec3_t Off[2] = {Vec3_t(0.0,0.0,0.0),Vec3_t(0.37*L,0.61*L,0.13*L)};
+    Array<Vec3_t> V[2];
+    Vec3_t        P0[2];
+    Vec3_t        P [2];
+    double        Tstep[2];
+    size_t        Nint[2];
+    for (size_t m=0;m<2;m++)
+    {
+        DEM::Domain Dom;
+        srand(1);
+        for (size_t i=0;i<n;i++)
+        for (size_t j=0;j<n;j++)
+        for (size_t k=0;k<n;k++)
+        {
+            Vec3_t X = Vec3_t(a*i,a*j,a*k)+Off[m];
+            for (size_t d=0;d<3;d++) if (X(d)>=L-0.5*a) X(d) -= L;
+            if ((i+j+k)%3==0) Dom.AddCube  (-1,X,0.05,0.6,3.0);
+            else              Dom.AddSphere(-1,X,0.45,3.0);
+            Dom.Particles[Dom.Particles.Size()-1]->v = 1.0*(rand()%11-5.0),1.0*(rand()%11-5.0),1.0*(rand()%11-5.0);
+        }
+        Dom.Xmin = Dom.Ymin = Dom.Zmin = -0.5*a;
+        Dom.Xmax = Dom.Ymax = Dom.Zmax = L-0.5*a;
+        Dom.Alpha = 0.05;
+        P0[m] = OrthoSys::O;
+        for (size_t i=0;i<Dom.Particles.Size();i++) P0[m] += Dom.Particles[i]->Props.m*Dom.Particles[i]->v;
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt*dt,dt,2*Nt*dt,NULL,NULL,NULL,0,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Tstep[m] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+
+        V[m].Resize(Dom.Particles.Size());
+        P[m] = OrthoSys::O;
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            V[m][i] = Dom.Particles[i]->v;
+            P[m]   += Dom.Particles[i]->Props.m*Dom.Particles[i]->v;
+        }
+        Nint[m] = Dom.Interactons.Size();
+    }
+
+    double Dv = 0.0;
+    for (size_t i=0;i<V[0].Size();i++) Dv = std::max(Dv,norm(V[1][i]-V[0][i]));
+
+    printf("\n%s--- Triply periodic gas %zd particles, %zd steps, %zd threads ---%s\n",TERM_CLR1,V[0].Size(),Nt,Nproc,TERM_RST);
+    for (size_t m=0;m<2;m++)
+    {
+        printf("%s  offset = %6.3f %6.3f %6.3f  time/step = %.4e s  interactons = %5zd  momentum change = %.3e%s\n",TERM_CLR2,Off[m](0),Off[m](1),Off[m](2),Tstep[m],Nint[m],norm(P[m]-P0[m]),TERM_RST);
+    }
+    printf("%s  max velocity difference between the two runs = %.3e%s\n",TERM_CLR2,Dv,TERM_RST);
+    if (Dv>Tol) throw new Fatal("test_images: shifting the particles through the boundaries changes the velocities by %g",Dv);
+    for (size_t m=0;m<2;m++)
+    {
+        if (norm(P[m]-P0[m])>Tol) throw new Fatal("test_images: the total momentum changes by %g",norm(P[m]-P0[m]));
+    }
+}
+MECHSYS_CATCH
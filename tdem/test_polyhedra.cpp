@@ -0,0 +1,102 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Polyhedra benchmark: a dense pack of frictional cubes shaken under gravity inside a fixed box
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+// Check that Order sorts Keys without repetitions and that every bound slot holds its feature pair
+void CheckHistory (DEM::FrictionHistory const & H, DEM::ListContacts_t const & L)
+{
+    if (H.Order.Size()!=H.Keys.Size()||H.Disp.Size()!=H.Keys.Size()) throw new Fatal("test_polyhedra: Keys, Disp and Order differ in size");
+    for (size_t n=1;n<H.Order.Size();n++)
+    {
+        if (!(H.Keys[H.Order[n-1]]<H.Keys[H.Order[n]])) throw new Fatal("test_polyhedra: the friction history is not sorted or has a repeated pair");
+    }
+    for (size_t k=0;k<H.Slot.Size()&&k<L.Size();k++)
+    {
+        bool found = false;
+        for (size_t n=0;n<H.Keys.Size();n++) if (H.Keys[n]==L[k]) found = true;
+        if (H.Slot[k]>=0&&!(H.Keys[H.Slot[k]]==L[k])) throw new Fatal("test_polyhedra: slot %zd points to the wrong feature pair",k);
+        if (H.Slot[k]<0&&found)                        throw new Fatal("test_polyhedra: slot %zd missed a stored feature pair",k);
+    }
+}
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 10;
+    size_t Nt    = 2000;
+    double dt    = 1.0e-4;
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    DEM::Domain Dom;
+    srand(1);
+    for (size_t i=0;i<n;i++)
+    for (size_t j=0;j<n;j++)
+    for (size_t k=0;k<n;k++)
+    {
+        // Slightly tilted cubes with a small gap so edges, vertices and faces keep touching
+        Vec3_t X(0.95*i,0.95*j,0.95*k);
+        Vec3_t * Axis = (i+j+k)%2==0 ? &OrthoSys::e0 : &OrthoSys::e1;
+        Dom.AddCube(-1,X,0.05,0.8,3.0,0.05*rand()/RAND_MAX,Axis);
+        Dom.Particles[Dom.Particles.Size()-1]->v = 0.2*(rand()%11-5.0),0.2*(rand()%11-5.0),0.2*(rand()%11-5.0);
+    }
+    Dom.GenBoundingBox(-2,0.1,1.1);
+    for (size_t i=0;i<Dom.Particles.Size();i++)
+    {
+        if (Dom.Particles[i]->Tag<=-2) Dom.Particles[i]->FixVeloc();
+        else                           Dom.Particles[i]->Ff = 0.0,0.0,-9.8*Dom.Particles[i]->Props.m;
+    }
+    Dict B;
+    B.Set(-1,"Kn Kt Mu",1.0e5,5.0e4,0.4);
+    Dom.SetProps(B);
+    Dom.Alpha = 0.05;
+
+    std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+    Dom.Solve(Nt*dt,dt,2*Nt*dt,NULL,NULL,NULL,0,Nproc);
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    double Tstep = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+
+    // Feature contacts and stored friction displacements of the contact interactons
+    size_t Nc = 0;
+    size_t Nh = 0;
+    for (size_t i=0;i<Dom.CInteractons.Size();i++)
+    {
+        DEM::CInteracton * I = Dom.CInteractons[i];
+        Nc += I->Nc;
+        Nh += I->Fdee.Size()+I->Fdvf.Size()+I->Fdfv.Size()+I->Fdvt.Size()+I->Fdtv.Size()+I->Fdvc.Size()+I->Fdcv.Size();
+        CheckHistory(I->Fdee,I->Lee);
+        CheckHistory(I->Fdvf,I->Lvf);
+        CheckHistory(I->Fdfv,I->Lfv);
+    }
+    double Zc = 0.0;
+    for (size_t i=0;i<Dom.Particles.Size();i++) Zc += Dom.Particles[i]->x(2);
+
+    printf("\n%s--- Polyhedra benchmark %zd particles, %zd interactons, %zd steps, %zd threads ---%s\n",TERM_CLR1,Dom.Particles.Size(),Dom.CInteractons.Size(),Nt,Nproc,TERM_RST);
+    printf("%s  time/step = %.4e s  feature contacts = %zd  stored friction pairs = %zd  sum z = %.10e%s\n",TERM_CLR2,Tstep,Nc,Nh,Zc,TERM_RST);
+}
+MECHSYS_CATCH
@@ -0,0 +1,104 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Reordering benchmark: a pack of spheres and cubes inserted in random order, solved with and without Morton reordering
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 16;
+    size_t Nt    = 1000;
+    double dt    = 1.0e-4;
+    double Tol   = 1.0e-10;  // tolerance of max|dX| against the insertion order, only the summation order changes
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    // Lattice sites visited in random order so the insertion order says nothing about the neighbours
+    Array<size_t> Site(n*n*n);
+    for (size_t i=0;i<Site.Size();i++) Site[i] = i;
+    srand(1);
+    for (size_t i=Site.Size()-1;i>0;i--) std::swap(Site[i],Site[rand()%(i+1)]);
+
+    double Tstep[2];
+    size_t Nrebuild[2];
+    Array<Vec3_t> Xref;
+    double Dmax = 0.0;
+    size_t Npar = 0;
+
+    for (size_t m=0;m<2;m++)
+    {
+        DEM::Domain Dom;
+        srand(2);
+        for (size_t s=0;s<Site.Size();s++)
+        {
+            size_t i = Site[s]%n, j = (Site[s]/n)%n, k = Site[s]/(n*n);
+            Vec3_t X(1.0*i,1.0*j,1.0*k);
+            if ((i+j+k)%5==0) Dom.AddCube  (-1,X,0.05,0.6,3.0);
+            else              Dom.AddSphere(-1,X,0.5,3.0);
+            Dom.Particles[Dom.Particles.Size()-1]->v = 0.2*(rand()%11-5.0),0.2*(rand()%11-5.0),0.2*(rand()%11-5.0);
+        }
+        Dom.GenBoundingBox(-2,0.1,1.1);
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            if (Dom.Particles[i]->Tag<=-2) Dom.Particles[i]->FixVeloc();
+            else                           Dom.Particles[i]->Ff = 0.0,0.0,-9.8*Dom.Particles[i]->Props.m;
+        }
+        Dom.Alpha         = 0.05;
+        Dom.MostlySpheres = true;
+        Dom.ReorderEvery  = (m==1) ? 1 : 0;
+        Array<DEM::Particle*> Held(Dom.Particles.Size());
+        for (size_t i=0;i<Dom.Particles.Size();i++) Held[i] = Dom.Particles[i];
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt*dt,dt,2*Nt*dt,NULL,NULL,NULL,0,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Tstep[m]    = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+        Nrebuild[m] = Dom.Nrebuild;
+
+        // Pointers held before the run must still point at the same particles
+        for (size_t i=0;i<Held.Size();i++)
+        {
+            if (Held[i]->Id!=int(i)||Dom.Particles[Held[i]->Index]!=Held[i]) throw new Fatal("test_reorder: the reordering moved particle %zd",i);
+        }
+
+        // The particles are compared through their Id since the reordered run changes their indices
+        if (m==0) Xref.Resize(Dom.Particles.Size());
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            DEM::Particle * P = Dom.Particles[i];
+            if (m==0) Xref[P->Id] = P->x;
+            else      Dmax = std::max(Dmax,norm(P->x-Xref[P->Id]));
+        }
+        Npar = Dom.Particles.Size();
+    }
+
+    printf("\n%s--- Reordering benchmark %zd particles, %zd steps, %zd threads ---%s\n",TERM_CLR1,Npar,Nt,Nproc,TERM_RST);
+    printf("%s  insertion order: time/step = %.4e s  rebuilds = %zd%s\n",TERM_CLR2,Tstep[0],Nrebuild[0],TERM_RST);
+    printf("%s  Morton order   : time/step = %.4e s  rebuilds = %zd  speedup = %7.3f  max|dX| = %.3e%s\n",TERM_CLR2,Tstep[1],Nrebuild[1],Tstep[0]/Tstep[1],Dmax,TERM_RST);
+    if (Dmax>Tol) throw new Fatal("test_reorder: the Morton order departs from the insertion order by max|dX| = %g",Dmax);
+}
+MECHSYS_CATCH
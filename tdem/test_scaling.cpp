@@ -0,0 +1,97 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Strong scaling benchmark: the same dense packing of spheres and cubes solved with 1,2,4,... threads
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nmax = 64;
+    size_t n    = 20;
+    size_t Nt   = 200;
+    double dt   = 1.0e-4;
+    double Tol  = 1.0e-10;  // tolerance of max|dX| against the single thread run
+    if (argc>=2) Nmax = atoi(argv[1]);
+    if (argc>=3) n    = atoi(argv[2]);
+    if (argc>=4) Nt   = atoi(argv[3]);
+
+    Array<size_t> Nthreads;
+    for (size_t Np=1;Np<=Nmax;Np*=2) Nthreads.Push(Np);
+    Array<double> Tstep(Nthreads.Size());
+    Array<double> Dmax (Nthreads.Size());
+    Array<Vec3_t> Xref;
+    size_t Npar = 0;
+    size_t Nint = 0;
+
+    for (size_t m=0;m<Nthreads.Size();m++)
+    {
+        // Same packing for every run: touching grains with random velocities inside a fixed box
+        DEM::Domain Dom;
+        srand(1);
+        for (size_t i=0;i<n;i++)
+        for (size_t j=0;j<n;j++)
+        for (size_t k=0;k<n;k++)
+        {
+            Vec3_t X(1.0*i,1.0*j,1.0*k);
+            if ((i+j+k)%5==0) Dom.AddCube  (-1,X,0.05,0.6,3.0);
+            else              Dom.AddSphere(-1,X,0.5,3.0);
+            Dom.Particles[Dom.Particles.Size()-1]->v = 0.2*(rand()%11-5.0),0.2*(rand()%11-5.0),0.2*(rand()%11-5.0);
+        }
+        Dom.GenBoundingBox(-2,0.1,1.1);
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            if (Dom.Particles[i]->Tag<=-2) Dom.Particles[i]->FixVeloc();
+        }
+        Dom.Alpha = 0.05;
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt*dt,dt,2*Nt*dt,NULL,NULL,NULL,0,Nthreads[m]);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Tstep[m] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+
+        // The gathered forces do not depend on the number of threads up to the summation order
+        Dmax[m] = 0.0;
+        if (m==0) Xref.Resize(Dom.Particles.Size());
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            if (m==0) Xref[i] = Dom.Particles[i]->x;
+            else      Dmax[m] = std::max(Dmax[m],norm(Dom.Particles[i]->x-Xref[i]));
+        }
+        Npar = Dom.Particles.Size();
+        Nint = Dom.Interactons.Size();
+    }
+
+    printf("\n%s--- DEM strong scaling %zd particles, %zd interactons, %zd steps ---%s\n",TERM_CLR1,Npar,Nint,Nt,TERM_RST);
+    for (size_t m=0;m<Nthreads.Size();m++)
+    {
+        double S = Tstep[0]/Tstep[m];
+        printf("%s  Threads = %3zd  time/step = %.4e s  speedup = %7.3f  efficiency = %6.3f  max|dX| = %.3e%s\n",TERM_CLR2,Nthreads[m],Tstep[m],S,S/Nthreads[m],Dmax[m],TERM_RST);
+    }
+    for (size_t m=0;m<Nthreads.Size();m++)
+    {
+        if (Dmax[m]>Tol) throw new Fatal("test_scaling: %zd threads depart from the single thread run by max|dX| = %g",Nthreads[m],Dmax[m]);
+    }
+}
+MECHSYS_CATCH
@@ -0,0 +1,180 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Sphere benchmark: a frictional packing of spheres solved with the sphere interactons and with the MostlySpheres pair arrays.
+// The pair arrays are checked on a first step against the per pair CalcForceSphere they replace, whose mixing rules they
+// share (the sphere interactons double Kn, so their trajectories are only timed, not compared)
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+// Slightly polydisperse spheres touching their neighbours, with random velocities and spins
+void Packing (DEM::Domain & Dom, size_t n)
+{
+    srand(1);
+    for (size_t i=0;i<n;i++)
+    for (size_t j=0;j<n;j++)
+    for (size_t k=0;k<n;k++)
+    {
+        Vec3_t X(1.0*i,1.0*j,1.0*k);
+        Dom.AddSphere(-1,X,0.5+0.02*rand()/RAND_MAX,3.0);
+        Dom.Particles[Dom.Particles.Size()-1]->v = 0.2*(rand()%11-5.0),0.2*(rand()%11-5.0),0.2*(rand()%11-5.0);
+        Dom.Particles[Dom.Particles.Size()-1]->w = 0.5*(rand()%11-5.0),0.5*(rand()%11-5.0),0.5*(rand()%11-5.0);
+    }
+    Dict B;
+    B.Set(-1,"Kn Kt Gn Mu Beta Eta",1.0e5,5.0e4,-0.8,0.4,0.1,0.5);
+    Dom.SetProps(B);
+}
+
+// Forces and torques of the per pair CalcForceSphere on a first step, when the friction and rolling displacements start from zero
+void RefForces (DEM::Domain & Dom, double Dt, Array<Vec3_t> & F, Array<Vec3_t> & T)
+{
+    size_t Np = Dom.Particles.Size();
+    F.Resize(Np);
+    T.Resize(Np);
+    for (size_t i=0;i<Np;i++) F[i] = T[i] = OrthoSys::O;
+    for (size_t i=0;i<Np;i++)
+    for (size_t j=i+1;j<Np;j++)
+    {
+        DEM::Particle * P1 = Dom.Particles[i];
+        DEM::Particle * P2 = Dom.Particles[j];
+        double dist  = norm(P1->x-P2->x);
+        double delta = P1->Props.R+P2->Props.R-dist;
+        if (!(delta>0)) continue;
+
+        Vec3_t n = (P2->x-P1->x)/dist;
+        Vec3_t x = P1->x+n*((P1->Props.R*P1->Props.R-P2->Props.R*P2->Props.R+dist*dist)/(2*dist));
+        Vec3_t t1,t2,x1,x2;
+        Rotation(P1->w,P1->Q,t1);
+        Rotation(P2->w,P2->Q,t2);
+        x1 = x-P1->x;
+        x2 = x-P2->x;
+        Vec3_t vrel = -((P2->v-P1->v)+cross(t2,x2)-cross(t1,x1));
+        Vec3_t vt   = vrel-dot(n,vrel)*n;
+
+        double Kn   = ReducedValue(P1->Props.Kn,P2->Props.Kn);
+        double Kt   = 2*ReducedValue(P1->Props.Kt,P2->Props.Kt);
+        double me   = ReducedValue(P1->Props.m ,P2->Props.m );
+        double Gn   = 2*ReducedValue(P1->Props.Gn,P2->Props.Gn);
+        double Gt   = 2*ReducedValue(P1->Props.Gt,P2->Props.Gt);
+        double beta = 2*ReducedValue(P1->Props.Beta,P2->Props.Beta);
+        double eta  = 2*ReducedValue(P1->Props.Eta,P2->Props.Eta);
+        double Mu   = (P1->Props.Mu>1.0e-12&&P2->Props.Mu>1.0e-12) ? std::max(P1->Props.Mu,P2->Props.Mu) : 0.0;
+        if (Gn < -0.001)
+        {
+            Gn = 2.0*sqrt((pow(log(-Gn),2.0)*(Kn/me))/(M_PI*M_PI+pow(log(-Gn),2.0)));
+            Gt = 0.0;
+        }
+        Gn *= me;
+        Gt *= me;
+
+        Vec3_t Fn  = Kn*delta*n;
+        Vec3_t Fr  = vt*Dt;
+        Fr -= dot(Fr,n)*n;
+        if (norm(Fr)>Mu*norm(Fn)/Kt) Fr = Mu*norm(Fn)/Kt*Fr/norm(Fr);
+        Vec3_t Fc  = Fn + Kt*Fr + Gn*dot(n,vrel)*n + Gt*vt;
+
+        Vec3_t Normal = Fn/norm(Fn);
+        Vec3_t Rl     = P1->Props.R*P2->Props.R*cross(Vec3_t(t1-t2),Normal)/(P1->Props.R+P2->Props.R)*Dt;
+        Rl -= dot(Rl,Normal)*Normal;
+        double Kr = beta*Kt;
+        if (norm(Rl)>eta*Mu*norm(Fn)/Kr) Rl = eta*Mu*norm(Fn)/Kr*Rl/norm(Rl);
+        Vec3_t Ft = -Kr*Rl;
+
+        Vec3_t Tt,Tb;
+        Quaternion_t q;
+        Tt = -cross(x1,Fc) + P1->Props.R*cross(Normal,Ft);
+        Conjugate (P1->Q,q);
+        Rotation  (Tt,q,Tb);
+        F[i] -= Fc;
+        T[i] += Tb;
+        Tt = cross(x2,Fc) - P2->Props.R*cross(Normal,Ft);
+        Conjugate (P2->Q,q);
+        Rotation  (Tt,q,Tb);
+        F[j] += Fc;
+        T[j] += Tb;
+    }
+}
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 16;
+    size_t Nt    = 1000;
+    double dt    = 1.0e-4;
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    double Tstep[2];
+    size_t Npar = 0;
+    size_t Npairs = 0;
+
+    for (size_t m=0;m<2;m++)
+    {
+        // The packing inside a fixed box
+        DEM::Domain Dom;
+        Packing(Dom,n);
+        Dom.GenBoundingBox(-2,0.1,1.1);
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            if (Dom.Particles[i]->Tag<=-2) Dom.Particles[i]->FixVeloc();
+            else                           Dom.Particles[i]->Ff = 0.0,0.0,-9.8*Dom.Particles[i]->Props.m;
+        }
+        Dom.Alpha         = 0.05;
+        Dom.MostlySpheres = (m==1);
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt*dt,dt,2*Nt*dt,NULL,NULL,NULL,0,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Tstep[m] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+        Npar   = Dom.Particles.Size();
+        Npairs = Dom.SPairs.Size();
+    }
+
+    // First step of the packing without walls or gravity, where the forces only come from the sphere pairs
+    DEM::Domain Dom;
+    Packing(Dom,std::min(n,size_t(8)));
+    Dom.Alpha         = 0.05;
+    Dom.MostlySpheres = true;
+    Array<Vec3_t> Fref,Tref;
+    RefForces(Dom,dt,Fref,Tref);
+    Dom.Solve(dt,dt,2*dt,NULL,NULL,NULL,0,Nproc);
+    double Fmax = 0.0, Tmax = 0.0, dF = 0.0, dT = 0.0;
+    for (size_t i=0;i<Dom.Particles.Size();i++)
+    {
+        Fmax = std::max(Fmax,norm(Fref[i]));
+        Tmax = std::max(Tmax,norm(Tref[i]));
+        dF   = std::max(dF,norm(Dom.Particles[i]->F-Fref[i]));
+        dT   = std::max(dT,norm(Dom.Particles[i]->T-Tref[i]));
+    }
+    dF /= Fmax;
+    dT /= Tmax;
+
+    printf("\n%s--- Sphere benchmark %zd particles, %zd sphere pairs, %zd steps, %zd threads ---%s\n",TERM_CLR1,Npar,Npairs,Nt,Nproc,TERM_RST);
+    printf("%s  interactons: time/step = %.4e s%s\n",TERM_CLR2,Tstep[0],TERM_RST);
+    printf("%s  pair arrays: time/step = %.4e s  speedup = %7.3f%s\n",TERM_CLR2,Tstep[1],Tstep[0]/Tstep[1],TERM_RST);
+    printf("%s  against CalcForceSphere: max|dF|/max|F| = %.3e  max|dT|/max|T| = %.3e%s\n",TERM_CLR2,dF,dT,TERM_RST);
+    if (dF>1.0e-10||dT>1.0e-10) throw new Fatal("test_spheres: the pair arrays differ from CalcForceSphere, max|dF|/max|F| = %g  max|dT|/max|T| = %g",dF,dT);
+}
+MECHSYS_CATCH
@@ -0,0 +1,102 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Contact list benchmark: the same loose gas of cubes solved with full rebuilds, incremental refreshes and a tuned Verlet distance
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 8;
+    size_t Nt    = 2000;
+    double dt    = 1.0e-4;
+    double Tol   = 1.0e-8;   // tolerance of max|dX| against the full rebuilds
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    const char * Names[3] = {"full rebuilds","incremental","incremental + tuned Alpha"};
+    double Tstep[3];
+    double Zc   [3];
+    size_t Nreb [3];
+    size_t Nref [3];
+    double Alpha[3];
+    double Dmax [3];
+    Array<Vec3_t> Xref;
+    size_t Npar = 0;
+    for (size_t m=0;m<3;m++)
+    {
+        // Cubes spread out with random velocities so only a few of them cross the skin at a time
+        DEM::Domain Dom;
+        srand(1);
+        for (size_t i=0;i<n;i++)
+        for (size_t j=0;j<n;j++)
+        for (size_t k=0;k<n;k++)
+        {
+            Vec3_t X(2.0*i,2.0*j,2.0*k);
+            Dom.AddCube(-1,X,0.05,0.8,3.0,M_PI*rand()/RAND_MAX,&OrthoSys::e2);
+            Dom.Particles[Dom.Particles.Size()-1]->v = 0.5*(rand()%11-5.0),0.5*(rand()%11-5.0),0.5*(rand()%11-5.0);
+        }
+        Dom.GenBoundingBox(-2,0.1,1.1);
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            if (Dom.Particles[i]->Tag<=-2) Dom.Particles[i]->FixVeloc();
+        }
+        Dom.Alpha       = 0.05;
+        Dom.Incremental = (m>0);
+        Dom.AutoAlpha   = (m>1);
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt*dt,dt,2*Nt*dt,NULL,NULL,NULL,0,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Tstep[m] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+
+        // Refreshing or widening the lists must find the same contacts as the full rebuilds
+        Zc  [m] = 0.0;
+        Dmax[m] = 0.0;
+        if (m==0) Xref.Resize(Dom.Particles.Size());
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            Zc[m] += Dom.Particles[i]->x(2);
+            if (m==0) Xref[i] = Dom.Particles[i]->x;
+            else      Dmax[m] = std::max(Dmax[m],norm(Dom.Particles[i]->x-Xref[i]));
+        }
+        Nreb [m] = Dom.Nrebuild;
+        Nref [m] = Dom.Nrefresh;
+        Alpha[m] = Dom.Alpha;
+        Npar     = Dom.Particles.Size();
+    }
+
+    printf("\n%s--- Contact lists %zd particles, %zd steps, %zd threads ---%s\n",TERM_CLR1,Npar,Nt,Nproc,TERM_RST);
+    for (size_t m=0;m<3;m++)
+    {
+        printf("%s  %-26s time/step = %.4e s  rebuilds = %5zd  refreshes = %5zd  Alpha = %g  sum z = %.10e  max|dX| = %.3e%s\n",TERM_CLR2,Names[m],Tstep[m],Nreb[m],Nref[m],Alpha[m],Zc[m],Dmax[m],TERM_RST);
+    }
+    for (size_t m=1;m<3;m++)
+    {
+        if (Dmax[m]>Tol) throw new Fatal("test_verlet: %s departs from the full rebuilds by max|dX| = %g",Names[m],Dmax[m]);
+    }
+}
+MECHSYS_CATCH
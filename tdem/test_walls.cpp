@@ -0,0 +1,96 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Curved walls: spheres around the inner side of a fixed drum (AddCylinder) and next to a fixed torus.
+// Every free/fixed pair within the reach of the contact search must be among the candidate pairs
+// of the linked cells, whatever the side of the curved feature the sphere lies on
+
+//STD
+#include<iostream>
+
+// MechSys
+#include <mechsys/dem/domain.h>
+#include <mechsys/util/fatal.h>
+
+// Distance from X to the closest feature of the particle
+double FeatureDistance (DEM::Particle * Pa, Vec3_t const & X)
+{
+    double d = norm(X-*Pa->Verts[0]);
+    for (size_t i=1;i<Pa->Verts    .Size();i++) d = std::min(d,DEM::Distance(X,*Pa->Verts    [i]));
+    for (size_t i=0;i<Pa->Edges    .Size();i++) d = std::min(d,DEM::Distance(X,*Pa->Edges    [i]));
+    for (size_t i=0;i<Pa->Faces    .Size();i++) d = std::min(d,DEM::Distance(X,*Pa->Faces    [i]));
+    for (size_t i=0;i<Pa->Tori     .Size();i++) d = std::min(d,DEM::Distance(X,*Pa->Tori     [i]));
+    for (size_t i=0;i<Pa->Cylinders.Size();i++) d = std::min(d,DEM::Distance(X,*Pa->Cylinders[i]));
+    return d;
+}
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    if (argc>=2) Nproc = atoi(argv[1]);
+
+    DEM::Domain Dom;
+    Dom.AddCylinder(-2,Vec3_t(0.0,0.0,-1.0),5.0,Vec3_t(0.0,0.0,1.0),5.0,0.1,1.0);
+    Dom.AddTorus   (-3,Vec3_t(0.0,0.0,4.0),Vec3_t(0.0,0.0,1.0),3.0,0.1,1.0);
+    for (size_t i=0;i<Dom.Particles.Size();i++) Dom.Particles[i]->FixVeloc();
+
+    // Spheres along both directions of every axis of the drum section and next to the torus
+    double r = 4.6;
+    Dom.AddSphere(-1,Vec3_t( r  , 0.0,0.0),0.3,1.0);
+    Dom.AddSphere(-1,Vec3_t(-r  , 0.0,0.0),0.3,1.0);
+    Dom.AddSphere(-1,Vec3_t( 0.0, r  ,0.0),0.3,1.0);
+    Dom.AddSphere(-1,Vec3_t( 0.0,-r  ,0.0),0.3,1.0);
+    Dom.AddSphere(-1,Vec3_t( 3.0, 0.0,4.5),0.3,1.0);
+    Dom.AddSphere(-1,Vec3_t(-3.0, 0.0,4.5),0.3,1.0);
+    Dom.AddSphere(-1,Vec3_t( 0.0,-3.0,4.5),0.3,1.0);
+    Dom.Alpha = 0.05;
+
+    size_t Np = Dom.Particles.Size();
+    double dt = 1.0e-5;
+    Dom.Solve(dt,dt,2.0*dt,NULL,NULL,NULL,0,Nproc);
+
+    // Free/fixed pairs close enough to touch, against the candidates of the linked cells
+    size_t Nexp  = 0;
+    size_t Nmiss = 0;
+    for (size_t i=0;i<Np;i++)
+    for (size_t j=i+1;j<Np;j++)
+    {
+        DEM::Particle * P1 = Dom.Particles[i];
+        DEM::Particle * P2 = Dom.Particles[j];
+        if (P1->IsFree()==P2->IsFree()) continue;
+        DEM::Particle * Pf = P1->IsFree() ? P1 : P2;
+        DEM::Particle * Pw = P1->IsFree() ? P2 : P1;
+        if (FeatureDistance(Pw,Pf->x)>Pf->Dmax+Pw->Props.R+2.0*Dom.Alpha) continue;
+        Nexp++;
+        bool found = false;
+        for (size_t n=0;n<Dom.ListPosPairs.Size();n++)
+        {
+            if (Dom.ListPosPairs[n].first==i&&Dom.ListPosPairs[n].second==j) found = true;
+        }
+        if (!found)
+        {
+            Nmiss++;
+            printf("%s  missing pair %zd %zd%s\n",TERM_CLR1,i,j,TERM_RST);
+        }
+    }
+
+    printf("\n%s--- Curved walls %zd particles ---%s\n",TERM_CLR1,Np,TERM_RST);
+    printf("%s  candidate pairs = %zd  pairs in reach = %zd  missing = %zd%s\n",TERM_CLR2,Dom.ListPosPairs.Size(),Nexp,Nmiss,TERM_RST);
+    if (Nmiss>0) throw new Fatal("test_walls: %zd pairs in reach of a curved wall are not candidates of the contact search",Nmiss);
+}
+MECHSYS_CATCH
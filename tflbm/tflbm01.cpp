@@ -145,19 +145,22 @@ void Setup (FLBM::Domain & dom, void * UD)
     #endif
 	for (size_t i=0; i<dom.Ndim(1); ++i)
 	{
-        double * f = dom.F[0][0][i][0];
+        size_t   n = dom.Idx(0,i,0);
+        double   f[9];
+        for (size_t k=0;k<dom.Nneigh;k++) f[k] = dom.F[0][k*dom.Nstride+n];
 		double rho = (f[0]+f[2]+f[4] + 2.0*(f[3]+f[6]+f[7]))/(1.0-dat.Vel[i]);
 		f[1] = f[3] + (2.0/3.0)*rho*dat.Vel[i];
 		f[5] = f[7] + (1.0/6.0)*rho*dat.Vel[i] - 0.5*(f[2]-f[4]);
 		f[8] = f[6] + (1.0/6.0)*rho*dat.Vel[i] + 0.5*(f[2]-f[4]);
-        dom.Vel[0][0][i][0] = OrthoSys::O;
-        dom.Rho[0][0][i][0] = 0.0;
+        dom.Vel[0][n] = OrthoSys::O;
+        dom.Rho[0][n] = 0.0;
         for (size_t k=0;k<dom.Nneigh;k++)
         {
-            dom.Rho[0][0][i][0] +=  dom.F[0][0][i][0][k];
-            dom.Vel[0][0][i][0] +=  dom.F[0][0][i][0][k]*dom.C[k];
+            dom.F  [0][k*dom.Nstride+n]  = f[k];
+            dom.Rho[0][n]              += f[k];
+            dom.Vel[0][n]              += f[k]*dom.C[k];
         }
-        dom.Vel[0][0][i][0] /= dom.Rho[0][0][i][0];
+        dom.Vel[0][n] /= dom.Rho[0][n];
 	}
 
 	// Cells with prescribed density
@@ -166,19 +169,22 @@ void Setup (FLBM::Domain & dom, void * UD)
     #endif
 	for (size_t i=0; i<dom.Ndim(1); ++i)
 	{
-        double * f = dom.F[0][dom.Ndim(0)-1][i][0];
+        size_t   n = dom.Idx(dom.Ndim(0)-1,i,0);
+        double   f[9];
+        for (size_t k=0;k<dom.Nneigh;k++) f[k] = dom.F[0][k*dom.Nstride+n];
 		double vx = -1.0 + (f[0]+f[2]+f[4] + 2.0*(f[1]+f[5]+f[8]))/dat.rho;
 		f[3] = f[1] - (2.0/3.0)*dat.rho*vx; 
 		f[7] = f[5] - (1.0/6.0)*dat.rho*vx + 0.5*(f[2]-f[4]);
 		f[6] = f[8] - (1.0/6.0)*dat.rho*vx - 0.5*(f[2]-f[4]);
-        dom.Vel[0][dom.Ndim(0)-1][i][0] = OrthoSys::O;
-        dom.Rho[0][dom.Ndim(0)-1][i][0] = 0.0;
+        dom.Vel[0][n] = OrthoSys::O;
+        dom.Rho[0][n] = 0.0;
         for (size_t k=0;k<dom.Nneigh;k++)
         {
-            dom.Rho[0][dom.Ndim(0)-1][i][0] +=  dom.F[0][dom.Ndim(0)-1][i][0][k];
-            dom.Vel[0][dom.Ndim(0)-1][i][0] +=  dom.F[0][dom.Ndim(0)-1][i][0][k]*dom.C[k];
+            dom.F  [0][k*dom.Nstride+n]  = f[k];
+            dom.Rho[0][n]              += f[k];
+            dom.Vel[0][n]              += f[k]*dom.C[k];
         }
-        dom.Vel[0][dom.Ndim(0)-1][i][0] /= dom.Rho[0][dom.Ndim(0)-1][i][0];
+        dom.Vel[0][n] /= dom.Rho[0][n];
 	}
     #endif // USE_OCL
 }
@@ -220,15 +226,15 @@ int main(int argc, char **argv) try
     {
         if ((i-obsX)*(i-obsX)+(j-obsY)*(j-obsY)<radius*radius)
         {
-            Dom.IsSolid[0][i][j][0] = true;
+            Dom.IsSolid[0][Dom.Idx(i,j,0)] = true;
         }
     }
 
     //Assigning solid boundaries at top and bottom
     for (size_t i=0;i<nx;i++)
     {
-        Dom.IsSolid[0][i][0][0]    = true;
-        Dom.IsSolid[0][i][ny-1][0] = true;
+        Dom.IsSolid[0][Dom.Idx(i,0,0)]    = true;
+        Dom.IsSolid[0][Dom.Idx(i,ny-1,0)] = true;
     }
 
 
@@ -105,11 +105,9 @@ void Setup(FLBM::Domain & dom, void * UD)
     #ifdef USE_OMP
     #pragma omp parallel for schedule(static) num_threads(dom.Nproc)
     #endif
-    for (size_t ix=0;ix<dom.Ndim(0);ix++)
-    for (size_t iy=0;iy<dom.Ndim(1);iy++)
-    for (size_t iz=0;iz<dom.Ndim(2);iz++)
+    for (size_t n=0;n<dom.Ncells;n++)
     {
-        dom.BForce[il][ix][iy][iz] = dom.Rho[il][ix][iy][iz]*dat.g;
+        dom.BForce[il][n] = dom.Rho[il][n]*dat.g;
     }
 
     #endif // USE_OCL
@@ -136,10 +134,10 @@ int main(int argc, char **argv) try
     //dat.g           = 0.0,0.0,0.0;
     for (size_t i=0;i<nx;i++)
     {
-        Dom.IsSolid[0][i][0   ][0] = true;
-        Dom.IsSolid[0][i][ny-1][0] = true;
-        Dom.IsSolid[1][i][0   ][0] = true;
-        Dom.IsSolid[1][i][ny-1][0] = true;
+        Dom.IsSolid[0][Dom.Idx(i,0,0)] = true;
+        Dom.IsSolid[0][Dom.Idx(i,ny-1,0)] = true;
+        Dom.IsSolid[1][Dom.Idx(i,0,0)] = true;
+        Dom.IsSolid[1][Dom.Idx(i,ny-1,0)] = true;
     }
 
     // Set inner drop
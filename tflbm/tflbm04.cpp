@@ -71,10 +71,10 @@ int main(int argc, char **argv) try
 
 	for (size_t i=0; i<nx; ++i)
     {
-        Dom.IsSolid[0][i][0   ][0] = true;
-        Dom.IsSolid[1][i][0   ][0] = true;
-        Dom.IsSolid[0][i][ny-1][0] = true;
-        Dom.IsSolid[1][i][ny-1][0] = true;
+        Dom.IsSolid[0][Dom.Idx(i,0,0)] = true;
+        Dom.IsSolid[1][Dom.Idx(i,0,0)] = true;
+        Dom.IsSolid[0][Dom.Idx(i,ny-1,0)] = true;
+        Dom.IsSolid[1][Dom.Idx(i,ny-1,0)] = true;
 	    for (size_t j=0; j<ny; ++j)
         {
 	    	if (pow((int)(i)-obsX,2.0) + pow((int)(j)-obsY,2.0) <= pow(radius,2.0)) // circle equation
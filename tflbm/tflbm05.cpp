@@ -147,8 +147,10 @@ void Setup (FLBM::Domain & dom, void * UD)
 	for (size_t i=0; i<dom.Ndim(1); ++i)
 	for (size_t j=0; j<dom.Ndim(2); ++j)
 	{
-        if (dom.IsSolid[0][0][i][j]) continue;
-        double * f = dom.F[0][0][i][j];
+        size_t   n = dom.Idx(0,i,j);
+        if (dom.IsSolid[0][n]) continue;
+        double   f[15];
+        for (size_t k=0;k<dom.Nneigh;k++) f[k] = dom.F[0][k*dom.Nstride+n];
         
         f[1] = 1.0/3.0*(-2*f[0]-4*f[10]-4*f[12]-4*f[14]-f[2]-2*f[3]-2*f[4]-2*f[5]-2*f[6]-4*f[8]+2*dat.rhomax);
         f[7] = 1.0/24.0*(-2*f[0]-4*f[10]-4*f[12]-4*f[14]-4*f[2] +f[3]-5*f[4]  +f[5]-5*f[6]+20*f[8]+2*dat.rhomax);
@@ -156,14 +158,15 @@ void Setup (FLBM::Domain & dom, void * UD)
         f[11]= 1.0/24.0*(-2*f[0]-4*f[10]+20*f[12]-4*f[14]-4*f[2]-5*f[3]+f[4]  +f[5]-5*f[6]-4*f[8]+2*dat.rhomax);
         f[13]= 1.0/24.0*(-2*f[0]-4*f[10]-4 *f[12]+20*f[14]-4*f[2]-5*f[3]+  f[4]-5*f[5]+f[6]-4*f[8]+2*dat.rhomax);
 
-        dom.Vel[0][0][i][j] = OrthoSys::O;
-        dom.Rho[0][0][i][j] = 0.0;
+        dom.Vel[0][n] = OrthoSys::O;
+        dom.Rho[0][n] = 0.0;
         for (size_t k=0;k<dom.Nneigh;k++)
         {
-            dom.Rho[0][0][i][j] +=  dom.F[0][0][i][j][k];
-            dom.Vel[0][0][i][j] +=  dom.F[0][0][i][j][k]*dom.C[k];
+            dom.F  [0][k*dom.Nstride+n]  = f[k];
+            dom.Rho[0][n]              += f[k];
+            dom.Vel[0][n]              += f[k]*dom.C[k];
         }
-        dom.Vel[0][0][i][j] /= dom.Rho[0][0][i][j];
+        dom.Vel[0][n] /= dom.Rho[0][n];
 	}
 
 	// Cells with prescribed density
@@ -173,8 +176,10 @@ void Setup (FLBM::Domain & dom, void * UD)
 	for (size_t i=0; i<dom.Ndim(1); ++i)
 	for (size_t j=0; j<dom.Ndim(2); ++j)
 	{
-        if (dom.IsSolid[0][dom.Ndim(0)-1][i][j]) continue;
-        double * f = dom.F[0][dom.Ndim(0)-1][i][j];
+        size_t   n = dom.Idx(dom.Ndim(0)-1,i,j);
+        if (dom.IsSolid[0][n]) continue;
+        double   f[15];
+        for (size_t k=0;k<dom.Nneigh;k++) f[k] = dom.F[0][k*dom.Nstride+n];
 
         f[2] = 1/3.0* (-2*f[0]-f[1]-2*(2*f[11]+2*f[13]+f[3]+f[4]+f[5]+f[6]+2*f[7]+2*f[9]-dat.rhomin));
         f[8] = 1/24.0*(-2*f[0] - 4*f[1] - 4*f[11] - 4*f[13] - 5*f[3] + f[4] - 5*f[5] + f[6] +20*f[7] - 4*f[9] + 2*dat.rhomin);
@@ -182,14 +187,15 @@ void Setup (FLBM::Domain & dom, void * UD)
         f[12]= 1/24.0*(-2*f[0] - 4*f[1] + 20*f[11] - 4*f[13] + f[3] - 5*f[4] - 5*f[5] + f[6] -  4*f[7] - 4*f[9] + 2*dat.rhomin);
         f[14]= 1/24.0*(-2*f[0] - 4*f[1] - 4*f[11] + 20*f[13] + f[3] - 5*f[4] + f[5] - 5*f[6] -  4*f[7] - 4*f[9] + 2*dat.rhomin);
         
-        dom.Vel[0][dom.Ndim(0)-1][i][j] = OrthoSys::O;
-        dom.Rho[0][dom.Ndim(0)-1][i][j] = 0.0;
+        dom.Vel[0][n] = OrthoSys::O;
+        dom.Rho[0][n] = 0.0;
         for (size_t k=0;k<dom.Nneigh;k++)
         {
-            dom.Rho[0][dom.Ndim(0)-1][i][j] +=  dom.F[0][dom.Ndim(0)-1][i][j][k];
-            dom.Vel[0][dom.Ndim(0)-1][i][j] +=  dom.F[0][dom.Ndim(0)-1][i][j][k]*dom.C[k];
+            dom.F  [0][k*dom.Nstride+n]  = f[k];
+            dom.Rho[0][n]              += f[k];
+            dom.Vel[0][n]              += f[k]*dom.C[k];
         }
-        dom.Vel[0][dom.Ndim(0)-1][i][j] /= dom.Rho[0][dom.Ndim(0)-1][i][j];
+        dom.Vel[0][n] /= dom.Rho[0][n];
 	}
     #endif // USE_OCL
 }
@@ -208,7 +214,7 @@ void Report (FLBM::Domain & dom, void * UD)
     double vave = 0.0;
     for (size_t k=1;k<dom.Ndim(2)-1;k++)
     {
-        vave += dom.Vel[0][dom.Ndim(0)/2][dom.Ndim(1)/2][k](0);
+        vave += dom.Vel[0][dom.Idx(dom.Ndim(0)/2,dom.Ndim(1)/2,k)](0);
     }
     vave /= dom.Ndim(2)-2;
     
@@ -249,8 +255,8 @@ int main(int argc, char **argv) try
     for (size_t i=0;i<nx;i++)
     for (size_t j=0;j<ny;j++)
     {
-        Dom.IsSolid[0][i][j][0]    = true;
-        Dom.IsSolid[0][i][j][nz-1] = true;
+        Dom.IsSolid[0][Dom.Idx(i,j,0)]    = true;
+        Dom.IsSolid[0][Dom.Idx(i,j,nz-1)] = true;
     }
 
 
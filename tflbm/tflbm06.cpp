@@ -0,0 +1,166 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2016 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Tiled collide-stream benchmark: body force driven flow through a D3Q19 bed of fixed spheres
+// and a D2Q9 bed of fixed disks. Every tiled mode must reproduce the separate loops exactly.
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/flbm/Domain.h>
+
+struct UserData
+{
+    double Fx; ///< Body force along x
+};
+
+void Setup (FLBM::Domain & dom, void * UD)
+{
+    UserData & dat = (*static_cast<UserData *>(UD));
+    #ifdef USE_OMP
+    #pragma omp parallel for schedule(static) num_threads(dom.Nproc)
+    #endif
+    for (size_t n=0;n<dom.Ncells;n++)
+    {
+        dom.BForce[0][n] = dat.Fx,0.0,0.0;
+    }
+}
+
+struct Mode
+{
+    char const * Name;   ///< Name printed in the summary
+    LBMethod     Method; ///< D3Q19 or D2Q9
+    bool         Tiled;  ///< Use the fused tiled collide-stream
+    size_t       Bx;     ///< Tile size along x (0 for the whole domain)
+    size_t       By;     ///< Tile size along y (0 for the whole domain)
+    size_t       Bz;     ///< Tile size along z (0 for the whole domain)
+};
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 96;
+    size_t Nt    = 50;
+    double nu    = 0.1;
+    double Sf    = 0.2;      // target solid fraction of the bed
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    // The first mode of each lattice is the reference of the tiled ones that follow it.
+    // Tiles of 7, 10 and 20 do not divide the usual sizes and a tile of 0 is a single tile
+    // wrapping around the periodic boundary.
+    Mode Modes[] = {{"D3Q19 separate"  ,D3Q19,false, 0, 0, 0},
+                    {"D3Q19  8x8"      ,D3Q19,true , 0, 8, 8},
+                    {"D3Q19 16x16"     ,D3Q19,true , 0,16,16},
+                    {"D3Q19 32x32"     ,D3Q19,true , 0,32,32},
+                    {"D3Q19  7x10"     ,D3Q19,true , 0, 7,10},
+                    {"D3Q19 20x7x10"   ,D3Q19,true ,20, 7,10},
+                    {"D3Q19 single"    ,D3Q19,true , 0, 0, 0},
+                    {"D2Q9 separate"   ,D2Q9 ,false, 0, 0, 1},
+                    {"D2Q9  16"        ,D2Q9 ,true , 0,16, 1},
+                    {"D2Q9  7"         ,D2Q9 ,true , 0, 7, 1},
+                    {"D2Q9  20x7"      ,D2Q9 ,true ,20, 7, 1},
+                    {"D2Q9 single"     ,D2Q9 ,true , 0, 0, 1}};
+    size_t Nmodes = sizeof(Modes)/sizeof(Mode);
+    Array<double> Mlups(Nmodes);
+    Array<double> Vmean(Nmodes);
+    Array<double> Dmax (Nmodes);
+    Array<Vec3_t> Vref;
+
+    UserData dat;
+    dat.Fx = 1.0e-5;
+
+    for (size_t m=0;m<Nmodes;m++)
+    {
+        bool    Is2D = Modes[m].Method==D2Q9;
+        size_t  nz   = Is2D ? 1 : n;
+        FLBM::Domain Dom(Modes[m].Method, nu, iVec3_t(n,n,nz), 1.0, 1.0);
+        Dom.UserData = &dat;
+        Dom.Sc       = 0.0;
+        Dom.Tiled    = Modes[m].Tiled;
+        Dom.Tile     = Modes[m].Bx==0 ? n  : Modes[m].Bx,
+                       Modes[m].By==0 ? n  : Modes[m].By,
+                       Modes[m].Bz==0 ? nz : Modes[m].Bz;
+
+        // Same random bed for every mode of a lattice
+        srand(1);
+        double R  = 0.08*n;
+        double Ns = 0.0;
+        while (Ns<Sf*n*n*nz)
+        {
+            iVec3_t X(rand()%n,rand()%n,rand()%nz);
+            int     r  = (int)R+1;
+            int     rz = Is2D ? 0 : r;
+            for (int i=-r ;i<=r ;i++)
+            for (int j=-r ;j<=r ;j++)
+            for (int k=-rz;k<=rz;k++)
+            {
+                size_t ix = (X(0)+i+n )%n;
+                size_t iy = (X(1)+j+n )%n;
+                size_t iz = (X(2)+k+nz)%nz;
+                if (i*i+j*j+k*k<R*R&&!Dom.IsSolid[0][Dom.Idx(ix,iy,iz)])
+                {
+                    Dom.IsSolid[0][Dom.Idx(ix,iy,iz)] = true;
+                    Ns += 1.0;
+                }
+            }
+        }
+        for (size_t ix=0;ix<n ;ix++)
+        for (size_t iy=0;iy<n ;iy++)
+        for (size_t iz=0;iz<nz;iz++)
+        {
+            Vec3_t v0 = OrthoSys::O;
+            Dom.Initialize(0,iVec3_t(ix,iy,iz),1.0,v0);
+        }
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt,2*Nt,Setup,NULL,NULL,false,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        double elapsed = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count();
+        Mlups[m] = Dom.Ncells*Nt/(1.0e6*elapsed);
+
+        // Every tiled mode must reproduce the velocity field of the separate loops
+        double Nf = 0.0;
+        Vmean[m]  = 0.0;
+        Dmax [m]  = 0.0;
+        if (!Modes[m].Tiled) Vref.Resize(Dom.Ncells);
+        for (size_t nc=0;nc<Dom.Ncells;nc++)
+        {
+            if (!Modes[m].Tiled) Vref[nc] = Dom.Vel[0][nc];
+            else                 Dmax[m]  = std::max(Dmax[m],norm(Dom.Vel[0][nc]-Vref[nc]));
+            if (Dom.IsSolid[0][nc]) continue;
+            Vmean[m] += Dom.Vel[0][nc](0);
+            Nf       += 1.0;
+        }
+        Vmean[m] /= Nf;
+    }
+
+    printf("\n%s--- Tiled collide-stream benchmark %zd^3 D3Q19 and %zd^2 D2Q9, solid fraction %g, %zd steps, %zd threads ---%s\n",TERM_CLR1,n,n,Sf,Nt,Nproc,TERM_RST);
+    for (size_t m=0;m<Nmodes;m++)
+    {
+        printf("%s  %-16s MLUPS = %8.3f  MLUPS/core = %8.3f  <Vx> = %.6e  max|dV| = %.3e%s\n",TERM_CLR2,Modes[m].Name,Mlups[m],Mlups[m]/Nproc,Vmean[m],Dmax[m],TERM_RST);
+    }
+    for (size_t m=0;m<Nmodes;m++)
+    {
+        if (Dmax[m]!=0.0) throw new Fatal("tflbm06: mode %s departs from the separate loops by max|dV| = %g",Modes[m].Name,Dmax[m]);
+    }
+}
+MECHSYS_CATCH
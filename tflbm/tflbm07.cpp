@@ -0,0 +1,120 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2016 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+
+// Host kernels of lbm.cl against the native solver: decaying shear wave through a D3Q19 bed of fixed spheres
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/flbm/Domain.h>
+
+struct Mode
+{
+    char const * Name;   ///< Name printed in the summary
+    bool         CLHost; ///< Run the OpenCL kernels on the host
+};
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 64;
+    size_t Nt    = 50;
+    double nu    = 0.1;
+    double U     = 0.05;     // amplitude of the shear wave
+    double Sf    = 0.1;      // target solid fraction of the bed
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    Mode Modes[] = {{"Native"           ,false},
+                    {"OpenCL on host"   ,true }};
+    size_t Nmodes = sizeof(Modes)/sizeof(Mode);
+    Array<double> Mlups(Nmodes);
+    Array<double> Ekin (Nmodes);
+    Array<double> Dmax (Nmodes);
+    Array<Vec3_t> Vref;
+
+    for (size_t m=0;m<Nmodes;m++)
+    {
+        FLBM::Domain Dom(D3Q19, nu, iVec3_t(n,n,n), 1.0, 1.0);
+        Dom.Sc       = 0.0;
+        Dom.CLHost   = Modes[m].CLHost;
+
+        // Same random bed for every mode
+        srand(1);
+        double R  = 0.08*n;
+        double Ns = 0.0;
+        while (Ns<Sf*n*n*n)
+        {
+            iVec3_t X(rand()%n,rand()%n,rand()%n);
+            int     r = (int)R+1;
+            for (int i=-r;i<=r;i++)
+            for (int j=-r;j<=r;j++)
+            for (int k=-r;k<=r;k++)
+            {
+                size_t ix = (X(0)+i+n)%n;
+                size_t iy = (X(1)+j+n)%n;
+                size_t iz = (X(2)+k+n)%n;
+                if (i*i+j*j+k*k<R*R&&!Dom.IsSolid[0][Dom.Idx(ix,iy,iz)])
+                {
+                    Dom.IsSolid[0][Dom.Idx(ix,iy,iz)] = true;
+                    Ns += 1.0;
+                }
+            }
+        }
+        for (size_t ix=0;ix<n;ix++)
+        for (size_t iy=0;iy<n;iy++)
+        for (size_t iz=0;iz<n;iz++)
+        {
+            Vec3_t v0(U*sin(2.0*M_PI*iy/n),0.0,0.0);
+            Dom.Initialize(0,iVec3_t(ix,iy,iz),1.0,v0);
+        }
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt,2*Nt,NULL,NULL,NULL,false,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        double elapsed = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count();
+        Mlups[m] = Dom.Ncells*Nt/(1.0e6*elapsed);
+
+        // The host buffers hold the final state, bring it back into the domain fields
+        if (Dom.CLHost) Dom.DnLoadHost();
+
+        Ekin[m] = 0.0;
+        Dmax[m] = 0.0;
+        if (m==0) Vref.Resize(Dom.Ncells);
+        for (size_t nc=0;nc<Dom.Ncells;nc++)
+        {
+            if (m==0) Vref[nc] = Dom.Vel[0][nc];
+            else      Dmax[m]  = std::max(Dmax[m],norm(Dom.Vel[0][nc]-Vref[nc]));
+            if (Dom.IsSolid[0][nc]) continue;
+            Ekin[m] += 0.5*Dom.Rho[0][nc]*dot(Dom.Vel[0][nc],Dom.Vel[0][nc]);
+        }
+    }
+
+    printf("\n%s--- OpenCL host kernels %zd^3 D3Q19, solid fraction %g, %zd steps, %zd threads ---%s\n",TERM_CLR1,n,Sf,Nt,Nproc,TERM_RST);
+    for (size_t m=0;m<Nmodes;m++)
+    {
+        printf("%s  %-16s MLUPS = %8.3f  MLUPS/core = %8.3f  Ekin = %.6e  max|dV| = %.3e%s\n",TERM_CLR2,Modes[m].Name,Mlups[m],Mlups[m]/Nproc,Ekin[m],Dmax[m],TERM_RST);
+    }
+
+    // Both paths solve the same BGK model, they only differ in round off
+    if (Dmax[1]>1.0e-3*U) throw new Fatal("tflbm07: the host kernels do not reproduce the native solver (max|dV| = %g)",Dmax[1]);
+}
+MECHSYS_CATCH
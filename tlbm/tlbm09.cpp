@@ -0,0 +1,103 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Lattice storage benchmark: body force driven flow through a D3Q19 bed of fixed spheres
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+struct Mode
+{
+    char const * Name;   ///< Name printed in the summary
+    bool         SoA;    ///< Use the packed lattice storage
+    bool         AA;     ///< Fused in-place stream and collision
+    bool         Sparse; ///< Pack only the fluid nodes and the solid nodes next to them
+};
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 64;
+    size_t Nt    = 100;
+    double nu    = 0.1;
+    double dx    = 1.0;
+    double dt    = 1.0;
+    double Sf    = 0.3;      // target solid fraction of the bed
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+    if (argc>=5) Sf    = atof(argv[4]);
+
+    Mode Modes[] = {{"Cell storage"        ,false,false,false},
+                    {"Packed (SoA) storage",true ,false,false},
+                    {"Packed AA pattern"   ,true ,true ,false},
+                    {"Sparse packed"       ,true ,false,true },
+                    {"Sparse AA pattern"   ,true ,true ,true }};
+    size_t Nmodes = sizeof(Modes)/sizeof(Mode);
+    Array<double> Mlups(Nmodes);
+    Array<double> Vmean(Nmodes);
+
+    for (size_t m=0;m<Nmodes;m++)
+    {
+        LBM::Domain Dom(D3Q19, nu, iVec3_t(n,n,n), dx, dt);
+        Dom.SoA       = Modes[m].SoA;
+        Dom.AAPattern = Modes[m].AA;
+        Dom.Sparse    = Modes[m].Sparse;
+        Dom.Sc        = 0.0;
+
+        // Same random bed for every mode
+        srand(1);
+        double R = 0.08*n;
+        while (Dom.Lat[0].SolidFraction()<Sf)
+        {
+            Vec3_t X(n*(1.0*rand())/RAND_MAX,n*(1.0*rand())/RAND_MAX,n*(1.0*rand())/RAND_MAX);
+            Dom.Lat[0].SolidDisk(X,R);
+        }
+        for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+        {
+            Dom.Lat[0].Cells[i]->Initialize(1.0,OrthoSys::O);
+            Dom.Lat[0].Cells[i]->BForcef = 1.0e-5,0.0,0.0;
+        }
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt*dt,2*Nt*dt,NULL,NULL,NULL,false,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        double elapsed = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count();
+        Mlups[m] = Dom.Lat[0].Ncells*Nt/(1.0e6*elapsed);
+
+        double Nf = 0.0;
+        Vmean[m]  = 0.0;
+        for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+        {
+            if (Dom.Lat[0].Cells[i]->IsSolid) continue;
+            Vmean[m] += Dom.Lat[0].Cells[i]->Vel(0);
+            Nf       += 1.0;
+        }
+        Vmean[m] /= Nf;
+    }
+
+    printf("\n%s--- Lattice storage benchmark %zd^3 D3Q19, solid fraction %g, %zd steps, %zd threads ---%s\n",TERM_CLR1,n,Sf,Nt,Nproc,TERM_RST);
+    for (size_t m=0;m<Nmodes;m++)
+    {
+        printf("%s  %-28s MLUPS = %8.3f  MLUPS/core = %8.3f  <Vx> = %.6e%s\n",TERM_CLR2,Modes[m].Name,Mlups[m],Mlups[m]/Nproc,Vmean[m],TERM_RST);
+    }
+}
+MECHSYS_CATCH
@@ -0,0 +1,84 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Collision kernel micro-benchmark: cell storage (CollideSC) against the templated packed kernel (CollideSoA)
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+struct Case
+{
+    char const * Name;   ///< Name printed in the summary
+    LBMethod     Method; ///< Velocity set
+    iVec3_t      Ndim;   ///< Lattice size
+};
+
+double Time (LBM::Domain & Dom, bool Packed, size_t Nt)
+{
+    std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+    for (size_t t=0;t<Nt;t++)
+    {
+        if (Packed) Dom.CollideSoA(0,Dom.Nproc);
+        else        Dom.CollideSC (0,Dom.Nproc);
+    }
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count();
+}
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 64;
+    size_t Nt    = 50;
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+
+    Case Cases[] = {{"D2Q9 ",D2Q9 ,iVec3_t(8*n,8*n,1)},
+                    {"D3Q15",D3Q15,iVec3_t(n,n,n)},
+                    {"D3Q19",D3Q19,iVec3_t(n,n,n)}};
+    size_t Ncases = sizeof(Cases)/sizeof(Case);
+
+    printf("\n%s--- Collision kernel benchmark, %zd steps, %zd threads ---%s\n",TERM_CLR1,Nt,Nproc,TERM_RST);
+    for (size_t c=0;c<Ncases;c++)
+    {
+        LBM::Domain Dom(Cases[c].Method, 0.1, Cases[c].Ndim, 1.0, 1.0);
+        Dom.Nproc = Nproc;
+        Dom.Sc    = 0.17;
+        for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+        {
+            Vec3_t v(0.01*sin(0.1*i),0.01*cos(0.1*i),0.0);
+            Dom.Lat[0].Cells[i]->Initialize(1.0+0.01*sin(0.3*i),v);
+        }
+        Dom.Lat[0].SetZeroGamma();
+        double Ncells = Dom.Lat[0].Ncells;
+
+        double Tcell = Time(Dom,false,Nt);
+        Dom.Lat[0].Pack();
+        double Tpack = Time(Dom,true ,Nt);
+        Dom.Lat[0].Unpack();
+
+        double Mcell = Ncells*Nt/(1.0e6*Tcell);
+        double Mpack = Ncells*Nt/(1.0e6*Tpack);
+        printf("%s  %s  cell MLUPS/core = %8.3f  packed MLUPS/core = %8.3f  speedup = %5.2f%s\n",TERM_CLR2,Cases[c].Name,Mcell/Nproc,Mpack/Nproc,Mpack/Mcell,TERM_RST);
+    }
+}
+MECHSYS_CATCH
@@ -0,0 +1,96 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Domain decomposition: body force driven flow through a D3Q15 bed of fixed spheres around a free sphere.
+// The lattice is split among the MPI ranks, the checksums printed at the end must agree (up to round off)
+// for any number of ranks, for instance
+//      tlbm11 1 40 200    and    mpirun -np 4 tlbm11 1 40 200
+
+//STD
+#include<iostream>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+int main(int argc, char **argv) try
+{
+#ifdef USE_MPI
+    MPI_Init(&argc,&argv);
+#endif
+    size_t Nproc  = 1;
+    size_t n      = 40;
+    size_t Nt     = 200;
+    bool   Render = false;
+    double nu     = 0.1;
+    double dx     = 1.0;
+    double dt     = 1.0;
+    if (argc>=2) Nproc  = atoi(argv[1]);
+    if (argc>=3) n      = atoi(argv[2]);
+    if (argc>=4) Nt     = atoi(argv[3]);
+    if (argc>=5) Render = atoi(argv[4]);
+
+    LBM::Domain Dom(D3Q15, nu, iVec3_t(n,n,n), dx, dt);
+    Dom.Sc    = 0.0;
+    Dom.Alpha = dx;
+
+    // Same random bed in every rank, SolidDisk only marks the cells stored locally
+    srand(1);
+    double R = 0.08*n;
+    while (Dom.Lat[0].SolidFraction()<0.2)
+    {
+        Vec3_t X(n*(1.0*rand())/RAND_MAX,n*(1.0*rand())/RAND_MAX,n*(1.0*rand())/RAND_MAX);
+        if (norm(X-0.5*n*Vec3_t(1.0,1.0,1.0))<0.3*n) continue;
+        Dom.Lat[0].SolidDisk(X,R);
+    }
+    for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+    {
+        Dom.Lat[0].Cells[i]->Initialize(1.0,OrthoSys::O);
+        Dom.Lat[0].Cells[i]->BForcef = 1.0e-5,0.0,0.0;
+    }
+    Dom.AddSphere(-1,Vec3_t(0.5*n*dx,0.5*n*dx,0.5*n*dx),0.1*n*dx,3.0);
+
+    Dom.Solve(Nt*dt,0.1*Nt*dt,NULL,NULL,Render ? "tlbm11" : NULL,Render,Nproc);
+
+    // Checksums over the cells owned by each rank
+    double Sum[3] = {0.0,0.0,0.0};
+    for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+    {
+        Cell * c = Dom.Lat[0].Cells[i];
+        if (Dom.Lat[0].Ghost(i)) continue;
+        Sum[0] += c->Rho;
+        Sum[1] += c->Rho*c->Vel(0);
+        Sum[2] += c->IsSolid ? 1.0 : 0.0;
+    }
+#ifdef USE_MPI
+    double Loc[3] = {Sum[0],Sum[1],Sum[2]};
+    MPI_Allreduce(Loc,Sum,3,MPI_DOUBLE,MPI_SUM,MPI_COMM_WORLD);
+#endif
+    if (Dom.Lat[0].Rank==0)
+    {
+        DEM::Particle * Pa = Dom.Particles[0];
+        printf("\n%s--- Domain decomposition %zd^3 D3Q15, %zd steps, %zd ranks ---%s\n",TERM_CLR1,n,Nt,Dom.Lat[0].Nranks,TERM_RST);
+        printf("%s  Solid nodes        = %.0f%s\n"           ,TERM_CLR2,Sum[2],TERM_RST);
+        printf("%s  Total mass         = %.12e%s\n"          ,TERM_CLR2,Sum[0],TERM_RST);
+        printf("%s  Total momentum x   = %.12e%s\n"          ,TERM_CLR2,Sum[1],TERM_RST);
+        printf("%s  Particle position  = %.12e %.12e %.12e%s\n",TERM_CLR2,Pa->x(0),Pa->x(1),Pa->x(2),TERM_RST);
+        printf("%s  Particle velocity  = %.12e %.12e %.12e%s\n",TERM_CLR2,Pa->v(0),Pa->v(1),Pa->v(2),TERM_RST);
+    }
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
+}
+MECHSYS_CATCH
@@ -0,0 +1,106 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Coupling benchmark: body force driven flow through a D3Q15 packed bed of spheres and cubes. Once the flow
+// has developed, the imprint of the bed into the lattice is timed on its own while the particles drift
+// by a small fraction of dx per step, evaluating the overlap lengths every step (ImprintTol = 0) and
+// reusing them while the particles move less than Tol*dx, for instance
+//      tlbm12 1 40 200 0.1
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 40;
+    size_t Nt    = 200;
+    double Tol   = 0.1;
+    double nu    = 0.1;
+    double dx    = 1.0;
+    double dt    = 1.0;
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+    if (argc>=5) Tol   = atof(argv[4]);
+
+    LBM::Domain Dom(D3Q15, nu, iVec3_t(n,n,n), dx, dt);
+    Dom.Sc    = 0.0;
+    Dom.Alpha = dx;
+    for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+    {
+        Dom.Lat[0].Cells[i]->Initialize(1.0,OrthoSys::O);
+        Dom.Lat[0].Cells[i]->BForcef = 1.0e-5,0.0,0.0;
+    }
+
+    // Particles 7 cells apart, one in five is a cube
+    size_t Ns = (n-4)/7;
+    for (size_t i=0;i<Ns;i++)
+    for (size_t j=0;j<Ns;j++)
+    for (size_t k=0;k<Ns;k++)
+    {
+        Vec3_t X(dx*(5.5+7.0*i),dx*(5.5+7.0*j),dx*(5.5+7.0*k));
+        if ((i+j+k)%5==0) Dom.AddCube  (-1,X,0.5*dx,4.0*dx,3.0);
+        else              Dom.AddSphere(-1,X,3.0*dx,3.0);
+    }
+    for (size_t i=0;i<Dom.Particles.Size();i++) Dom.Particles[i]->FixVeloc();
+
+    // Develop the flow, this also builds the stencils of the particles
+    Dom.Solve(Nt*dt,Nt*dt,NULL,NULL,NULL,false,Nproc);
+
+    Array<Vec3_t> X0(Dom.Particles.Size());
+    for (size_t i=0;i<Dom.Particles.Size();i++) X0[i] = Dom.Particles[i]->x;
+    Vec3_t Vd(0.002*dx/dt,0.001*dx/dt,-0.003*dx/dt);
+
+    double Timp[2];
+    Vec3_t Fsum[2];
+    for (size_t m=0;m<2;m++)
+    {
+        Dom.ImprintTol = (m==1) ? Tol : 0.0;
+        for (size_t i=0;i<Dom.Particles.Size();i++) Dom.Particles[i]->x = X0[i];
+        Fsum[m] = OrthoSys::O;
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        for (size_t r=0;r<Nt;r++)
+        {
+            Dom.Lat[0].SetZeroGamma(0,Nproc);
+            for (size_t i=0;i<Dom.Particles.Size();i++)
+            {
+                DEM::Particle * Pa = Dom.Particles[i];
+                Pa->F  = Pa->Ff;
+                Pa->T  = Pa->Tf;
+                Pa->x += Vd*dt;
+            }
+            Dom.ImprintLatticeSC(0,Nproc);
+            for (size_t i=0;i<Dom.Particles.Size();i++) Fsum[m] += Dom.Particles[i]->F;
+        }
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Timp[m] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+    }
+
+    printf("\n%s--- Coupling benchmark %zd^3 D3Q15, %zd particles, %zd stencil cells, %zd steps, %zd threads ---%s\n",TERM_CLR1,n,Dom.Particles.Size(),Dom.StencilCell.Size(),Nt,Nproc,TERM_RST);
+    printf("%s  lengths every step   : time/imprint = %.4e s%s\n",TERM_CLR2,Timp[0],TERM_RST);
+    printf("%s  lengths reused (%.2f): time/imprint = %.4e s  speedup = %7.3f  |dF|/|F| = %.3e%s\n",TERM_CLR2,Tol,Timp[1],Timp[0]/Timp[1],norm(Fsum[1]-Fsum[0])/norm(Fsum[0]),TERM_RST);
+
+    // The reused lengths are off by less than Tol cells, the force on the bed must follow within that fraction
+    if (norm(Fsum[1]-Fsum[0])>Tol*norm(Fsum[0])) throw new Fatal("tlbm12: reusing the overlap lengths changes the force on the bed by %g, more than the tolerance %g",norm(Fsum[1]-Fsum[0])/norm(Fsum[0]),Tol);
+}
+MECHSYS_CATCH
@@ -0,0 +1,112 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Subcycling benchmark: spheres settling in a D3Q15 fluid onto a layer of fixed spheres, with stiff
+// contacts that need Nsub DEM substeps per LBM step. The bed is solved imprinting the particles at
+// every substep (HydroImprint) with eager and with lazy particle cell pairs, then keeping (HydroHold)
+// or interpolating (HydroLinear) the forces of the last LBM steps with lazy pairs, for instance
+//      tlbm13 1 32 200 20
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 32;
+    size_t Nt    = 200;
+    size_t Nsub  = 20;
+    double nu    = 0.1;
+    double dx    = 1.0;
+    double dt    = 1.0;
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+    if (argc>=5) Nsub  = atoi(argv[4]);
+
+    char const * Name[4] = {"imprint every substep","imprint, lazy pairs  ","hold, lazy pairs     ","linear, lazy pairs   "};
+    LBM::HydroMode Mode[4] = {LBM::HydroImprint,LBM::HydroImprint,LBM::HydroHold,LBM::HydroLinear};
+    double Tstep[4];
+    double Dmax [4];
+    double Travel = 0.0;
+    Array<Vec3_t> Xref;
+
+    for (size_t m=0;m<4;m++)
+    {
+        LBM::Domain Dom(D3Q15, nu, iVec3_t(n,n,n), dx, dt);
+        Dom.Sc        = 0.0;
+        Dom.Alpha     = 0.5*dx;
+        Dom.dtdem     = dt/Nsub;
+        Dom.Hydro     = Mode[m];
+        Dom.LazyPairs = (m>0);
+        for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+        {
+            Dom.Lat[0].Cells[i]->Initialize(1.0,OrthoSys::O);
+        }
+
+        // A fixed layer at the bottom and two loose layers above it, 6 cells apart
+        size_t Ns = (n-2)/6;
+        srand(1);
+        for (size_t k=0;k<3;k++)
+        for (size_t i=0;i<Ns;i++)
+        for (size_t j=0;j<Ns;j++)
+        {
+            Vec3_t X(dx*(4.0+6.0*i),dx*(4.0+6.0*j),dx*(4.0+6.0*k));
+            if (k>0) X += dx*Vec3_t(0.5*rand()/RAND_MAX,0.5*rand()/RAND_MAX,0.0);
+            Dom.AddSphere(-1,X,2.5*dx,3.0);
+            DEM::Particle * Pa = Dom.Particles[Dom.Particles.Size()-1];
+            if (k==0) Pa->FixVeloc();
+            else      Pa->Ff = 0.0,0.0,-5.0e-4*Pa->Props.m;
+        }
+
+        Array<Vec3_t> X0(Dom.Particles.Size());
+        for (size_t i=0;i<Dom.Particles.Size();i++) X0[i] = Dom.Particles[i]->x;
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        Dom.Solve(Nt*dt,Nt*dt,NULL,NULL,NULL,false,Nproc);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Tstep[m] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+
+        if (m==0) Xref.Resize(Dom.Particles.Size());
+        Dmax[m] = 0.0;
+        for (size_t i=0;i<Dom.Particles.Size();i++)
+        {
+            if (m==0) Xref[i] = Dom.Particles[i]->x;
+            if (m==0) Travel  = std::max(Travel,norm(Dom.Particles[i]->x-X0[i]));
+            else      Dmax[m] = std::max(Dmax[m],norm(Dom.Particles[i]->x-Xref[i]));
+        }
+    }
+
+    printf("\n%s--- Subcycling benchmark %zd^3 D3Q15, %zd LBM steps, %zd DEM substeps each, %zd threads ---%s\n",TERM_CLR1,n,Nt,Nsub,Nproc,TERM_RST);
+    for (size_t m=0;m<4;m++)
+    {
+        printf("%s  %s: time/LBM step = %.4e s  speedup = %7.3f  max|dX| = %.3e%s\n",TERM_CLR2,Name[m],Tstep[m],Tstep[0]/Tstep[m],Dmax[m],TERM_RST);
+    }
+    printf("%s  largest travel of a particle = %.3e%s\n",TERM_CLR2,Travel,TERM_RST);
+
+    // The lazy pairs must not change anything. Interpolating the forces is an approximation that should
+    // follow the settling within a tenth of the travel, holding them is cruder and is only required not
+    // to throw the particles off their course
+    if (Dmax[1]>0.0)        throw new Fatal("tlbm13: the lazy pairs change the trajectories by max|dX| = %g",Dmax[1]);
+    if (Dmax[3]>0.1*Travel) throw new Fatal("tlbm13: interpolating the forces departs from the imprint by max|dX| = %g, for a travel of %g",Dmax[3],Travel);
+    if (Dmax[2]>Travel)     throw new Fatal("tlbm13: holding the forces departs from the imprint by max|dX| = %g, for a travel of %g",Dmax[2],Travel);
+}
+MECHSYS_CATCH
@@ -0,0 +1,118 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Overlap table benchmark: spheres (disks) of several radii placed at random offsets in the lattice, the
+// partial saturation weights gamma = len/(12dx) (len/(4dx) in 2D) of the cells around them are evaluated
+// with SphereCube (DiskSquare) and with the direction averaged OverlapTable. Reports the error of the
+// weights, the error of the total solid volume and the evaluation rate of both, for instance
+//      tlbm14 20 200
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nsp  = 20;
+    size_t Nrep = 200;
+    double dx   = 1.0;
+    double Tolm = 0.1;      // tolerance of mean|dgamma| over the partial cells
+    double Tolv = 0.03;     // tolerance of the relative error of the solid volume
+    if (argc>=2) Nsp  = atoi(argv[1]);
+    if (argc>=3) Nrep = atoi(argv[2]);
+
+    double Rad[4] = {1.5,3.0,6.0,12.0};
+
+    printf("\n%s--- Overlap table benchmark, %zd spheres per radius, %zd repetitions ---%s\n",TERM_CLR1,Nsp,Nrep,TERM_RST);
+    for (size_t Dim=3;Dim>=2;Dim--)
+    {
+        DEM::OverlapTable Tab;
+        std::chrono::high_resolution_clock::time_point tb0 = std::chrono::high_resolution_clock::now();
+        Tab.Build(Dim,Rad[0],Rad[3]);
+        std::chrono::high_resolution_clock::time_point tb1 = std::chrono::high_resolution_clock::now();
+        double Full = (Dim==3) ? 12.0*dx : 4.0*dx;
+        printf("%s  %s, table %zd x %zd built in %.3e s%s\n",TERM_CLR1,(Dim==3) ? "SphereCube" : "DiskSquare",Tab.Ns,Tab.Nr,
+            std::chrono::duration_cast<std::chrono::duration<double> >(tb1-tb0).count(),TERM_RST);
+
+        srand(1);
+        for (size_t r=0;r<4;r++)
+        {
+            double R = Rad[r]*dx;
+            int    m = ceil(R/dx) + 2;
+
+            // Cells of the partial band around each sphere
+            Array<Vec3_t> Xs;
+            Array<Vec3_t> Xc;
+            double Vex  = 0.0;
+            double Vtab = 0.0;
+            double Emax = 0.0;
+            double Emean= 0.0;
+            for (size_t n=0;n<Nsp;n++)
+            {
+                Vec3_t X(dx*rand()/RAND_MAX,dx*rand()/RAND_MAX,(Dim==3) ? dx*rand()/RAND_MAX : 0.0);
+                int mz = (Dim==3) ? m : 0;
+                for (int i=-m;i<=m;i++)
+                for (int j=-m;j<=m;j++)
+                for (int k=-mz;k<=mz;k++)
+                {
+                    Vec3_t C(dx*i,dx*j,dx*k);
+                    double lex  = (Dim==3) ? DEM::SphereCube(X,C,R,dx) : DEM::DiskSquare(X,C,R,dx);
+                    double ltab = Tab.Len(norm(C-X),R,dx);
+                    Vex  += lex/Full;
+                    Vtab += ltab/Full;
+                    if (lex>0.0&&lex<Full)
+                    {
+                        double e = fabs(ltab-lex)/Full;
+                        Emax   = std::max(Emax,e);
+                        Emean += e;
+                        Xs.Push(X);
+                        Xc.Push(C);
+                    }
+                }
+            }
+            Emean /= Xs.Size();
+
+            // Evaluation rate over the partial cells, where SphereCube (DiskSquare) does the work
+            double sum[2] = {0.0,0.0};
+            double Teval[2];
+            for (size_t t=0;t<2;t++)
+            {
+                std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+                for (size_t rep=0;rep<Nrep;rep++)
+                for (size_t i=0;i<Xs.Size();i++)
+                {
+                    if      (t==1)    sum[t] += Tab.Len(norm(Xc[i]-Xs[i]),R,dx);
+                    else if (Dim==3)  sum[t] += DEM::SphereCube(Xs[i],Xc[i],R,dx);
+                    else              sum[t] += DEM::DiskSquare(Xs[i],Xc[i],R,dx);
+                }
+                std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+                Teval[t] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/(Nrep*Xs.Size());
+            }
+
+            printf("%s  R/dx = %5.2f  partial cells = %6zd  mean|dgamma| = %.3e  max|dgamma| = %.3e  dV/V = %+.3e  exact = %.3e s  table = %.3e s  speedup = %7.3f  dL/L partial = %+.1e%s\n",
+                TERM_CLR2,R/dx,Xs.Size(),Emean,Emax,(Vtab-Vex)/Vex,Teval[0],Teval[1],Teval[0]/Teval[1],sum[1]/sum[0]-1.0,TERM_RST);
+
+            // The table averages over the directions, a single cell may be far off but not the mean nor the volume
+            if (Emean>Tolm)                throw new Fatal("tlbm14: mean|dgamma| = %g for R/dx = %g in %zdD",Emean,R/dx,Dim);
+            if (fabs(Vtab-Vex)>Tolv*Vex)   throw new Fatal("tlbm14: dV/V = %g for R/dx = %g in %zdD",(Vtab-Vex)/Vex,R/dx,Dim);
+        }
+    }
+}
+MECHSYS_CATCH
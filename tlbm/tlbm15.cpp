@@ -0,0 +1,137 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Broad phase benchmark for 2D disks: m x m disks settling in a D2Q9 fluid onto a row of fixed disks.
+// After a short run the contact search is timed on its own, once over the list of all disk pairs and
+// once over the pairs of neighbouring linked cells, for instance
+//      tlbm15 1 40 100 20
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t m     = 40;
+    size_t Nt    = 100;
+    size_t Nrep  = 20;
+    double nu    = 0.1;
+    double dx    = 1.0;
+    double dt    = 1.0;
+    double R     = 2.0*dx;
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) m     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+    if (argc>=5) Nrep  = atoi(argv[4]);
+
+    size_t nx = 5*m+4;
+    size_t ny = 5*m+12;
+    LBM::Domain Dom(D2Q9, nu, iVec3_t(nx,ny,1), dx, dt);
+    Dom.Sc    = 0.0;
+    Dom.Alpha = 0.5*dx;
+    for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+    {
+        Dom.Lat[0].Cells[i]->Initialize(1.0,OrthoSys::O);
+    }
+
+    // A fixed row at the bottom and m rows of loose disks above it, 5 cells apart
+    srand(1);
+    for (size_t i=0;i<m;i++)
+    {
+        Dom.AddDisk(-1,Vec3_t(dx*(4.0+5.0*i),dx*3.0,0.0),OrthoSys::O,OrthoSys::O,3.0,R,dt);
+        Dom.Disks[Dom.Disks.Size()-1]->FixVeloc();
+    }
+    for (size_t j=0;j<m;j++)
+    for (size_t i=0;i<m;i++)
+    {
+        Vec3_t X(dx*(4.0+5.0*i+0.5*rand()/RAND_MAX),dx*(8.0+5.0*j),0.0);
+        Dom.AddDisk(0,X,OrthoSys::O,OrthoSys::O,3.0,R,dt);
+        Dom.Disks[Dom.Disks.Size()-1]->Ff = 0.0,-1.0e-4*Dom.Disks[Dom.Disks.Size()-1]->M,0.0;
+    }
+    // Contacts soft enough for a DEM step per LBM step
+    for (size_t i=0;i<Dom.Disks.Size();i++)
+    {
+        Dom.Disks[i]->Kn = 10.0;
+        Dom.Disks[i]->Kt =  5.0;
+    }
+
+    std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+    Dom.Solve(Nt*dt,Nt*dt,NULL,NULL,NULL,false,Nproc);
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    double Tstep = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+
+    // Contact search over all the disk pairs, as when List2DPairs held them all
+    size_t Nd = Dom.Disks.Size();
+    Array<pair<size_t, size_t> > All;
+    for (size_t i=0;i<Nd-1;i++)
+    for (size_t j=i+1;j<Nd;j++)
+    {
+        All.Push(make_pair(i,j));
+    }
+    t0 = std::chrono::high_resolution_clock::now();
+    for (size_t r=0;r<Nrep;r++)
+    {
+        Dom.List2DPairs = All;
+        Dom.ResetContacts(false);
+    }
+    t1 = std::chrono::high_resolution_clock::now();
+    double Tall = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nrep;
+
+    // Contact search over the linked cells, including the binning of the disks
+    t0 = std::chrono::high_resolution_clock::now();
+    for (size_t r=0;r<Nrep;r++)
+    {
+        Dom.LinkedCell.Resize(0);
+        Dom.BoundingBox(Dom.LCxmin,Dom.LCxmax);
+        Dom.LCellDim = (Dom.LCxmax - Dom.LCxmin)/(2.0*Dom.Beta*Dom.MaxDmax) + iVec3_t(1,1,1);
+        Dom.LinkedCell.Resize(Dom.LCellDim(0)*Dom.LCellDim(1)*Dom.LCellDim(2));
+        Dom.ResetDisplacements();
+        Dom.UpdateLinkedCells();
+        Dom.ResetContacts(false);
+    }
+    t1 = std::chrono::high_resolution_clock::now();
+    double Tlc = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nrep;
+
+    // Every pair close enough to be in contact must be a candidate of the linked cells
+    set<pair<size_t, size_t> > Cand;
+    for (size_t n=0;n<Dom.List2DPairs.Size();n++)
+    {
+        size_t i = Dom.List2DPairs[n].first;
+        size_t j = Dom.List2DPairs[n].second;
+        Cand.insert(make_pair(std::min(i,j),std::max(i,j)));
+    }
+    size_t Nclose = 0;
+    for (size_t n=0;n<All.Size();n++)
+    {
+        LBM::Disk * Di = Dom.Disks[All[n].first];
+        LBM::Disk * Dj = Dom.Disks[All[n].second];
+        if (!Di->IsFree()&&!Dj->IsFree()) continue;
+        if (DEM::Distance(Di->X,Dj->X)>Di->R+Dj->R+2*Dom.Alpha) continue;
+        Nclose++;
+        if (Cand.count(All[n])==0) throw new Fatal("tlbm15: the linked cells miss the close disks %zd and %zd",All[n].first,All[n].second);
+    }
+
+    printf("\n%s--- Broad phase benchmark %zd disks, %zdx%zd D2Q9, %zd steps, %zd threads ---%s\n",TERM_CLR1,Nd,nx,ny,Nt,Nproc,TERM_RST);
+    printf("%s  time/LBM step = %.4e s  disk pairs = %zd%s\n",TERM_CLR2,Tstep,Dom.DiskPairs.Size(),TERM_RST);
+    printf("%s  all pairs   : candidates = %10zd  time/search = %.4e s  close pairs = %zd%s\n",TERM_CLR2,All.Size(),Tall,Nclose,TERM_RST);
+    printf("%s  linked cells: candidates = %10zd  time/search = %.4e s  speedup = %7.3f%s\n",TERM_CLR2,Dom.List2DPairs.Size(),Tlc,Tall/Tlc,TERM_RST);
+}
+MECHSYS_CATCH
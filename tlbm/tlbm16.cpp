@@ -0,0 +1,130 @@
+/************************************************************************
+ * MechSys - Open Library for Mechanical Systems                        *
+ * Copyright (C) 2009 Sergio Galindo                                    *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * any later version.                                                   *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>  *
+ ************************************************************************/
+// Incremental imprint benchmark: body force driven flow through a D3Q15 packed bed of spheres and cubes
+// where only a fraction Fa of the particles moves. Once the flow has developed, clearing the lattice and
+// imprinting the bed is timed with a full clear and the overlap lengths evaluated every step, with the
+// lengths reused while the particles move less than Tol*dx, and with the incremental imprint that also
+// keeps the solid fractions of the particles at rest, for instance
+//      tlbm16 1 40 200 0.1 0.1
+
+//STD
+#include<iostream>
+#include<chrono>
+
+// MechSys
+#include <mechsys/lbm/Domain.h>
+
+int main(int argc, char **argv) try
+{
+    size_t Nproc = 1;
+    size_t n     = 40;
+    size_t Nt    = 200;
+    double Fa    = 0.1;
+    double Tol   = 0.1;
+    double nu    = 0.1;
+    double dx    = 1.0;
+    double dt    = 1.0;
+    if (argc>=2) Nproc = atoi(argv[1]);
+    if (argc>=3) n     = atoi(argv[2]);
+    if (argc>=4) Nt    = atoi(argv[3]);
+    if (argc>=5) Fa    = atof(argv[4]);
+    if (argc>=6) Tol   = atof(argv[5]);
+
+    LBM::Domain Dom(D3Q15, nu, iVec3_t(n,n,n), dx, dt);
+    Dom.Sc    = 0.0;
+    Dom.Alpha = dx;
+    for (size_t i=0;i<Dom.Lat[0].Ncells;i++)
+    {
+        Dom.Lat[0].Cells[i]->Initialize(1.0,OrthoSys::O);
+        Dom.Lat[0].Cells[i]->BForcef = 1.0e-5,0.0,0.0;
+    }
+
+    // Particles 7 cells apart, one in five is a cube
+    size_t Ns = (n-4)/7;
+    for (size_t i=0;i<Ns;i++)
+    for (size_t j=0;j<Ns;j++)
+    for (size_t k=0;k<Ns;k++)
+    {
+        Vec3_t X(dx*(5.5+7.0*i),dx*(5.5+7.0*j),dx*(5.5+7.0*k));
+        if ((i+j+k)%5==0) Dom.AddCube  (-1,X,0.5*dx,4.0*dx,3.0);
+        else              Dom.AddSphere(-1,X,3.0*dx,3.0);
+    }
+    for (size_t i=0;i<Dom.Particles.Size();i++) Dom.Particles[i]->FixVeloc();
+
+    // Develop the flow, this also builds the stencils of the particles
+    Dom.Solve(Nt*dt,Nt*dt,NULL,NULL,NULL,false,Nproc);
+
+    // The active particles drift by a small fraction of dx per step, the others stay at rest
+    size_t Np = Dom.Particles.Size();
+    Array<Vec3_t> X0(Np);
+    Array<int>    Active(Np);
+    srand(1);
+    for (size_t i=0;i<Np;i++)
+    {
+        X0[i]     = Dom.Particles[i]->x;
+        Active[i] = (1.0*rand()/RAND_MAX<Fa);
+    }
+    Vec3_t Vd(0.002*dx/dt,0.001*dx/dt,-0.003*dx/dt);
+
+    char const * Name[3] = {"full clear, lengths every step","full clear, lengths reused    ","incremental                   "};
+    double Timp[3];
+    Vec3_t Fsum[3];
+    for (size_t m=0;m<3;m++)
+    {
+        Dom.ImprintTol = (m>0) ? Tol : 0.0;
+        Dom.IncImprint = (m==2);
+        Dom.FullClear  = true;
+        for (size_t i=0;i<Np;i++)
+        {
+            Dom.Particles[i]->x = X0[i];
+            Dom.StencilValid[i] = 0;
+        }
+        Fsum[m] = OrthoSys::O;
+
+        std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+        for (size_t r=0;r<Nt;r++)
+        {
+            for (size_t i=0;i<Np;i++)
+            {
+                DEM::Particle * Pa = Dom.Particles[i];
+                Pa->F  = Pa->Ff;
+                Pa->T  = Pa->Tf;
+                if (Active[i]) Pa->x += Vd*dt;
+            }
+            Dom.ClearImprint(Nproc);
+            Dom.ImprintLatticeSC(0,Nproc);
+            for (size_t i=0;i<Np;i++) Fsum[m] += Dom.Particles[i]->F;
+        }
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        Timp[m] = std::chrono::duration_cast<std::chrono::duration<double> >(t1-t0).count()/Nt;
+    }
+
+    size_t Na = 0;
+    for (size_t i=0;i<Np;i++) Na += Active[i];
+    printf("\n%s--- Incremental imprint benchmark %zd^3 D3Q15, %zd particles (%zd active), %zd steps, %zd threads ---%s\n",TERM_CLR1,n,Np,Na,Nt,Nproc,TERM_RST);
+    for (size_t m=0;m<3;m++)
+    {
+        printf("%s  %s: time/imprint = %.4e s  speedup = %7.3f  |dF|/|F| = %.3e%s\n",TERM_CLR2,Name[m],Timp[m],Timp[0]/Timp[m],norm(Fsum[m]-Fsum[0])/norm(Fsum[0]),TERM_RST);
+    }
+    printf("%s  incremental against the lengths reused: |dF|/|F| = %.3e%s\n",TERM_CLR2,norm(Fsum[2]-Fsum[1])/norm(Fsum[1]),TERM_RST);
+
+    // Reusing the lengths is off by less than Tol cells, keeping the solid fractions at rest must change nothing
+    if (norm(Fsum[1]-Fsum[0])>Tol*norm(Fsum[0]))     throw new Fatal("tlbm16: reusing the overlap lengths changes the force on the bed by %g, more than the tolerance %g",norm(Fsum[1]-Fsum[0])/norm(Fsum[0]),Tol);
+    if (norm(Fsum[2]-Fsum[1])>1.0e-10*norm(Fsum[1])) throw new Fatal("tlbm16: the incremental imprint changes the force on the bed by %g",norm(Fsum[2]-Fsum[1])/norm(Fsum[1]));
+}
+MECHSYS_CATCH